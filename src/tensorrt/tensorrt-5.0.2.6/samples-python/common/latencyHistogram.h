@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <utility>
+#include <vector>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Fixed memory histogram of latencies with a bounded relative error
+//!
+//! \details Values are counted in units of resolution ms. Below 2^precision units every unit has its own bucket, above
+//!          each power of two is split into 2^(precision - 1) buckets, so that a quantile is within 2^(1 - precision)
+//!          of the exact one whatever the magnitude. Recording is O(1) and histograms with the same configuration can
+//!          be merged, so threads can record into their own and be combined at the end.
+//!
+class LatencyHistogram
+{
+public:
+    //!
+    //! \param resolution Smallest time told apart, in ms
+    //! \param highest Largest time recorded, in ms, longer ones counting as highest
+    //! \param precision Bits kept of each value, 8 for an error below 1%
+    //!
+    explicit LatencyHistogram(double resolution = 1e-3, double highest = 3.6e6, int precision = 8)
+        : mResolution(resolution)
+        , mPrecision(precision)
+        , mHighest(static_cast<uint64_t>(highest / resolution))
+    {
+        mCounts.resize(bucketIndex(mHighest) + 1, 0);
+    }
+
+    void record(float ms)
+    {
+        const double units = std::max(0.0, std::round(ms / mResolution));
+        ++mCounts[bucketIndex(units >= mHighest ? mHighest : static_cast<uint64_t>(units))];
+        ++mCount;
+        mSum += ms;
+        mMin = std::min(mMin, ms);
+        mMax = std::max(mMax, ms);
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        assert(other.mCounts.size() == mCounts.size() && other.mResolution == mResolution);
+        for (size_t b = 0; b < mCounts.size(); ++b)
+        {
+            mCounts[b] += other.mCounts[b];
+        }
+        mCount += other.mCount;
+        mSum += other.mSum;
+        mMin = std::min(mMin, other.mMin);
+        mMax = std::max(mMax, other.mMax);
+    }
+
+    void reset()
+    {
+        std::fill(mCounts.begin(), mCounts.end(), 0);
+        mCount = 0;
+        mSum = 0;
+        mMin = std::numeric_limits<float>::max();
+        mMax = 0;
+    }
+
+    uint64_t getCount() const { return mCount; }
+
+    float getMin() const { return mCount ? mMin : 0.F; }
+
+    float getMax() const { return mMax; }
+
+    float getMean() const { return mCount ? static_cast<float>(mSum / mCount) : 0.F; }
+
+    //!
+    //! \brief Time below which percentage % of the values fall, 0 if the histogram is empty
+    //!
+    //! \details The upper bound of the bucket holding the value of that rank is returned, clamped to the values seen,
+    //!          so that 100 gives the exact maximum.
+    //!
+    float getPercentile(float percentage) const
+    {
+        if (mCount == 0)
+        {
+            return 0.F;
+        }
+        const double fraction = std::min(std::max(percentage / 100.0, 0.0), 1.0);
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * mCount)));
+        uint64_t seen{0};
+        for (size_t b = 0; b < mCounts.size(); ++b)
+        {
+            seen += mCounts[b];
+            if (seen >= rank)
+            {
+                const float upper = static_cast<float>(bucketUpperBound(b) * mResolution);
+                return std::min(std::max(upper, mMin), mMax);
+            }
+        }
+        return mMax;
+    }
+
+private:
+    //!
+    //! \brief Index of the leading one of v, which must not be 0
+    //!
+    static int log2(uint64_t v)
+    {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index{0};
+        _BitScanReverse64(&index, v);
+        return static_cast<int>(index);
+#else
+        int index{0};
+        while (v >>= 1)
+        {
+            ++index;
+        }
+        return index;
+#endif
+    }
+
+    size_t bucketIndex(uint64_t units) const
+    {
+        const uint64_t linear = uint64_t{1} << mPrecision;
+        if (units < linear)
+        {
+            return static_cast<size_t>(units);
+        }
+        // Keep the precision top bits: the leading one selects the power of two, the others the bucket within it
+        const int shift = log2(units) - mPrecision + 1;
+        const uint64_t half = linear >> 1;
+        return static_cast<size_t>(linear + (shift - 1) * half + ((units >> shift) - half));
+    }
+
+    uint64_t bucketUpperBound(size_t index) const
+    {
+        const uint64_t linear = uint64_t{1} << mPrecision;
+        if (index < linear)
+        {
+            return index;
+        }
+        const uint64_t half = linear >> 1;
+        const int shift = static_cast<int>((index - linear) / half) + 1;
+        const uint64_t mantissa = half + (index - linear) % half;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    double mResolution{0};
+    int mPrecision{0};
+    uint64_t mHighest{0};
+    std::vector<uint64_t> mCounts;
+    uint64_t mCount{0};
+    double mSum{0};
+    float mMin{std::numeric_limits<float>::max()};
+    float mMax{0};
+};
+
+//!
+//! \brief Latency histogram over the last window ms of a run
+//!
+//! \details The window is split into slices, each with its own histogram. Slices older than the window are dropped as
+//!          time goes by, so the window slides by one slice at a time with memory bounded by the number of slices.
+//!
+class SlidingLatencyHistogram
+{
+public:
+    //!
+    //! \param window Length of the window, in ms
+    //! \param slices Number of steps the window slides by over its length
+    //!
+    SlidingLatencyHistogram(double window, int slices = 10, const LatencyHistogram& prototype = LatencyHistogram())
+        : mSlice(window / std::max(slices, 1))
+        , mNbSlices(std::max(slices, 1))
+        , mPrototype(prototype)
+    {
+        mPrototype.reset();
+    }
+
+    //!
+    //! \brief Record a latency observed at time now, in ms. Times must not go backwards by more than a slice.
+    //!
+    void record(double now, float ms)
+    {
+        const int64_t slice = static_cast<int64_t>(now / mSlice);
+        if (mSlices.empty() || slice > mSlices.back().first)
+        {
+            mSlices.emplace_back(slice, mPrototype);
+        }
+        while (mSlices.front().first <= slice - mNbSlices)
+        {
+            mSlices.pop_front();
+        }
+        mSlices.back().second.record(ms);
+    }
+
+    //!
+    //! \brief Histogram of the latencies recorded in the window ending at time now
+    //!
+    LatencyHistogram getWindow(double now) const
+    {
+        LatencyHistogram window(mPrototype);
+        const int64_t first = static_cast<int64_t>(now / mSlice) - mNbSlices + 1;
+        for (const auto& s : mSlices)
+        {
+            if (s.first >= first)
+            {
+                window.merge(s.second);
+            }
+        }
+        return window;
+    }
+
+private:
+    double mSlice{0};
+    int mNbSlices{0};
+    LatencyHistogram mPrototype;
+    std::deque<std::pair<int64_t, LatencyHistogram>> mSlices; //!< Index of each slice, from the oldest to the newest
+};
+
+} // namespace samplesCommon
+
+#endif // LATENCY_HISTOGRAM_H
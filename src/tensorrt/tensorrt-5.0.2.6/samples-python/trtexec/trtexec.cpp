@@ -24,7 +24,10 @@
 #include "NvInferPlugin.h"
 #include "NvUffParser.h"
 
+#include "calibrationTable.h"
 #include "common.h"
+#include "latencyHistogram.h"
+#include "mappedFile.h"
 
 using namespace nvinfer1;
 using namespace nvcaffeparser1;
@@ -78,18 +81,6 @@ std::vector<std::string> split(const std::string& s, char delim)
     return res;
 }
 
-float percentile(float percentage, std::vector<float>& times)
-{
-    int all = static_cast<int>(times.size());
-    int exclude = static_cast<int>((1 - percentage / 100) * all);
-    if (0 <= exclude && exclude <= all)
-    {
-        std::sort(times.begin(), times.end());
-        return times[all == exclude ? 0 : all - 1 - exclude];
-    }
-    return std::numeric_limits<float>::infinity();
-}
-
 // Logger for TensorRT info/warning/errors
 class iLogger : public ILogger
 {
@@ -152,12 +143,7 @@ public:
 
     const void* readCalibrationCache(size_t& length) override
     {
-        mCalibrationCache.clear();
-        std::ifstream input(mCacheFile, std::ios::binary);
-        input >> std::noskipws;
-        if (input.good())
-            std::copy(std::istream_iterator<char>(input), std::istream_iterator<char>(), std::back_inserter(mCalibrationCache));
-
+        samplesCommon::readFile(mCacheFile, mCalibrationCache);
         length = mCalibrationCache.size();
         return length ? &mCalibrationCache[0] : nullptr;
     }
@@ -399,10 +385,11 @@ void doInference(ICudaEngine& engine)
     CHECK(cudaEventCreateWithFlags(&start, cudaEventBlockingSync));
     CHECK(cudaEventCreateWithFlags(&end, cudaEventBlockingSync));
 
-    std::vector<float> times(gParams.avgRuns);
+    samplesCommon::LatencyHistogram times, totalTimes, totalHostTimes;
     for (int j = 0; j < gParams.iterations; j++)
     {
         float totalGpu{0}, totalHost{0}; // GPU and Host timers
+        times.reset();
         for (int i = 0; i < gParams.avgRuns; i++)
         {
             auto tStart = std::chrono::high_resolution_clock::now();
@@ -412,17 +399,25 @@ void doInference(ICudaEngine& engine)
             cudaEventSynchronize(end);
 
             auto tEnd = std::chrono::high_resolution_clock::now();
-            totalHost += std::chrono::duration<float, std::milli>(tEnd - tStart).count();
+            float hostMs = std::chrono::duration<float, std::milli>(tEnd - tStart).count();
+            totalHost += hostMs;
+            totalHostTimes.record(hostMs);
             float ms;
             cudaEventElapsedTime(&ms, start, end);
-            times[i] = ms;
+            times.record(ms);
+            totalTimes.record(ms);
             totalGpu += ms;
         }
         totalGpu /= gParams.avgRuns;
         totalHost /= gParams.avgRuns;
         std::cout << "Average over " << gParams.avgRuns << " runs is " << totalGpu << " ms (host walltime is " << totalHost
-                  << " ms, " << static_cast<int>(gParams.pct) << "\% percentile time is " << percentile(gParams.pct, times) << ")." << std::endl;
+                  << " ms, " << static_cast<int>(gParams.pct) << "\% percentile time is " << times.getPercentile(gParams.pct) << ")." << std::endl;
     }
+    std::cout << "Over all " << totalTimes.getCount() << " runs: median " << totalTimes.getPercentile(50) << " ms, p90 "
+              << totalTimes.getPercentile(90) << " ms, p99 " << totalTimes.getPercentile(99) << " ms, p99.9 "
+              << totalTimes.getPercentile(99.9f) << " ms, max " << totalTimes.getMax() << " ms (host walltime median "
+              << totalHostTimes.getPercentile(50) << " ms, p99 " << totalHostTimes.getPercentile(99) << " ms, max "
+              << totalHostTimes.getMax() << " ms)." << std::endl;
 
     cudaStreamDestroy(stream);
     cudaEventDestroy(start);
@@ -639,17 +634,13 @@ static ICudaEngine* createEngine()
     // load directly from serialized engine file if deploy not specified
     if (!gParams.engine.empty())
     {
-        std::vector<char> trtModelStream;
-        size_t size{0};
-        std::ifstream file(gParams.engine, std::ios::binary);
-        if (file.good())
+        // Deserialize from a mapping of the plan rather than a heap copy of it
+        auto tStart = std::chrono::high_resolution_clock::now();
+        samplesCommon::MappedFile plan;
+        if (!plan.open(gParams.engine, samplesCommon::MappedFile::Advice::kSEQUENTIAL))
         {
-            file.seekg(0, file.end);
-            size = file.tellg();
-            file.seekg(0, file.beg);
-            trtModelStream.resize(size);
-            file.read(trtModelStream.data(), size);
-            file.close();
+            std::cerr << "could not open plan file " << gParams.engine << std::endl;
+            return nullptr;
         }
 
         IRuntime* infer = createInferRuntime(gLogger);
@@ -658,7 +649,12 @@ static ICudaEngine* createEngine()
             infer->setDLACore(gParams.useDLACore);
         }
 
-        engine = infer->deserializeCudaEngine(trtModelStream.data(), size, nullptr);
+        engine = infer->deserializeCudaEngine(plan.data(), plan.size(), nullptr);
+        const size_t size = plan.size();
+        plan.close();
+        auto tEnd = std::chrono::high_resolution_clock::now();
+        std::cout << "Engine deserialized in " << std::chrono::duration<float, std::milli>(tEnd - tStart).count()
+                  << " ms from " << (size >> 20) << " MB" << std::endl;
 
         if (gParams.inputs.empty())
         {
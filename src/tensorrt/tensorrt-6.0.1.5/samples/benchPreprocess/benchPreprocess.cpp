@@ -0,0 +1,192 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "imagePreprocess.h"
+#include "logger.h"
+#include "sampleOptions.h"
+
+using namespace sample;
+using namespace samplesCommon;
+
+namespace
+{
+
+struct BenchOptions
+{
+    int batch{8};
+    int height{300};
+    int width{300};
+    int iterations{20};
+    int threads{0};
+};
+
+//!
+//! \brief The loop the samples used before, reading the image with a stride of C for each output channel.
+//!
+void referencePreprocess(const std::vector<const uint8_t*>& images, int height, int width, float* dst,
+    const ImagePreprocessParams& p)
+{
+    const int inputC = p.channels;
+    for (int i = 0, volImg = inputC * height * width; i < static_cast<int>(images.size()); ++i)
+    {
+        for (int c = 0; c < inputC; ++c)
+        {
+            for (int j = 0, volChl = height * width; j < volChl; ++j)
+            {
+                const float pixel = float(images[i][j * inputC + p.channelOrder[c]]);
+                dst[i * volImg + c * volChl + j] = p.scale[c] * pixel + p.bias[c];
+            }
+        }
+    }
+}
+
+template <typename F>
+double timeMs(int iterations, F fn)
+{
+    fn();
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+void report(const std::string& name, double ms, double referenceMs, const BenchOptions& options, float maxDiff)
+{
+    const double mpixels = static_cast<double>(options.batch) * options.height * options.width / 1e6;
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << ms << " ms" << std::setw(10) << std::setprecision(1) << mpixels / ms * 1e3
+              << " Mpixel/s" << std::setw(8) << std::setprecision(2) << referenceMs / ms << "x"
+              << "   max diff " << std::scientific << maxDiff << std::defaultfloat << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    Arguments args = argsToArgumentsMap(argc, argv);
+    checkEraseOption(args, "--batch", options.batch);
+    checkEraseOption(args, "--height", options.height);
+    checkEraseOption(args, "--width", options.width);
+    checkEraseOption(args, "--iterations", options.iterations);
+    checkEraseOption(args, "--threads", options.threads);
+    if (!args.empty())
+    {
+        std::cout << "Usage: bench_preprocess [--batch=N] [--height=N] [--width=N] [--iterations=N] [--threads=N]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The preprocessing of sampleFasterRCNN: BGR swap and mean subtraction.
+    ImagePreprocessParams params;
+    params.swapRB();
+    params.setMeanScale({102.9801f, 115.9465f, 122.7717f}, 1.0f);
+
+    const size_t imageSize = static_cast<size_t>(options.height) * options.width * params.channels;
+    std::vector<uint8_t> pixels(imageSize * options.batch);
+    std::mt19937 generator(0);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    std::generate(pixels.begin(), pixels.end(), [&] { return static_cast<uint8_t>(distribution(generator)); });
+    std::vector<const uint8_t*> images;
+    for (int i = 0; i < options.batch; ++i)
+    {
+        images.push_back(pixels.data() + i * imageSize);
+    }
+
+    std::vector<float> expected(imageSize * options.batch);
+    std::vector<float> output(imageSize * options.batch);
+    const double referenceMs = timeMs(options.iterations,
+        [&] { referencePreprocess(images, options.height, options.width, expected.data(), params); });
+
+    const int nbWorkers = options.threads > 0 ? options.threads : getNbWorkers();
+    std::cout << options.batch << " x " << options.height << "x" << options.width << " images" << std::endl;
+    report("reference", referenceMs, referenceMs, options, 0.F);
+
+    for (auto isa : {PreprocessIsa::kSCALAR, PreprocessIsa::kSSE41, PreprocessIsa::kAVX2, PreprocessIsa::kNEON})
+    {
+        if (!isPreprocessIsaSupported(isa))
+        {
+            continue;
+        }
+        params.isa = isa;
+        std::vector<int> threadCounts{1};
+        if (nbWorkers > 1)
+        {
+            threadCounts.push_back(nbWorkers);
+        }
+        for (int threads : threadCounts)
+        {
+            std::fill(output.begin(), output.end(), 0.F);
+            const double ms = timeMs(options.iterations, [&] {
+                preprocessHWCBatch(images, options.height, options.width, 0, output.data(), params, threads);
+            });
+            float maxDiff{0.F};
+            for (size_t i = 0; i < output.size(); ++i)
+            {
+                maxDiff = std::max(maxDiff, std::abs(output[i] - expected[i]));
+            }
+            report(std::string(preprocessIsaToString(isa)) + ", " + std::to_string(threads) + " thread(s)", ms,
+                referenceMs, options, maxDiff);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
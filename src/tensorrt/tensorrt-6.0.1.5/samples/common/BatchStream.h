@@ -18,9 +18,23 @@
 
 #include "NvInfer.h"
 #include "common.h"
+#include "half.h"
+#include "imageFile.h"
+#include "imagePreprocess.h"
+#include "mappedFile.h"
+#include "packedDataset.h"
+#include "parallelFor.h"
 #include <algorithm>
+#include <array>
 #include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <stdio.h>
+#include <thread>
 #include <vector>
 
 class IBatchStream
@@ -37,17 +51,53 @@ public:
     virtual nvinfer1::Dims getImageDims() const = 0;
 };
 
+//!
+//! \brief Element type of the batches returned by MNISTBatchStream::getBatchData().
+//!
+enum class BatchDataType
+{
+    kFLOAT, //!< Normalized 32-bit floats
+    kHALF,  //!< Normalized 16-bit floats
+    kUINT8  //!< Raw 8-bit pixels, without normalization
+};
+
+inline size_t getBatchDataTypeSize(BatchDataType type)
+{
+    switch (type)
+    {
+    case BatchDataType::kFLOAT: return sizeof(float);
+    case BatchDataType::kHALF: return sizeof(half_float::half);
+    case BatchDataType::kUINT8: return sizeof(uint8_t);
+    }
+    return 0;
+}
+
+//!
+//! \brief Batch stream over the MNIST idx files.
+//!
+//! \details Images are kept in their original 8-bit form, either read into host memory or, if mapFiles is set,
+//!          memory mapped so that only the pages of the batches actually used are ever read from disk.
+//!          Only the current batch is converted to the requested output type, into a buffer reused across batches.
+//!
 class MNISTBatchStream : public IBatchStream
 {
 public:
     MNISTBatchStream(int batchSize, int maxBatches, const std::string& dataFile, const std::string& labelsFile,
-        const std::vector<std::string>& directories)
+        const std::vector<std::string>& directories, bool mapFiles = false,
+        BatchDataType dataType = BatchDataType::kFLOAT)
         : mBatchSize{batchSize}
         , mMaxBatches{maxBatches}
         , mDims{3, 1, 28, 28} //!< We already know the dimensions of MNIST images.
+        , mDataType{dataType}
     {
-        readDataFile(locateFile(dataFile, directories));
-        readLabelsFile(locateFile(labelsFile, directories));
+        readDataFile(locateFile(dataFile, directories), mapFiles);
+        readLabelsFile(locateFile(labelsFile, directories), mapFiles);
+        mBatch.resize(mBatchSize * samplesCommon::volume(mDims));
+        mLabels.resize(mBatchSize);
+        if (mDataType == BatchDataType::kHALF)
+        {
+            mHalfBatch.resize(mBatch.size());
+        }
     }
 
     void reset(int firstBatch) override
@@ -72,12 +122,74 @@ public:
 
     float* getBatch() override
     {
-        return mData.data() + (mBatchCount * mBatchSize * samplesCommon::volume(mDims));
+        if (mBatchIndex != mBatchCount)
+        {
+            convertBatch(mBatch.data(), floatTable());
+            mBatchIndex = mBatchCount;
+        }
+        return mBatch.data();
+    }
+
+    //!
+    //! \brief Returns the current batch in the type selected at construction.
+    //!
+    //! \details For kUINT8 the returned pointer refers directly to the image file data whenever the batch is complete.
+    //!          The pointer is valid until the next call that changes the current batch.
+    //!
+    const void* getBatchData()
+    {
+        switch (mDataType)
+        {
+        case BatchDataType::kFLOAT: return getBatch();
+        case BatchDataType::kHALF:
+        {
+            if (mHalfBatchIndex != mBatchCount)
+            {
+                convertBatch(mHalfBatch.data(), halfTable());
+                mHalfBatchIndex = mBatchCount;
+            }
+            return mHalfBatch.data();
+        }
+        case BatchDataType::kUINT8:
+        {
+            const int64_t imageSize = samplesCommon::volume(mDims);
+            const int64_t first = static_cast<int64_t>(mBatchCount) * mBatchSize;
+            if (first + mBatchSize <= mNbImages)
+            {
+                return getImages() + first * imageSize;
+            }
+            mByteBatch.assign(mBatchSize * imageSize, 0);
+            if (first < mNbImages)
+            {
+                std::copy_n(getImages() + first * imageSize, (mNbImages - first) * imageSize, mByteBatch.data());
+            }
+            return mByteBatch.data();
+        }
+        }
+        return nullptr;
+    }
+
+    BatchDataType getDataType() const
+    {
+        return mDataType;
     }
 
     float* getLabels() override
     {
-        return mLabels.data() + (mBatchCount * mBatchSize);
+        if (mLabelsIndex != mBatchCount)
+        {
+            const int64_t first = static_cast<int64_t>(mBatchCount) * mBatchSize;
+            const int64_t count = std::max<int64_t>(0, std::min<int64_t>(mBatchSize, mNbImages - first));
+            if (count > 0)
+            {
+                const uint8_t* labels = getRawLabels() + first;
+                std::transform(
+                    labels, labels + count, mLabels.begin(), [](uint8_t val) { return static_cast<float>(val); });
+            }
+            std::fill(mLabels.begin() + count, mLabels.end(), 0.F);
+            mLabelsIndex = mBatchCount;
+        }
+        return mLabels.data();
     }
 
     int getBatchesRead() const override
@@ -101,59 +213,212 @@ public:
     }
 
 private:
-    void readDataFile(const std::string& dataFilePath)
+    static constexpr size_t kIMAGES_HEADER_SIZE{16};
+    static constexpr size_t kLABELS_HEADER_SIZE{8};
+
+    //! There are only 256 possible pixel values, so the normalization is a table lookup.
+    static const std::array<float, 256>& floatTable()
     {
-        std::ifstream file{dataFilePath.c_str(), std::ios::binary};
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> t;
+            for (int i = 0; i < 256; ++i)
+            {
+                t[i] = static_cast<float>(i) / 255.f;
+            }
+            return t;
+        }();
+        return table;
+    }
 
-        int magicNumber, numImages, imageH, imageW;
-        file.read(reinterpret_cast<char*>(&magicNumber), sizeof(magicNumber));
-        // All values in the MNIST files are big endian.
-        magicNumber = samplesCommon::swapEndianness(magicNumber);
-        assert(magicNumber == 2051 && "Magic Number does not match the expected value for an MNIST image set");
+    static const std::array<half_float::half, 256>& halfTable()
+    {
+        static const std::array<half_float::half, 256> table = [] {
+            std::array<half_float::half, 256> t;
+            for (int i = 0; i < 256; ++i)
+            {
+                t[i] = half_float::half(floatTable()[i]);
+            }
+            return t;
+        }();
+        return table;
+    }
 
-        // Read number of images and dimensions
-        file.read(reinterpret_cast<char*>(&numImages), sizeof(numImages));
-        file.read(reinterpret_cast<char*>(&imageH), sizeof(imageH));
-        file.read(reinterpret_cast<char*>(&imageW), sizeof(imageW));
+    //! Convert the images of the current batch, zero filling the images past the end of the data set.
+    template <typename T>
+    void convertBatch(T* dst, const std::array<T, 256>& table)
+    {
+        const int64_t imageSize = samplesCommon::volume(mDims);
+        const int64_t first = static_cast<int64_t>(mBatchCount) * mBatchSize;
+        const int64_t count = std::max<int64_t>(0, std::min<int64_t>(mBatchSize, mNbImages - first)) * imageSize;
+        if (count > 0)
+        {
+            const uint8_t* src = getImages() + first * imageSize;
+            for (int64_t i = 0; i < count; ++i)
+            {
+                dst[i] = table[src[i]];
+            }
+        }
+        std::fill(dst + count, dst + mBatchSize * imageSize, T(0.F));
+    }
 
-        numImages = samplesCommon::swapEndianness(numImages);
-        imageH = samplesCommon::swapEndianness(imageH);
-        imageW = samplesCommon::swapEndianness(imageW);
+    const uint8_t* getImages() const
+    {
+        return mDataFile ? mDataFile->data() + kIMAGES_HEADER_SIZE : mRawData.data();
+    }
 
-        // The MNIST data is made up of unsigned bytes, so we need to cast to float and normalize.
-        int numElements = numImages * imageH * imageW;
-        std::vector<uint8_t> rawData(numElements);
-        file.read(reinterpret_cast<char*>(rawData.data()), numElements * sizeof(uint8_t));
-        mData.resize(numElements);
-        std::transform(
-            rawData.begin(), rawData.end(), mData.begin(), [](uint8_t val) { return static_cast<float>(val) / 255.f; });
+    const uint8_t* getRawLabels() const
+    {
+        return mLabelsFile ? mLabelsFile->data() + kLABELS_HEADER_SIZE : mRawLabels.data();
     }
 
-    void readLabelsFile(const std::string& labelsFilePath)
+    static int readHeaderValue(const uint8_t* header, int index)
     {
-        std::ifstream file{labelsFilePath.c_str(), std::ios::binary};
-        int magicNumber, numImages;
-        file.read(reinterpret_cast<char*>(&magicNumber), sizeof(magicNumber));
+        int value;
+        std::memcpy(&value, header + index * sizeof(int), sizeof(int));
         // All values in the MNIST files are big endian.
-        magicNumber = samplesCommon::swapEndianness(magicNumber);
-        assert(magicNumber == 2049 && "Magic Number does not match the expected value for an MNIST labels file");
+        return samplesCommon::swapEndianness(value);
+    }
+
+    //! Report an unusable MNIST file and exit, as the asserts it replaces are compiled out of release builds.
+    [[noreturn]] static void fail(const std::string& filePath, const std::string& error)
+    {
+        gLogError << "Could not read " << filePath << ": " << error << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    void readDataFile(const std::string& dataFilePath, bool mapFile)
+    {
+        uint8_t header[kIMAGES_HEADER_SIZE];
+        std::ifstream file;
+        if (mapFile)
+        {
+            mDataFile = std::make_shared<samplesCommon::MappedFile>();
+            if (!mDataFile->open(dataFilePath, samplesCommon::MappedFile::Advice::kSEQUENTIAL))
+            {
+                fail(dataFilePath, "the file could not be mapped");
+            }
+            if (mDataFile->size() < kIMAGES_HEADER_SIZE)
+            {
+                fail(dataFilePath, "the file is shorter than the header of an MNIST image set");
+            }
+            std::copy_n(mDataFile->data(), kIMAGES_HEADER_SIZE, header);
+        }
+        else
+        {
+            file.open(dataFilePath.c_str(), std::ios::binary);
+            if (!file.read(reinterpret_cast<char*>(header), kIMAGES_HEADER_SIZE))
+            {
+                fail(dataFilePath, "the header of the MNIST image set could not be read");
+            }
+        }
+
+        if (readHeaderValue(header, 0) != 2051)
+        {
+            fail(dataFilePath, "the magic number does not match the expected value for an MNIST image set");
+        }
+        mNbImages = readHeaderValue(header, 1);
+        if (mNbImages < 0 || readHeaderValue(header, 2) < 0 || readHeaderValue(header, 3) < 0)
+        {
+            fail(dataFilePath, "the header of the MNIST image set has negative dimensions");
+        }
+        // Batches are sliced with the fixed image size of mDims, so any other image size would overread the data.
+        if (readHeaderValue(header, 2) != mDims.d[2] || readHeaderValue(header, 3) != mDims.d[3])
+        {
+            fail(dataFilePath, "the images of the MNIST image set are not 28x28");
+        }
+        const size_t imageBytes = numImageBytes(header);
+        if (mDataFile)
+        {
+            if (mDataFile->size() < kIMAGES_HEADER_SIZE + imageBytes)
+            {
+                fail(dataFilePath, "the file is shorter than the images its header announces");
+            }
+        }
+        else
+        {
+            mRawData.resize(imageBytes);
+            if (!file.read(reinterpret_cast<char*>(mRawData.data()), mRawData.size()))
+            {
+                fail(dataFilePath, "the file is shorter than the images its header announces");
+            }
+        }
+    }
+
+    void readLabelsFile(const std::string& labelsFilePath, bool mapFile)
+    {
+        uint8_t header[kLABELS_HEADER_SIZE];
+        std::ifstream file;
+        if (mapFile)
+        {
+            mLabelsFile = std::make_shared<samplesCommon::MappedFile>();
+            if (!mLabelsFile->open(labelsFilePath, samplesCommon::MappedFile::Advice::kSEQUENTIAL))
+            {
+                fail(labelsFilePath, "the file could not be mapped");
+            }
+            if (mLabelsFile->size() < kLABELS_HEADER_SIZE)
+            {
+                fail(labelsFilePath, "the file is shorter than the header of an MNIST labels file");
+            }
+            std::copy_n(mLabelsFile->data(), kLABELS_HEADER_SIZE, header);
+        }
+        else
+        {
+            file.open(labelsFilePath.c_str(), std::ios::binary);
+            if (!file.read(reinterpret_cast<char*>(header), kLABELS_HEADER_SIZE))
+            {
+                fail(labelsFilePath, "the header of the MNIST labels file could not be read");
+            }
+        }
 
-        file.read(reinterpret_cast<char*>(&numImages), sizeof(numImages));
-        numImages = samplesCommon::swapEndianness(numImages);
+        if (readHeaderValue(header, 0) != 2049)
+        {
+            fail(labelsFilePath, "the magic number does not match the expected value for an MNIST labels file");
+        }
+        const int64_t nbLabels = readHeaderValue(header, 1);
+        if (nbLabels < mNbImages)
+        {
+            fail(labelsFilePath, "the file has fewer labels than the image set has images");
+        }
+        if (mLabelsFile)
+        {
+            if (mLabelsFile->size() < kLABELS_HEADER_SIZE + static_cast<size_t>(nbLabels))
+            {
+                fail(labelsFilePath, "the file is shorter than the labels its header announces");
+            }
+        }
+        else
+        {
+            mRawLabels.resize(nbLabels);
+            if (!file.read(reinterpret_cast<char*>(mRawLabels.data()), mRawLabels.size()))
+            {
+                fail(labelsFilePath, "the file is shorter than the labels its header announces");
+            }
+        }
+    }
 
-        std::vector<uint8_t> rawLabels(numImages);
-        file.read(reinterpret_cast<char*>(rawLabels.data()), numImages * sizeof(uint8_t));
-        mLabels.resize(numImages);
-        std::transform(
-            rawLabels.begin(), rawLabels.end(), mLabels.begin(), [](uint8_t val) { return static_cast<float>(val); });
+    static size_t numImageBytes(const uint8_t* header)
+    {
+        // Number of images, height and width
+        return static_cast<size_t>(readHeaderValue(header, 1)) * readHeaderValue(header, 2) * readHeaderValue(header, 3);
     }
 
     int mBatchSize{0};
     int mBatchCount{0}; //!< The batch that will be read on the next invocation of next()
     int mMaxBatches{0};
+    int64_t mNbImages{0};
     Dims mDims{};
-    std::vector<float> mData{};
-    std::vector<float> mLabels{};
+    BatchDataType mDataType{BatchDataType::kFLOAT};
+    std::shared_ptr<samplesCommon::MappedFile> mDataFile{};   //!< Mapped image set, shared by copies of the stream
+    std::shared_ptr<samplesCommon::MappedFile> mLabelsFile{}; //!< Mapped labels, shared by copies of the stream
+    std::vector<uint8_t> mRawData{};                          //!< Image set when the files are not mapped
+    std::vector<uint8_t> mRawLabels{};                        //!< Labels when the files are not mapped
+    std::vector<float> mBatch{};                              //!< Current batch as normalized floats
+    std::vector<half_float::half> mHalfBatch{};               //!< Current batch as normalized halves
+    std::vector<uint8_t> mByteBatch{};                        //!< Padded copy of an incomplete uint8 batch
+    std::vector<float> mLabels{};                             //!< Labels of the current batch
+    int mBatchIndex{-1};                                      //!< Batch currently held in mBatch
+    int mHalfBatchIndex{-1};                                  //!< Batch currently held in mHalfBatch
+    int mLabelsIndex{-1};                                     //!< Batch currently held in mLabels
 };
 
 class BatchStream : public IBatchStream
@@ -206,6 +471,7 @@ public:
         mLabels.resize(mBatchSize, 0);
         mFileBatch.resize(mDims.d[0] * mImageSize, 0);
         mFileLabels.resize(mDims.d[0], 0);
+        readListFile();
         reset(0);
     }
 
@@ -323,75 +589,589 @@ private:
         }
         else
         {
-            std::vector<std::string> fNames;
-            std::ifstream file(locateFile(mListFile, mDataDir), std::ios::binary);
-            if (!file)
+            const size_t firstImage = static_cast<size_t>(mFileCount) * mDims.d[0];
+            if (firstImage + mDims.d[0] > mImageNames.size())
             {
                 return false;
             }
 
             gLogInfo << "Batch #" << mFileCount << std::endl;
-            file.seekg(((mBatchCount * mBatchSize)) * 7);
-
-            for (int i = 1; i <= mBatchSize; i++)
+            std::vector<std::string> fNames(mDims.d[0]);
+            for (int i = 0; i < mDims.d[0]; ++i)
             {
-                std::string sName;
-                std::getline(file, sName);
-                sName = sName + ".ppm";
-                gLogInfo << "Calibrating with file " << sName << std::endl;
-                fNames.emplace_back(sName);
+                gLogInfo << "Calibrating with file " << mImageNames[firstImage + i] << std::endl;
+                fNames[i] = locateFile(mImageNames[firstImage + i], mDataDir);
             }
 
             mFileCount++;
 
-            const int imageC = 3;
-            const int imageH = 300;
-            const int imageW = 300;
-            std::vector<samplesCommon::PPM<imageC, imageH, imageW>> ppms(fNames.size());
-            for (uint32_t i = 0; i < fNames.size(); ++i)
+            // Decode and normalize the images in parallel, each worker writing its images straight into the file batch.
+            std::mutex errorMutex;
+            std::string error;
+            samplesCommon::parallelFor(0, mDims.d[0], [&](int64_t first, int64_t last) {
+                std::vector<uint8_t> pixels(mImageSize);
+                std::string err;
+                for (int64_t i = first; i < last; ++i)
+                {
+                    if (!readPPM(fNames[i], pixels.data(), err))
+                    {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        error = err;
+                        return;
+                    }
+                    normalizePPM(pixels.data(), getFileBatch() + i * mImageSize);
+                }
+            });
+            if (!error.empty())
             {
-                readPPMFile(locateFile(fNames[i], mDataDir), ppms[i]);
+                gLogError << "Could not read batch #" << mFileCount - 1 << ": " << error << std::endl;
+                return false;
             }
+        }
 
-            std::vector<float> data(samplesCommon::volume(mDims));
-            const float scale = 2.0 / 255.0;
-            const float bias = 1.0;
-            long int volChl = mDims.d[2] * mDims.d[3];
+        mFileBatchPos = 0;
+        return true;
+    }
+
+    // Index the image names of the list file once, so that a batch can be located without reading the list again.
+    void readListFile()
+    {
+        std::ifstream file(locateFile(mListFile, mDataDir));
+        std::string name;
+        while (std::getline(file, name))
+        {
+            if (!name.empty() && name.back() == '\r')
+            {
+                name.pop_back();
+            }
+            if (!name.empty())
+            {
+                mImageNames.emplace_back(name + ".ppm");
+            }
+        }
+    }
+
+    // Read a binary PPM image whose dimensions match the image dimensions of the stream.
+    bool readPPM(const std::string& fileName, uint8_t* pixels, std::string& err) const
+    {
+        samplesCommon::ImageInfo info;
+        if (!samplesCommon::readImage(fileName, info, pixels, mImageSize, err))
+        {
+            return false;
+        }
+        if (info.c != mDims.d[1] || info.h != mDims.d[2] || info.w != mDims.d[3])
+        {
+            err = fileName + " is not a " + std::to_string(mDims.d[3]) + "x" + std::to_string(mDims.d[2]) + " image";
+            return false;
+        }
+        return true;
+    }
+
+    // Convert an HWC image to CHW floats in [-1, 1].
+    void normalizePPM(const uint8_t* pixels, float* data) const
+    {
+        samplesCommon::ImagePreprocessParams params;
+        params.channels = mDims.d[1];
+        params.scale.fill(2.0 / 255.0);
+        params.bias.fill(-1.F);
+        // Images are already decoded in parallel, one per worker.
+        samplesCommon::preprocessHWC(pixels, mDims.d[2], mDims.d[3], 0, data, params, 1);
+    }
+
+    int mBatchSize{0};
+    int mMaxBatches{0};
+    int mBatchCount{0};
+    int mFileCount{0};
+    int mFileBatchPos{0};
+    int mImageSize{0};
+    std::vector<float> mBatch;            //!< Data for the batch
+    std::vector<float> mLabels;           //!< Labels for the batch
+    std::vector<float> mFileBatch;        //!< List of image files
+    std::vector<float> mFileLabels;       //!< List of label files
+    std::string mPrefix;                  //!< Batch file name prefix
+    std::string mSuffix;                  //!< Batch file name suffix
+    nvinfer1::Dims mDims;                 //!< Input dimensions
+    std::string mListFile;                //!< File name of the list of image names
+    std::vector<std::string> mImageNames; //!< Image file names read from the list file
+    std::vector<std::string> mDataDir;    //!< Directories where the files can be found
+};
+
+//!
+//! \brief Batch stream over a packed dataset file, see packedDataset.h.
+//!
+//! \details The file is memory mapped and its sample index gives random access to every batch, so reset() and
+//!          skip() are O(1) whatever the batch size. Samples stored as uint8 are converted to floats with the
+//!          per-channel scale and bias recorded in the file. Copies of the stream share the mapping.
+//!          A file that cannot be opened leaves the stream empty, callers test isValid() after construction.
+//!
+class PackedBatchStream : public IBatchStream
+{
+public:
+    PackedBatchStream(
+        int batchSize, int maxBatches, const std::string& fileName, const std::vector<std::string>& directories)
+        : mBatchSize(batchSize)
+        , mMaxBatches(maxBatches)
+        , mDataset(std::make_shared<samplesCommon::PackedDataset>())
+    {
+        if (!mDataset->open(locateFile(fileName, directories), mError))
+        {
+            return;
+        }
+        const auto& header = mDataset->getHeader();
+        mDims = Dims4{mBatchSize, header.dims[0], header.dims[1], header.dims[2]};
+        mImageSize = mDataset->getSampleVolume();
+        for (int c = 0; c < header.dims[0]; ++c)
+        {
+            mScales.push_back(mDataset->getScale(c));
+            mBiases.push_back(mDataset->getBias(c));
+        }
+        mBatch.resize(mBatchSize * mImageSize);
+        mLabels.resize(mBatchSize);
+        reset(0);
+    }
+
+    //!
+    //! \brief Returns whether the packed file was opened, getError() tells why when it was not.
+    //!
+    bool isValid() const
+    {
+        return mError.empty();
+    }
+
+    const std::string& getError() const
+    {
+        return mError;
+    }
+
+    void reset(int firstBatch) override
+    {
+        mBatchCount = 0;
+        mNextSample = static_cast<int64_t>(firstBatch) * mBatchSize;
+    }
+
+    bool next() override
+    {
+        if (!isValid() || mBatchCount == mMaxBatches || mNextSample + mBatchSize > mDataset->getNbSamples())
+        {
+            return false;
+        }
 
-            // Normalize input data
-            for (int i = 0, volImg = mDims.d[1] * mDims.d[2] * mDims.d[3]; i < mBatchSize; ++i)
+        const bool isFloat = mDataset->getDataType() == samplesCommon::PackedDataType::kFLOAT;
+        const int64_t channelSize = mImageSize / mDims.d[1];
+        for (int i = 0; i < mBatchSize; ++i)
+        {
+            const uint8_t* sample = mDataset->getSample(mNextSample + i);
+            float* data = mBatch.data() + i * mImageSize;
+            if (isFloat)
+            {
+                std::memcpy(data, sample, mImageSize * sizeof(float));
+            }
+            else
             {
                 for (int c = 0; c < mDims.d[1]; ++c)
                 {
-                    for (int j = 0; j < volChl; ++j)
+                    const float scale = mScales[c];
+                    const float bias = mBiases[c];
+                    for (int64_t j = c * channelSize, end = j + channelSize; j < end; ++j)
                     {
-                        data[i * volImg + c * volChl + j] = scale * float(ppms[i].buffer[j * mDims.d[1] + c]) - bias;
+                        data[j] = scale * sample[j] + bias;
                     }
                 }
             }
-
-            std::copy_n(data.data(), mDims.d[0] * mImageSize, getFileBatch());
+            mLabels[i] = mDataset->getLabel(mNextSample + i);
         }
 
-        mFileBatchPos = 0;
+        mBatchSample = mNextSample;
+        mNextSample += mBatchSize;
+        mBatchCount++;
+        // Start reading the next batch from disk while this one is being used.
+        mDataset->prefetch(mNextSample, std::min<int64_t>(mBatchSize, mDataset->getNbSamples() - mNextSample));
         return true;
     }
 
+    void skip(int skipCount) override
+    {
+        mNextSample += static_cast<int64_t>(skipCount) * mBatchSize;
+    }
+
+    float* getBatch() override
+    {
+        return mBatch.data();
+    }
+
+    //!
+    //! \brief Returns the current batch as stored in the file, without scale and bias applied.
+    //!
+    const void* getBatchData()
+    {
+        if (getDataType() == BatchDataType::kFLOAT)
+        {
+            return mBatch.data();
+        }
+        mByteBatch.resize(mBatchSize * mImageSize);
+        for (int i = 0; i < mBatchSize; ++i)
+        {
+            std::memcpy(mByteBatch.data() + i * mImageSize, mDataset->getSample(mBatchSample + i), mImageSize);
+        }
+        return mByteBatch.data();
+    }
+
+    BatchDataType getDataType() const
+    {
+        return mDataset->getDataType() == samplesCommon::PackedDataType::kFLOAT ? BatchDataType::kFLOAT
+                                                                                 : BatchDataType::kUINT8;
+    }
+
+    float* getLabels() override
+    {
+        return mLabels.data();
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchCount;
+    }
+
+    int getBatchSize() const override
+    {
+        return mBatchSize;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return mDims;
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return Dims3{mDims.d[1], mDims.d[2], mDims.d[3]};
+    }
+
+private:
     int mBatchSize{0};
     int mMaxBatches{0};
     int mBatchCount{0};
-    int mFileCount{0};
-    int mFileBatchPos{0};
-    int mImageSize{0};
-    std::vector<float> mBatch;         //!< Data for the batch
-    std::vector<float> mLabels;        //!< Labels for the batch
-    std::vector<float> mFileBatch;     //!< List of image files
-    std::vector<float> mFileLabels;    //!< List of label files
-    std::string mPrefix;               //!< Batch file name prefix
-    std::string mSuffix;               //!< Batch file name suffix
-    nvinfer1::Dims mDims;              //!< Input dimensions
-    std::string mListFile;             //!< File name of the list of image names
-    std::vector<std::string> mDataDir; //!< Directories where the files can be found
+    int64_t mNextSample{0};  //!< First sample of the batch read by the next call to next()
+    int64_t mBatchSample{0}; //!< First sample of the current batch
+    int64_t mImageSize{0};
+    nvinfer1::Dims mDims{};
+    std::shared_ptr<samplesCommon::PackedDataset> mDataset;
+    std::vector<float> mScales;
+    std::vector<float> mBiases;
+    std::vector<float> mBatch;
+    std::vector<float> mLabels;
+    std::vector<uint8_t> mByteBatch;
+    std::string mError; //!< Why the packed file could not be opened, empty when it was
+};
+
+//!
+//! \brief Time spent on both sides of a PrefetchBatchStream.
+//!
+struct PrefetchStats
+{
+    int batches{0};   //!< Batches returned by next()
+    double waitMs{0}; //!< Time next() was blocked waiting for the prefetching thread
+    double readMs{0}; //!< Time the prefetching thread spent reading batches from the wrapped stream
+};
+
+inline std::ostream& operator<<(std::ostream& os, const PrefetchStats& stats)
+{
+    os << stats.batches << " batches, " << stats.readMs << " ms reading, " << stats.waitMs << " ms waiting";
+    return os;
+}
+
+//!
+//! \brief Batch stream decorator reading batches ahead of the consumer.
+//!
+//! \details A background thread fills a ring of depth batches from the wrapped stream, so that the disk
+//!          accesses of the wrapped stream overlap with the work done on the previous batches.
+//!          The thread starts on the first call to next() and is stopped by reset() and skip(), which are then
+//!          forwarded to the wrapped stream. Like BatchStream, skip() does not count the skipped batches as read.
+//!          It drops the batches already prefetched first, which the wrapped stream did count, so once the wrapped
+//!          stream has no batch left it is reset where it stopped and as many more batches are read from it.
+//!          Copies of a PrefetchBatchStream share the same wrapped stream and ring, and the time spent reading and
+//!          waiting is logged when the last copy is destroyed.
+//!
+template <typename TBatchStream>
+class PrefetchBatchStream : public IBatchStream
+{
+public:
+    PrefetchBatchStream(TBatchStream stream, int depth = 2)
+        : mImpl(std::make_shared<Impl>(std::move(stream), std::max(depth, 1)))
+    {
+    }
+
+    void reset(int firstBatch) override
+    {
+        mImpl->reset(firstBatch);
+    }
+
+    bool next() override
+    {
+        return mImpl->next();
+    }
+
+    void skip(int skipCount) override
+    {
+        mImpl->skip(skipCount);
+    }
+
+    float* getBatch() override
+    {
+        return mImpl->mCurrent.batch.data();
+    }
+
+    float* getLabels() override
+    {
+        return mImpl->mCurrent.labels.data();
+    }
+
+    int getBatchesRead() const override
+    {
+        return mImpl->mCurrent.batchesRead;
+    }
+
+    int getBatchSize() const override
+    {
+        return mImpl->mBatchSize;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return mImpl->mDims;
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return mImpl->mImageDims;
+    }
+
+    PrefetchStats getStats() const
+    {
+        return mImpl->getStats();
+    }
+
+private:
+    struct Slot
+    {
+        std::vector<float> batch;
+        std::vector<float> labels;
+        int batchesRead{0}; //!< Batches read by the wrapped stream once this batch was read
+    };
+
+    class Impl
+    {
+    public:
+        Impl(TBatchStream&& stream, int depth)
+            : mStream(std::move(stream))
+            , mDepth(depth)
+            , mSlots(depth)
+        {
+            mBatchSize = mStream.getBatchSize();
+            mDims = mStream.getDims();
+            mImageDims = mStream.getImageDims();
+            for (auto& slot : mSlots)
+            {
+                slot.batch.resize(mBatchSize * samplesCommon::volume(mImageDims));
+                slot.labels.resize(mBatchSize);
+            }
+            mCurrent = mSlots[0];
+            mCurrent.batchesRead = mStream.getBatchesRead();
+            mPosition = mCurrent.batchesRead;
+        }
+
+        ~Impl()
+        {
+            stop();
+            if (mStats.batches)
+            {
+                gLogInfo << "Prefetched batch stream: " << mStats << std::endl;
+            }
+        }
+
+        void reset(int firstBatch)
+        {
+            stop();
+            mHead = mTail = mFilled = 0;
+            mEnd = false;
+            mStream.reset(firstBatch);
+            mCurrent.batchesRead = mStream.getBatchesRead();
+            mPosition = firstBatch;
+            mCountOffset = 0;
+            mDropped = 0;
+            mRestarted = false;
+        }
+
+        void skip(int skipCount)
+        {
+            stop();
+            const int dropped = std::min(skipCount, mFilled);
+            if (dropped)
+            {
+                mHead = (mHead + dropped) % mDepth;
+                mFilled -= dropped;
+                for (int i = 0; i < mFilled; ++i)
+                {
+                    mSlots[(mHead + i) % mDepth].batchesRead -= dropped;
+                }
+                mCountOffset -= dropped;
+                mDropped += dropped;
+                mEnd = false;
+            }
+            if (skipCount > dropped)
+            {
+                mStream.skip(skipCount - dropped);
+                mPosition += skipCount - dropped;
+            }
+        }
+
+        bool next()
+        {
+            start();
+            const auto waitStart = std::chrono::high_resolution_clock::now();
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCanConsume.wait(lock, [this] { return mFilled > 0 || mEnd; });
+            mStats.waitMs
+                += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - waitStart).count();
+            if (!mFilled)
+            {
+                return false;
+            }
+            std::swap(mCurrent, mSlots[mHead]);
+            mHead = (mHead + 1) % mDepth;
+            --mFilled;
+            ++mStats.batches;
+            lock.unlock();
+            mCanProduce.notify_one();
+            return true;
+        }
+
+        PrefetchStats getStats()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mStats;
+        }
+
+        int mBatchSize{0};
+        nvinfer1::Dims mDims{};
+        nvinfer1::Dims mImageDims{};
+        Slot mCurrent; //!< Batch returned by the last call to next(), owned by the consumer
+
+    private:
+        void start()
+        {
+            if (!mThread.joinable() && !mEnd)
+            {
+                mThread = std::thread(&Impl::produce, this);
+            }
+        }
+
+        void stop()
+        {
+            if (mThread.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mStop = true;
+                }
+                mCanProduce.notify_all();
+                mThread.join();
+                mStop = false;
+            }
+        }
+
+        void produce()
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mCanProduce.wait(lock, [this] { return mStop || mFilled < mDepth; });
+                    if (mStop)
+                    {
+                        return;
+                    }
+                }
+
+                // The slot at mTail is free, so the consumer does not touch it until it is published.
+                Slot& slot = mSlots[mTail];
+                const auto readStart = std::chrono::high_resolution_clock::now();
+                const bool read = readNext();
+                if (read)
+                {
+                    std::copy_n(mStream.getBatch(), slot.batch.size(), slot.batch.data());
+                    std::copy_n(mStream.getLabels(), slot.labels.size(), slot.labels.data());
+                    slot.batchesRead = mStream.getBatchesRead() + mCountOffset;
+                }
+                const auto readEnd = std::chrono::high_resolution_clock::now();
+
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mStats.readMs += std::chrono::duration<double, std::milli>(readEnd - readStart).count();
+                    if (read)
+                    {
+                        mTail = (mTail + 1) % mDepth;
+                        ++mFilled;
+                    }
+                    else
+                    {
+                        mEnd = true;
+                    }
+                }
+                mCanConsume.notify_one();
+                if (!read)
+                {
+                    return;
+                }
+            }
+        }
+
+        //! Read the next batch of the wrapped stream, then the batches dropped by skip() once it has none left.
+        bool readNext()
+        {
+            if (!mRestarted && !mStream.next())
+            {
+                if (!mDropped)
+                {
+                    return false;
+                }
+                // The wrapped stream counts from 0 again once reset, so carry over the batches it counted so far.
+                mCountOffset += mStream.getBatchesRead();
+                mStream.reset(mPosition);
+                mRestarted = true;
+            }
+            if (mRestarted)
+            {
+                if (!mDropped || !mStream.next())
+                {
+                    return false;
+                }
+                --mDropped;
+            }
+            ++mPosition;
+            return true;
+        }
+
+        TBatchStream mStream;
+        int mDepth{0};
+        std::vector<Slot> mSlots; //!< Ring of prefetched batches
+        int mHead{0};             //!< Oldest prefetched batch
+        int mTail{0};             //!< Next slot to be filled by the prefetching thread
+        int mFilled{0};           //!< Number of prefetched batches
+        bool mEnd{false};         //!< The wrapped stream has no batch left
+        int mPosition{0};         //!< Batch of the data set the wrapped stream reads next
+        int mCountOffset{0};      //!< Batches read by the consumer minus those read by the wrapped stream
+        int mDropped{0};          //!< Prefetched batches dropped by skip() and not read again yet
+        bool mRestarted{false};   //!< The wrapped stream was reset to read the dropped batches
+        bool mStop{false};
+        PrefetchStats mStats;
+        std::mutex mMutex;
+        std::condition_variable mCanConsume;
+        std::condition_variable mCanProduce;
+        std::thread mThread;
+    };
+
+    std::shared_ptr<Impl> mImpl;
 };
 
 #endif
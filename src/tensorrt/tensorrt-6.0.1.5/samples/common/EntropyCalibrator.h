@@ -18,6 +18,7 @@
 #define ENTROPY_CALIBRATOR_H
 
 #include "BatchStream.h"
+#include "calibrationTable.h"
 #include "NvInfer.h"
 
 //! \class EntropyCalibratorImpl
@@ -63,11 +64,9 @@ public:
     const void* readCalibrationCache(size_t& length)
     {
         mCalibrationCache.clear();
-        std::ifstream input(mCalibrationTableName, std::ios::binary);
-        input >> std::noskipws;
-        if (mReadCache && input.good())
+        if (mReadCache)
         {
-            std::copy(std::istream_iterator<char>(input), std::istream_iterator<char>(), std::back_inserter(mCalibrationCache));
+            samplesCommon::readFile(mCalibrationTableName, mCalibrationCache);
         }
         length = mCalibrationCache.size();
         return length ? mCalibrationCache.data() : nullptr;
@@ -75,8 +74,7 @@ public:
 
     void writeCalibrationCache(const void* cache, size_t length)
     {
-        std::ofstream output(mCalibrationTableName, std::ios::binary);
-        output.write(reinterpret_cast<const char*>(cache), length);
+        samplesCommon::writeFileAtomically(mCalibrationTableName, cache, length);
     }
 
 private:
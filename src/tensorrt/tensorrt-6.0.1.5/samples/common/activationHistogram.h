@@ -0,0 +1,487 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ACTIVATION_HISTOGRAM_H
+#define ACTIVATION_HISTOGRAM_H
+
+#include "atomicFile.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samplesCommon
+{
+
+constexpr int kHISTOGRAM_BINS{2048};
+constexpr int kHISTOGRAM_QUANTIZED_BINS{128}; //!< Number of positive INT8 levels the entropy range is fitted to
+constexpr int kHISTOGRAM_MIN_RANGE_EXPONENT{-32};
+
+//!
+//! \brief Layout of a histogram file.
+//!
+//! \details A histogram file holds the activation histograms of a set of tensors, so that the statistics of shards
+//!          of a calibration set can be collected apart and merged:
+//!
+//!          HistogramFileHeader
+//!          nbTensors x {HistogramRecord, name, nbBins x uint64 count}
+//!
+//!          All values are little endian, the tensors are sorted by name. Merging sums the counts, which is exact,
+//!          so the merged histograms do not depend on how the calibration set was split.
+//!
+constexpr char kHISTOGRAM_MAGIC[8] = {'T', 'R', 'T', 'H', 'I', 'S', 'T', '\0'};
+constexpr uint32_t kHISTOGRAM_VERSION{1};
+
+struct HistogramFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t nbTensors;
+};
+
+struct HistogramRecord
+{
+    uint32_t nameLength;
+    int32_t nbBins;
+    int32_t rangeExponent;
+    float maxAbs;
+    uint64_t count;
+    uint64_t nbNonFinite;
+};
+
+//!
+//! \brief  The ActivationHistogram class accumulates the histogram of the absolute values of a tensor.
+//!
+//! \details The histogram covers [0, range) in nbBins equal bins, where nbBins and range are powers of two and range
+//!          is the smallest power of two above every value seen so far. When a larger value arrives, pairs of bins
+//!          are summed to double the range. Since the scaling is exact, the counts only depend on the values added,
+//!          not on their order or on how they were split between histograms that are merged afterwards.
+//!          Non-finite values are counted apart and left out of the ranges.
+//!
+class ActivationHistogram
+{
+public:
+    explicit ActivationHistogram(int nbBins = kHISTOGRAM_BINS)
+        : mCounts(isValidNbBins(nbBins) ? nbBins : kHISTOGRAM_BINS, 0)
+    {
+    }
+
+    static bool isValidNbBins(int nbBins)
+    {
+        return nbBins >= kHISTOGRAM_QUANTIZED_BINS && (nbBins & (nbBins - 1)) == 0;
+    }
+
+    void add(const float* values, size_t count)
+    {
+        float maxAbs = 0.F;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float a = std::fabs(values[i]);
+            if (a > maxAbs && std::isfinite(a))
+            {
+                maxAbs = a;
+            }
+        }
+        growTo(getRangeExponent(maxAbs));
+        mMaxAbs = std::max(mMaxAbs, maxAbs);
+
+        const float binsPerUnit = std::ldexp(1.F, getLog2NbBins() - mRangeExponent);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float a = std::fabs(values[i]);
+            if (std::isfinite(a))
+            {
+                ++mCounts[static_cast<size_t>(a * binsPerUnit)];
+            }
+            else
+            {
+                ++mNbNonFinite;
+            }
+        }
+        mCount += count;
+    }
+
+    //!
+    //! \brief Add the counts of other, which must have the same number of bins
+    //!
+    bool merge(const ActivationHistogram& other)
+    {
+        if (other.getNbBins() != getNbBins())
+        {
+            return false;
+        }
+        growTo(other.mRangeExponent);
+        const int shift = std::min(mRangeExponent - other.mRangeExponent, getLog2NbBins());
+        for (size_t i = 0; i < other.mCounts.size(); ++i)
+        {
+            mCounts[i >> shift] += other.mCounts[i];
+        }
+        mMaxAbs = std::max(mMaxAbs, other.mMaxAbs);
+        mCount += other.mCount;
+        mNbNonFinite += other.mNbNonFinite;
+        return true;
+    }
+
+    //!
+    //! \brief Returns the largest absolute value seen
+    //!
+    float getMaxRange() const { return mMaxAbs; }
+
+    //!
+    //! \brief Returns the upper edge of the bin holding the given percentile of the values, capped to the maximum
+    //!
+    float getPercentileRange(double percentile) const
+    {
+        const uint64_t finite = mCount - mNbNonFinite;
+        const double target = std::min(std::max(percentile, 0.0), 100.0) / 100.0 * finite;
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < mCounts.size(); ++i)
+        {
+            cumulative += mCounts[i];
+            if (cumulative >= target && cumulative > 0)
+            {
+                return std::min(getBinWidth() * (i + 1), mMaxAbs);
+            }
+        }
+        return mMaxAbs;
+    }
+
+    //!
+    //! \brief Returns the range minimizing the KL divergence between the histogram and its INT8 quantization
+    //!
+    //! \details For every candidate of i bins, values beyond the candidate are clipped into its last bin, the
+    //!          resulting distribution P is quantized to kHISTOGRAM_QUANTIZED_BINS levels and expanded back to Q,
+    //!          spreading each level evenly over the bins of P that are not empty. The range is the upper edge of the
+    //!          candidate with the smallest KL(P||Q).
+    //!
+    float getEntropyRange() const
+    {
+        const int last = getLastNonEmptyBin();
+        if (last < kHISTOGRAM_QUANTIZED_BINS)
+        {
+            return mMaxAbs;
+        }
+
+        std::vector<double> p(last + 1);
+        std::vector<double> q(last + 1);
+        double outliers = 0;
+        for (int i = last; i >= kHISTOGRAM_QUANTIZED_BINS; --i)
+        {
+            outliers += mCounts[i];
+        }
+
+        double bestDivergence = INFINITY;
+        int bestBins = last + 1;
+        for (int bins = kHISTOGRAM_QUANTIZED_BINS; bins <= last + 1; ++bins)
+        {
+            for (int i = 0; i < bins; ++i)
+            {
+                p[i] = static_cast<double>(mCounts[i]);
+            }
+            p[bins - 1] += outliers;
+            if (bins <= last)
+            {
+                outliers -= mCounts[bins];
+            }
+
+            // Quantize the unclipped bins onto the bins of P that are not empty, the last level absorbs the
+            // remainder of bins / kHISTOGRAM_QUANTIZED_BINS.
+            const int merged = bins / kHISTOGRAM_QUANTIZED_BINS;
+            for (int level = 0; level < kHISTOGRAM_QUANTIZED_BINS; ++level)
+            {
+                const int begin = level * merged;
+                const int end = level == kHISTOGRAM_QUANTIZED_BINS - 1 ? bins : begin + merged;
+                double sum = 0;
+                int nonEmpty = 0;
+                for (int i = begin; i < end; ++i)
+                {
+                    sum += mCounts[i];
+                    nonEmpty += p[i] != 0;
+                }
+                for (int i = begin; i < end; ++i)
+                {
+                    q[i] = p[i] != 0 ? sum / nonEmpty : 0.0;
+                }
+            }
+
+            const double divergence = klDivergence(p.data(), q.data(), bins);
+            if (divergence < bestDivergence)
+            {
+                bestDivergence = divergence;
+                bestBins = bins;
+            }
+        }
+        return std::min(getBinWidth() * bestBins, mMaxAbs);
+    }
+
+    int getNbBins() const { return static_cast<int>(mCounts.size()); }
+
+    //!
+    //! \brief Returns the exponent of the range, which is 2^exponent
+    //!
+    int getRangeExponent() const { return mRangeExponent; }
+
+    float getBinWidth() const { return std::ldexp(1.F, mRangeExponent - getLog2NbBins()); }
+
+    const std::vector<uint64_t>& getCounts() const { return mCounts; }
+
+    uint64_t getCount() const { return mCount; }
+
+    uint64_t getNbNonFinite() const { return mNbNonFinite; }
+
+    //!
+    //! \brief Returns true if no finite value was added, in which case every range is 0
+    //!
+    bool empty() const { return mCount == mNbNonFinite; }
+
+    //!
+    //! \brief Append the histogram of tensor name to out, in the layout of a histogram file
+    //!
+    void serialize(const std::string& name, std::string& out) const
+    {
+        const HistogramRecord record{
+            static_cast<uint32_t>(name.size()), getNbBins(), mRangeExponent, mMaxAbs, mCount, mNbNonFinite};
+        out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        out.append(name);
+        out.append(reinterpret_cast<const char*>(mCounts.data()), mCounts.size() * sizeof(uint64_t));
+    }
+
+    //!
+    //! \brief Restore the histogram from its record and the nbBins counts that follow the name
+    //!
+    //! \return false if the record is inconsistent
+    //!
+    bool deserialize(const HistogramRecord& record, const uint8_t* counts)
+    {
+        if (!isValidNbBins(record.nbBins) || record.rangeExponent < kHISTOGRAM_MIN_RANGE_EXPONENT
+            || record.rangeExponent > 128 || !(record.maxAbs >= 0.F)
+            || record.maxAbs >= std::ldexp(1.0, record.rangeExponent))
+        {
+            return false;
+        }
+        mCounts.resize(record.nbBins);
+        std::memcpy(mCounts.data(), counts, mCounts.size() * sizeof(uint64_t));
+        uint64_t total = record.nbNonFinite;
+        for (const auto c : mCounts)
+        {
+            total += c;
+        }
+        mRangeExponent = record.rangeExponent;
+        mMaxAbs = record.maxAbs;
+        mCount = record.count;
+        mNbNonFinite = record.nbNonFinite;
+        return total == mCount;
+    }
+
+private:
+    //!
+    //! \brief Returns the exponent of the smallest power of two strictly above value
+    //!
+    //! \details 0, for which frexp gives exponent 0, keeps the smallest range, so that all-zero chunks, common after
+    //!          ReLU or padding, do not widen the range of small valued tensors to [0, 1).
+    //!
+    static int getRangeExponent(float value)
+    {
+        if (value == 0.F)
+        {
+            return kHISTOGRAM_MIN_RANGE_EXPONENT;
+        }
+        int exponent{0};
+        std::frexp(value, &exponent);
+        return exponent > kHISTOGRAM_MIN_RANGE_EXPONENT ? exponent : kHISTOGRAM_MIN_RANGE_EXPONENT;
+    }
+
+    int getLog2NbBins() const
+    {
+        int log2{0};
+        while ((1 << log2) < getNbBins())
+        {
+            ++log2;
+        }
+        return log2;
+    }
+
+    int getLastNonEmptyBin() const
+    {
+        int last = getNbBins() - 1;
+        while (last >= 0 && !mCounts[last])
+        {
+            --last;
+        }
+        return last;
+    }
+
+    void growTo(int exponent)
+    {
+        if (exponent <= mRangeExponent)
+        {
+            return;
+        }
+        const int shift = std::min(exponent - mRangeExponent, getLog2NbBins());
+        for (size_t i = 0; i < mCounts.size(); ++i)
+        {
+            const uint64_t c = mCounts[i];
+            mCounts[i] = 0;
+            mCounts[i >> shift] += c;
+        }
+        mRangeExponent = exponent;
+    }
+
+    //!
+    //! \brief KL(P||Q) of the normalized distributions, bins where P has mass but Q has none are smoothed
+    //!
+    static double klDivergence(const double* p, const double* q, int n)
+    {
+        constexpr double kEPSILON = 1e-4;
+        double pSum = 0;
+        double qSum = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            pSum += p[i];
+            qSum += q[i];
+        }
+        if (pSum == 0 || qSum == 0)
+        {
+            return INFINITY;
+        }
+        double divergence = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            if (p[i] > 0)
+            {
+                const double pi = p[i] / pSum;
+                const double qi = q[i] > 0 ? q[i] / qSum : kEPSILON / qSum;
+                divergence += pi * std::log(pi / qi);
+            }
+        }
+        return divergence;
+    }
+
+    std::vector<uint64_t> mCounts;
+    int mRangeExponent{kHISTOGRAM_MIN_RANGE_EXPONENT}; //!< The histogram covers [0, 2^mRangeExponent)
+    float mMaxAbs{0.F};
+    uint64_t mCount{0};      //!< Values added, including the non-finite ones
+    uint64_t mNbNonFinite{0};
+};
+
+//!
+//! \brief Returns the [first, last) files of the shard-th of nbShards contiguous slices of nbFiles files
+//!
+//! \details Every file is in exactly one slice, and slices differ in size by one file at most. A shard gets no
+//!          file when there are fewer files than shards.
+//!
+inline std::pair<size_t, size_t> getShardSlice(size_t nbFiles, int shard, int nbShards)
+{
+    return {nbFiles * shard / nbShards, nbFiles * (shard + 1) / nbShards};
+}
+
+//!
+//! \brief Write the histograms of a set of tensors to a histogram file
+//!
+inline bool writeHistograms(
+    const std::string& fileName, const std::map<std::string, ActivationHistogram>& histograms, std::ostream& err)
+{
+    HistogramFileHeader header{};
+    std::memcpy(header.magic, kHISTOGRAM_MAGIC, sizeof(kHISTOGRAM_MAGIC));
+    header.version = kHISTOGRAM_VERSION;
+    header.nbTensors = static_cast<uint32_t>(histograms.size());
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& h : histograms)
+    {
+        h.second.serialize(h.first, out);
+    }
+    if (!writeFileAtomically(fileName, out))
+    {
+        err << "Cannot write " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//!
+//! \brief Read a histogram file and merge its histograms into histograms
+//!
+inline bool readHistograms(
+    const std::string& fileName, std::map<std::string, ActivationHistogram>& histograms, std::ostream& err)
+{
+    MappedFile file;
+    if (!file.open(fileName, MappedFile::Advice::kSEQUENTIAL))
+    {
+        err << "Cannot read " << fileName << std::endl;
+        return false;
+    }
+    HistogramFileHeader header;
+    if (file.size() < sizeof(header))
+    {
+        err << fileName << " is too small to be a histogram file" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kHISTOGRAM_MAGIC, sizeof(kHISTOGRAM_MAGIC)) || header.version != kHISTOGRAM_VERSION)
+    {
+        err << fileName << " is not a version " << kHISTOGRAM_VERSION << " histogram file" << std::endl;
+        return false;
+    }
+
+    const uint8_t* data = file.data() + sizeof(header);
+    const uint8_t* end = file.data() + file.size();
+    for (uint32_t t = 0; t < header.nbTensors; ++t)
+    {
+        HistogramRecord record;
+        if (static_cast<size_t>(end - data) < sizeof(record))
+        {
+            err << fileName << " is truncated" << std::endl;
+            return false;
+        }
+        std::memcpy(&record, data, sizeof(record));
+        data += sizeof(record);
+        if (record.nbBins < 0
+            || static_cast<uint64_t>(end - data) < record.nameLength + sizeof(uint64_t) * record.nbBins)
+        {
+            err << fileName << " is truncated" << std::endl;
+            return false;
+        }
+        const std::string name(reinterpret_cast<const char*>(data), record.nameLength);
+        data += record.nameLength;
+
+        ActivationHistogram h;
+        if (!h.deserialize(record, data))
+        {
+            err << fileName << " has an invalid histogram for " << name << std::endl;
+            return false;
+        }
+        data += sizeof(uint64_t) * record.nbBins;
+
+        const auto inserted = histograms.emplace(name, h);
+        if (!inserted.second && !inserted.first->second.merge(h))
+        {
+            err << "Cannot merge the " << h.getNbBins() << " bins of " << name << " in " << fileName << " with "
+                << inserted.first->second.getNbBins() << " bins" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace samplesCommon
+
+#endif // ACTIVATION_HISTOGRAM_H
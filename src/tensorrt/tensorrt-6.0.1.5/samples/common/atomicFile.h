@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <direct.h>
+#include <process.h>
+// Needed so that the max/min definitions in windows.h do not conflict with std::max/min.
+#define NOMINMAX
+#include <windows.h>
+#undef NOMINMAX
+#endif
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Replace fileName with size bytes of data, so that readers see either the old or the new file, never a part.
+//!
+//! \details The data is written to a temporary file next to fileName, flushed to disk and renamed over fileName.
+//!          Concurrent writers of the same file do not corrupt it; the last rename wins.
+//!
+//! \return true if fileName holds the new data.
+//!
+inline bool writeFileAtomically(const std::string& fileName, const void* data, size_t size)
+{
+    static std::atomic<unsigned> counter{0};
+#ifndef _MSC_VER
+    const std::string tmpName = fileName + ".tmp." + std::to_string(getpid()) + "." + std::to_string(counter++);
+    int fd = ::open(tmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const char* bytes = static_cast<const char*>(data);
+    bool ok = true;
+    for (size_t written = 0; ok && written < size;)
+    {
+        const ssize_t n = ::write(fd, bytes + written, size - written);
+        ok = n > 0;
+        written += ok ? static_cast<size_t>(n) : 0;
+    }
+    ok = ok && fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    ok = ok && std::rename(tmpName.c_str(), fileName.c_str()) == 0;
+#else
+    const std::string tmpName = fileName + ".tmp." + std::to_string(_getpid()) + "." + std::to_string(counter++);
+    bool ok = false;
+    {
+        std::ofstream file(tmpName, std::ios::binary | std::ios::trunc);
+        file.write(static_cast<const char*>(data), size);
+        file.flush();
+        ok = static_cast<bool>(file);
+    }
+    // rename does not replace an existing file on Windows, MoveFileEx does so atomically on the same volume
+    ok = ok && MoveFileExA(tmpName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#endif
+    if (!ok)
+    {
+        std::remove(tmpName.c_str());
+    }
+    return ok;
+}
+
+inline bool writeFileAtomically(const std::string& fileName, const std::string& contents)
+{
+    return writeFileAtomically(fileName, contents.data(), contents.size());
+}
+
+//!
+//! \brief Create directory unless it exists. Parent directories must exist.
+//!
+inline bool makeDirectory(const std::string& directory)
+{
+#ifndef _MSC_VER
+    if (mkdir(directory.c_str(), 0755) == 0)
+    {
+        return true;
+    }
+    struct stat st;
+    return stat(directory.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#else
+    return _mkdir(directory.c_str()) == 0 || errno == EEXIST;
+#endif
+}
+
+} // namespace samplesCommon
+
+#endif // ATOMIC_FILE_H
@@ -52,7 +52,9 @@
 
 #include "NvInfer.h"
 #include "half.h"
+#include "halfConvert.h"
 #include "common.h"
+#include "memoryArena.h"
 #include <cuda_runtime_api.h>
 #include <cassert>
 #include <iostream>
@@ -68,6 +70,24 @@ using namespace std;
 namespace samplesCommon
 {
 
+//!
+//! \brief Grow a buffer to exactly the requested size
+//!
+class ExactGrowth
+{
+public:
+    size_t operator()(size_t /*capacity*/, size_t requested) const { return requested; }
+};
+
+//!
+//! \brief Grow a buffer to at least twice its capacity, so that n increasing resizes cost O(log n) reallocations
+//!
+class GeometricGrowth
+{
+public:
+    size_t operator()(size_t capacity, size_t requested) const { return std::max(requested, 2 * capacity); }
+};
+
 //!
 //! \brief  The GenericBuffer class is a templated class for buffers.
 //!
@@ -82,8 +102,10 @@ namespace samplesCommon
 //!          The boolean indicates whether or not the memory allocation was successful.
 //!          FreeFunc must be a functor that takes in (void* ptr) and returns void.
 //!          ptr is the allocated buffer address. It must work with nullptr input.
+//!          GrowthPolicy must be a functor that takes in (size_t capacity, size_t requested) and returns the
+//!          capacity, in elements and at least requested, that resize allocates when the buffer has to grow.
 //!
-template <typename AllocFunc, typename FreeFunc>
+template <typename AllocFunc, typename FreeFunc, typename GrowthPolicy = ExactGrowth>
 class GenericBuffer
 {
 public:
@@ -170,20 +192,32 @@ public:
         return this->size() * samplesCommon::getElementSize(mType);
     }
 
+    //!
+    //! \brief Returns the number of elements the buffer can hold without reallocating.
+    //!
+    size_t capacity() const
+    {
+        return mCapacity;
+    }
+
     //!
     //! \brief Resizes the buffer. This is a no-op if the new size is smaller than or equal to the current capacity.
+    //!        Otherwise the contents are discarded and the new capacity is chosen by GrowthPolicy.
     //!
     void resize(size_t newSize)
     {
         mSize = newSize;
         if (mCapacity < newSize)
         {
+            const size_t newCapacity = growFn(mCapacity, newSize);
             freeFn(mBuffer);
-            if (!allocFn(&mBuffer, this->nbBytes()))
+            mBuffer = nullptr;
+            mCapacity = 0;
+            if (!allocFn(&mBuffer, newCapacity * samplesCommon::getElementSize(mType)))
             {
                 throw std::bad_alloc{};
             }
-            mCapacity = newSize;
+            mCapacity = newCapacity;
         }
     }
 
@@ -206,6 +240,7 @@ private:
     void* mBuffer;
     AllocFunc allocFn;
     FreeFunc freeFn;
+    GrowthPolicy growFn;
 };
 
 class DeviceAllocator
@@ -236,17 +271,54 @@ public:
     void operator()(void* ptr) const { free(ptr); }
 };
 
+//!
+//! \brief Page-locked host memory, which the GPU can DMA from directly so that async copies are truly async
+//!
+struct PinnedHostMemory
+{
+    static bool allocate(void** ptr, size_t size)
+    {
+        return cudaHostAlloc(ptr, size, cudaHostAllocDefault) == cudaSuccess;
+    }
+
+    static void release(void* ptr) { cudaFreeHost(ptr); }
+};
+
 using DeviceBuffer = GenericBuffer<DeviceAllocator, DeviceFree>;
 using HostBuffer = GenericBuffer<HostAllocator, HostFree>;
+//! Pinned host buffer recycled through the process wide pinned arena
+using PinnedBuffer = GenericBuffer<ArenaAllocator<PinnedHostMemory>, ArenaFree<PinnedHostMemory>, GeometricGrowth>;
+//! 64 byte aligned host buffer recycled through the process wide CPU arena
+using AlignedBuffer = GenericBuffer<ArenaAllocator<AlignedHostMemory>, ArenaFree<AlignedHostMemory>, GeometricGrowth>;
+
+//!
+//! \brief Allocation statistics of the arena behind PinnedBuffer
+//!
+inline ArenaStats getPinnedArenaStats()
+{
+    return getArena<PinnedHostMemory>().getStats();
+}
+
+//!
+//! \brief Set the bytes of idle pinned memory kept for reuse, releasing the cache if it holds more
+//!
+inline void setPinnedArenaCacheLimit(size_t bytes)
+{
+    getArena<PinnedHostMemory>().setCacheLimit(bytes);
+}
 
 //!
 //! \brief  The ManagedBuffer class groups together a pair of corresponding device and host buffers.
 //!
+//! \details The host side is pinned and comes from a shared arena, so BufferManagers living at the same time or
+//!          created while another one lives reuse the same page-locked blocks instead of paying for cudaHostAlloc
+//!          each time. The idle blocks are released when the last BufferManager is destroyed.
+//!
 class ManagedBuffer
 {
 public:
     DeviceBuffer deviceBuffer;
-    HostBuffer hostBuffer;
+    PinnedBuffer hostBuffer;
 };
 
 //!
@@ -285,8 +357,10 @@ public:
             vol *= samplesCommon::volume(dims);
             std::unique_ptr<ManagedBuffer> manBuf{new ManagedBuffer()};
             manBuf->deviceBuffer = DeviceBuffer(vol, type);
-            manBuf->hostBuffer = HostBuffer(vol, type);
+            manBuf->hostBuffer = PinnedBuffer(vol, type);
             mDeviceBindings.emplace_back(manBuf->deviceBuffer.data());
+            mHostPointers.emplace_back(manBuf->hostBuffer.data());
+            mCopyEnabled.emplace_back(true);
             mManagedBuffers.emplace_back(std::move(manBuf));
         }
     }
@@ -326,6 +400,51 @@ public:
         return mManagedBuffers[index]->hostBuffer.nbBytes();
     }
 
+    //!
+    //! \brief Use caller-owned host memory for tensorName instead of the managed host buffer.
+    //!
+    //! \details Saves the memcpy into getHostBuffer() when the data already sits in a buffer of its own, which should
+    //!          be pinned for the async copies to stay async. ptr must hold nbBytes >= size(tensorName) bytes of the
+    //!          binding's type and stay valid while in use. A nullptr restores the managed buffer.
+    //!          Returns false, changing nothing, if tensorName is unknown or the size or type do not match.
+    //!
+    bool setHostBuffer(const std::string& tensorName, void* ptr, size_t nbBytes, nvinfer1::DataType type)
+    {
+        const int index = getExternalIndex(tensorName, ptr, nbBytes, type);
+        if (index == -1)
+            return false;
+        mHostPointers[index] = ptr ? ptr : mManagedBuffers[index]->hostBuffer.data();
+        return true;
+    }
+
+    //!
+    //! \brief Use caller-owned device memory for tensorName, in the copies and in getDeviceBindings().
+    //!
+    //! \details Lets the output of one engine, or of a previous step, be bound as an input without a round trip
+    //!          through host memory. Same requirements and return value as setHostBuffer.
+    //!
+    bool setDeviceBuffer(const std::string& tensorName, void* ptr, size_t nbBytes, nvinfer1::DataType type)
+    {
+        const int index = getExternalIndex(tensorName, ptr, nbBytes, type);
+        if (index == -1)
+            return false;
+        mDeviceBindings[index] = ptr ? ptr : mManagedBuffers[index]->deviceBuffer.data();
+        return true;
+    }
+
+    //!
+    //! \brief Enable or disable the host/device copies of tensorName, e.g. for a binding only used on the device.
+    //!        Copies are also skipped when the host and device pointers are the same, as for mapped memory.
+    //!
+    bool setCopyEnabled(const std::string& tensorName, bool enabled)
+    {
+        int index = mEngine->getBindingIndex(tensorName.c_str());
+        if (index == -1)
+            return false;
+        mCopyEnabled[index] = enabled;
+        return true;
+    }
+
     //!
     //! \brief Dump host buffer with specified tensorName to ostream.
     //!        Prints error message to std::ostream if no such tensor can be found.
@@ -338,7 +457,7 @@ public:
             os << "Invalid tensor name" << std::endl;
             return;
         }
-        void* buf = mManagedBuffers[index]->hostBuffer.data();
+        void* buf = mHostPointers[index];
         size_t bufSize = mManagedBuffers[index]->hostBuffer.nbBytes();
         nvinfer1::Dims bufDims = mEngine->getBindingDimensions(index);
         size_t rowCount = static_cast<size_t>(bufDims.nbDims >= 1 ? bufDims.d[bufDims.nbDims - 1] : mBatchSize);
@@ -351,7 +470,14 @@ public:
         {
         case nvinfer1::DataType::kINT32: print<int32_t>(os, buf, bufSize, rowCount); break;
         case nvinfer1::DataType::kFLOAT: print<float>(os, buf, bufSize, rowCount); break;
-        case nvinfer1::DataType::kHALF: print<half_float::half>(os, buf, bufSize, rowCount); break;
+        case nvinfer1::DataType::kHALF:
+        {
+            // Convert the whole buffer at once rather than one element at a time while printing.
+            std::vector<float> floatBuf(bufSize / sizeof(half_float::half));
+            half_float::convert_n(static_cast<const half_float::half*>(buf), floatBuf.data(), floatBuf.size());
+            print<float>(os, floatBuf.data(), floatBuf.size() * sizeof(float), rowCount);
+            break;
+        }
         case nvinfer1::DataType::kINT8: assert(0 && "Int8 network-level input and output is not supported"); break;
         }
     }
@@ -414,17 +540,28 @@ private:
         int index = mEngine->getBindingIndex(tensorName.c_str());
         if (index == -1)
             return nullptr;
-        return (isHost ? mManagedBuffers[index]->hostBuffer.data() : mManagedBuffers[index]->deviceBuffer.data());
+        return (isHost ? mHostPointers[index] : mDeviceBindings[index]);
+    }
+
+    int getExternalIndex(const std::string& tensorName, const void* ptr, size_t nbBytes, nvinfer1::DataType type) const
+    {
+        int index = mEngine->getBindingIndex(tensorName.c_str());
+        if (index == -1)
+            return -1;
+        const size_t bindingBytes = mManagedBuffers[index]->hostBuffer.nbBytes();
+        if (ptr && (type != mEngine->getBindingDataType(index) || nbBytes < bindingBytes))
+            return -1;
+        return index;
     }
 
     void memcpyBuffers(const bool copyInput, const bool deviceToHost, const bool async, const cudaStream_t& stream = 0)
     {
         for (int i = 0; i < mEngine->getNbBindings(); i++)
         {
-            void* dstPtr
-                = deviceToHost ? mManagedBuffers[i]->hostBuffer.data() : mManagedBuffers[i]->deviceBuffer.data();
-            const void* srcPtr
-                = deviceToHost ? mManagedBuffers[i]->deviceBuffer.data() : mManagedBuffers[i]->hostBuffer.data();
+            void* dstPtr = deviceToHost ? mHostPointers[i] : mDeviceBindings[i];
+            const void* srcPtr = deviceToHost ? mDeviceBindings[i] : mHostPointers[i];
+            if (!mCopyEnabled[i] || dstPtr == srcPtr)
+                continue;
             const size_t byteSize = mManagedBuffers[i]->hostBuffer.nbBytes();
             const cudaMemcpyKind memcpyType = deviceToHost ? cudaMemcpyDeviceToHost : cudaMemcpyHostToDevice;
             if ((copyInput && mEngine->bindingIsInput(i)) || (!copyInput && !mEngine->bindingIsInput(i)))
@@ -437,10 +574,13 @@ private:
         }
     }
 
+    ArenaUser<PinnedHostMemory> mPinnedArenaUser;                //!< Declared first, so released after the buffers
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine;              //!< The pointer to the engine
     int mBatchSize;                                              //!< The batch size
     std::vector<std::unique_ptr<ManagedBuffer>> mManagedBuffers; //!< The vector of pointers to managed buffers
     std::vector<void*> mDeviceBindings;                          //!< The vector of device buffers needed for engine execution
+    std::vector<void*> mHostPointers;                            //!< Host buffer of each binding, owned or not
+    std::vector<bool> mCopyEnabled;                              //!< Whether memcpyBuffers copies each binding
 };
 
 } // namespace samplesCommon
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CALIBRATION_TABLE_H
+#define CALIBRATION_TABLE_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "atomicFile.h"
+#include "mappedFile.h"
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Read a whole file with a single mapping and copy, e.g. for IInt8Calibrator::readCalibrationCache
+//!
+//! \return false, leaving contents empty, if the file cannot be read
+//!
+inline bool readFile(const std::string& fileName, std::vector<char>& contents)
+{
+    contents.clear();
+    MappedFile file;
+    if (!file.open(fileName, MappedFile::Advice::kSEQUENTIAL))
+    {
+        return false;
+    }
+    contents.assign(file.data(), file.data() + file.size());
+    return true;
+}
+
+//!
+//! \brief  The CalibrationTable class is the name to scale map of an INT8 calibration cache.
+//!
+//! \details It reads and writes both the calibration cache written by the calibrators, a header line such as
+//!          TRT-6001-EntropyCalibration2 followed by "name: scale" lines with the scale as the hex bits of a float,
+//!          and the per tensor dynamic range files of sampleINT8API, "name:range" lines with the range in decimal,
+//!          where range = 127 * scale. Entries are kept sorted by name so that the files written are deterministic.
+//!          Tensor names may contain ':', only the last one on a line is a separator. The ranges read or set are
+//!          kept along with their scales, so that a dynamic range file is written back exactly as it was read.
+//!
+class CalibrationTable
+{
+public:
+    //!
+    //! \brief How merge resolves a tensor present in both tables
+    //!
+    enum class MergePolicy
+    {
+        kOVERRIDE, //!< Take the other table's scale
+        kKEEP,     //!< Keep this table's scale
+        kMAX       //!< Take the larger scale, so that the range covers both
+    };
+
+    static constexpr float kINT8_MAX = 127.0F;
+
+    CalibrationTable() = default;
+
+    explicit CalibrationTable(const std::string& header)
+        : mHeader(header)
+    {
+    }
+
+    //!
+    //! \brief Parse a calibration cache, replacing the contents of the table
+    //!
+    bool parseCache(const char* data, size_t size, std::ostream& err)
+    {
+        clear();
+        bool first = true;
+        return forEachLine(data, size, [&](const char* line, size_t length) {
+            const char* colon = findLastColon(line, length);
+            if (first && !colon)
+            {
+                mHeader.assign(line, length);
+                first = false;
+                return true;
+            }
+            first = false;
+            if (!colon)
+            {
+                err << "Malformed calibration cache line: " << std::string(line, length) << std::endl;
+                return false;
+            }
+            const std::string hex = trim(colon + 1, line + length);
+            char* end{nullptr};
+            const unsigned long bits = std::strtoul(hex.c_str(), &end, 16);
+            if (hex.empty() || *end != '\0' || bits > 0xFFFFFFFFUL)
+            {
+                err << "Malformed calibration scale: " << std::string(line, length) << std::endl;
+                return false;
+            }
+            mScales[trim(line, colon)] = bitsToFloat(static_cast<uint32_t>(bits));
+            return true;
+        });
+    }
+
+    //!
+    //! \brief Parse a per tensor dynamic range file, replacing the contents of the table. The header is kept.
+    //!
+    bool parseDynamicRanges(const char* data, size_t size, std::ostream& err)
+    {
+        mScales.clear();
+        mRanges.clear();
+        return forEachLine(data, size, [&](const char* line, size_t length) {
+            const char* colon = findLastColon(line, length);
+            const std::string value = colon ? trim(colon + 1, line + length) : std::string();
+            char* end{nullptr};
+            const float range = value.empty() ? 0.0F : std::strtof(value.c_str(), &end);
+            if (value.empty() || *end != '\0' || !(range >= 0.0F))
+            {
+                err << "Malformed dynamic range line: " << std::string(line, length) << std::endl;
+                return false;
+            }
+            setDynamicRange(trim(line, colon), range);
+            return true;
+        });
+    }
+
+    bool readCache(const std::string& fileName, std::ostream& err)
+    {
+        MappedFile file;
+        if (!file.open(fileName, MappedFile::Advice::kSEQUENTIAL))
+        {
+            err << "Cannot read calibration cache " << fileName << std::endl;
+            return false;
+        }
+        return parseCache(reinterpret_cast<const char*>(file.data()), file.size(), err);
+    }
+
+    bool readDynamicRanges(const std::string& fileName, std::ostream& err)
+    {
+        MappedFile file;
+        if (!file.open(fileName, MappedFile::Advice::kSEQUENTIAL))
+        {
+            err << "Cannot read dynamic range file " << fileName << std::endl;
+            return false;
+        }
+        return parseDynamicRanges(reinterpret_cast<const char*>(file.data()), file.size(), err);
+    }
+
+    //!
+    //! \brief Read either format, telling them apart by the header line that only calibration caches have
+    //!
+    bool read(const std::string& fileName, std::ostream& err)
+    {
+        MappedFile file;
+        if (!file.open(fileName, MappedFile::Advice::kSEQUENTIAL))
+        {
+            err << "Cannot read " << fileName << std::endl;
+            return false;
+        }
+        const char* data = reinterpret_cast<const char*>(file.data());
+        const char* eol = static_cast<const char*>(std::memchr(data, '\n', file.size()));
+        const size_t length = eol ? eol - data : file.size();
+        return findLastColon(data, length) ? parseDynamicRanges(data, file.size(), err)
+                                           : parseCache(data, file.size(), err);
+    }
+
+    //!
+    //! \brief Returns the table in the calibration cache format, which calibrators can return as is
+    //!
+    std::string serializeCache() const
+    {
+        std::string out = mHeader + "\n";
+        char hex[9];
+        for (const auto& e : mScales)
+        {
+            std::snprintf(hex, sizeof(hex), "%08x", floatToBits(e.second));
+            out.append(e.first).append(": ").append(hex).append("\n");
+        }
+        return out;
+    }
+
+    //!
+    //! \brief Returns the table in the dynamic range format, with the fewest digits that read back the same floats
+    //!
+    //! \details At least 6 significant digits are written, as by the default stream precision, so that the ranges
+    //!          of a file read by parseDynamicRanges are written back as they were, and at most the 9 any float needs.
+    //!
+    std::string serializeDynamicRanges() const
+    {
+        std::string out;
+        char value[32];
+        for (const auto& e : mScales)
+        {
+            const float range = getDynamicRange(e.first);
+            for (int digits = 6; digits <= 9; ++digits)
+            {
+                std::snprintf(value, sizeof(value), "%.*g", digits, range);
+                if (std::strtof(value, nullptr) == range)
+                {
+                    break;
+                }
+            }
+            out.append(e.first).append(":").append(value).append("\n");
+        }
+        return out;
+    }
+
+    bool writeCache(const std::string& fileName, std::ostream& err) const
+    {
+        return write(fileName, serializeCache(), err);
+    }
+
+    bool writeDynamicRanges(const std::string& fileName, std::ostream& err) const
+    {
+        return write(fileName, serializeDynamicRanges(), err);
+    }
+
+    //!
+    //! \brief Add the entries of other; the header is kept unless this table has none
+    //!
+    void merge(const CalibrationTable& other, MergePolicy policy = MergePolicy::kOVERRIDE)
+    {
+        if (mHeader.empty())
+        {
+            mHeader = other.mHeader;
+        }
+        for (const auto& e : other.mScales)
+        {
+            auto it = mScales.find(e.first);
+            if (it == mScales.end() || policy == MergePolicy::kOVERRIDE
+                || (policy == MergePolicy::kMAX && e.second > it->second))
+            {
+                mScales[e.first] = e.second;
+                const auto range = other.mRanges.find(e.first);
+                if (range == other.mRanges.end())
+                {
+                    mRanges.erase(e.first);
+                }
+                else
+                {
+                    mRanges[e.first] = range->second;
+                }
+            }
+        }
+    }
+
+    void setScale(const std::string& tensor, float scale)
+    {
+        mScales[tensor] = scale;
+        mRanges.erase(tensor);
+    }
+
+    void setDynamicRange(const std::string& tensor, float range)
+    {
+        mScales[tensor] = static_cast<float>(static_cast<double>(range) / kINT8_MAX);
+        mRanges[tensor] = range;
+    }
+
+    bool erase(const std::string& tensor)
+    {
+        mRanges.erase(tensor);
+        return mScales.erase(tensor) != 0;
+    }
+
+    void clear()
+    {
+        mHeader.clear();
+        mScales.clear();
+        mRanges.clear();
+    }
+
+    //!
+    //! \brief Returns the scale of tensor, or NaN if the table has none
+    //!
+    float getScale(const std::string& tensor) const
+    {
+        const auto it = mScales.find(tensor);
+        return it == mScales.end() ? NAN : it->second;
+    }
+
+    //!
+    //! \brief Returns the range of tensor as it was read or set, else 127 times its scale, or NaN if the table has none
+    //!
+    float getDynamicRange(const std::string& tensor) const
+    {
+        const auto it = mRanges.find(tensor);
+        return it == mRanges.end() ? static_cast<float>(static_cast<double>(getScale(tensor)) * kINT8_MAX) : it->second;
+    }
+
+    const std::map<std::string, float>& getScales() const { return mScales; }
+
+    const std::string& getHeader() const { return mHeader; }
+
+    void setHeader(const std::string& header) { mHeader = header; }
+
+    size_t size() const { return mScales.size(); }
+
+private:
+    template <typename F>
+    static bool forEachLine(const char* data, size_t size, F f)
+    {
+        const char* end = data + size;
+        for (const char* line = data; line < end;)
+        {
+            const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            eol = eol ? eol : end;
+            size_t length = eol - line;
+            if (length && line[length - 1] == '\r')
+            {
+                --length;
+            }
+            if (length && !f(line, length))
+            {
+                return false;
+            }
+            line = eol + 1;
+        }
+        return true;
+    }
+
+    static const char* findLastColon(const char* line, size_t length)
+    {
+        for (const char* c = line + length; c > line; --c)
+        {
+            if (c[-1] == ':')
+            {
+                return c - 1;
+            }
+        }
+        return nullptr;
+    }
+
+    static std::string trim(const char* begin, const char* end)
+    {
+        while (begin < end && (*begin == ' ' || *begin == '\t'))
+        {
+            ++begin;
+        }
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+        {
+            --end;
+        }
+        return std::string(begin, end);
+    }
+
+    static float bitsToFloat(uint32_t bits)
+    {
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    static uint32_t floatToBits(float f)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+
+    static bool write(const std::string& fileName, const std::string& contents, std::ostream& err)
+    {
+        if (!writeFileAtomically(fileName, contents))
+        {
+            err << "Cannot write " << fileName << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::string mHeader;
+    std::map<std::string, float> mScales;
+    std::map<std::string, float> mRanges; //!< Entries read or set as ranges, which their scales can be an ulp off
+};
+
+} // namespace samplesCommon
+
+#endif // CALIBRATION_TABLE_H
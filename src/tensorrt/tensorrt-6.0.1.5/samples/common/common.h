@@ -62,24 +62,32 @@
 
 #include "NvInfer.h"
 #include "NvInferPlugin.h"
+#include "latencyHistogram.h"
 #include "logger.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cmath>
 #include <cstring>
 #include <cuda_runtime_api.h>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <numeric>
 #include <ratio>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -145,58 +153,106 @@ constexpr long long int operator"" _GiB(long long unsigned int val) { return val
 constexpr long long int operator"" _MiB(long long unsigned int val) { return val * (1 << 20); }
 constexpr long long int operator"" _KiB(long long unsigned int val) { return val * (1 << 10); }
 
-struct SimpleProfiler : public nvinfer1::IProfiler
+//!
+//! \brief Profiler accumulating the time of each layer over inferences
+//!
+//! \details Layer names are interned to dense IDs the first time they are seen. Each thread reporting times then
+//!          accumulates into its own flat array, with a per-thread cache from name pointers to IDs, so that a report
+//!          costs a hash of the pointer and a string comparison, without locks. The arrays are owned by the profiler
+//!          and found through a small per-thread cache, so that destroyed profilers leave nothing behind in the
+//!          threads that used them. The arrays are merged when printing, which must not overlap with inference. One
+//!          profiler can be shared by contexts running on several threads.
+//!
+class SimpleProfiler : public nvinfer1::IProfiler
 {
+public:
     struct Record
     {
-        float time{0};
+        double time{0};
         int count{0};
+        float min{std::numeric_limits<float>::max()};
+        float max{0};
+        //! 1 us to 10 s with 4 significant bits, that is within 12.5%
+        samplesCommon::LatencyHistogram histogram{1e-3, 1e4, 4};
+
+        void add(float ms)
+        {
+            time += ms;
+            ++count;
+            min = std::min(min, ms);
+            max = std::max(max, ms);
+            histogram.record(ms);
+        }
+
+        void merge(const Record& other)
+        {
+            time += other.time;
+            count += other.count;
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+            histogram.merge(other.histogram);
+        }
     };
 
-    virtual void reportLayerTime(const char* layerName, float ms)
+    void reportLayerTime(const char* layerName, float ms) override
     {
-        mProfile[layerName].count++;
-        mProfile[layerName].time += ms;
-        if (std::find(mLayerNames.begin(), mLayerNames.end(), layerName)
-            == mLayerNames.end())
+        ThreadRecords& records = getThreadRecords();
+        const int id = getLayerId(records, layerName);
+        if (id >= static_cast<int>(records.layers.size()))
         {
-            mLayerNames.push_back(layerName);
+            records.layers.resize(id + 1);
         }
+        records.layers[id].add(ms);
     }
 
     SimpleProfiler(
         const char* name,
         const std::vector<SimpleProfiler>& srcProfilers = std::vector<SimpleProfiler>())
         : mName(name)
+        , mId(nextId())
     {
         for (const auto& srcProfiler : srcProfilers)
         {
-            for (const auto& rec : srcProfiler.mProfile)
-            {
-                auto it = mProfile.find(rec.first);
-                if (it == mProfile.end())
-                {
-                    mProfile.insert(rec);
-                }
-                else
-                {
-                    it->second.time += rec.second.time;
-                    it->second.count += rec.second.count;
-                }
-            }
+            srcProfiler.mergeInto(*this);
+        }
+    }
+
+    SimpleProfiler(const SimpleProfiler& other)
+        : mName(other.mName)
+        , mId(nextId())
+    {
+        other.mergeInto(*this);
+    }
+
+    SimpleProfiler& operator=(const SimpleProfiler& other)
+    {
+        if (this != &other)
+        {
+            SimpleProfiler copy(other);
+            std::lock_guard<std::mutex> lock(mMutex);
+            mName = copy.mName;
+            mNames.swap(copy.mNames);
+            mIds.swap(copy.mIds);
+            mThreads.swap(copy.mThreads);
+            mThreadRecords.swap(copy.mThreadRecords);
+            // The threads of copy are keyed by its ID, take it so that they find their records
+            std::swap(mId, copy.mId);
         }
+        return *this;
     }
 
     friend std::ostream& operator<<(std::ostream& out, const SimpleProfiler& value)
     {
+        const std::vector<Record> profile = value.getProfile();
+
         out << "========== " << value.mName << " profile ==========" << std::endl;
         float totalTime = 0;
         std::string layerNameStr = "TensorRT layer name";
         int maxLayerNameLength = std::max(static_cast<int>(layerNameStr.size()), 70);
-        for (const auto& elem : value.mProfile)
+        for (size_t i = 0; i < profile.size(); i++)
         {
-            totalTime += elem.second.time;
-            maxLayerNameLength = std::max(maxLayerNameLength, static_cast<int>(elem.first.size()));
+            totalTime += profile[i].time;
+            maxLayerNameLength = std::max(maxLayerNameLength, static_cast<int>(value.mNames[i].size()));
         }
 
         auto old_settings = out.flags();
@@ -209,17 +265,26 @@ struct SimpleProfiler : public nvinfer1::IProfiler
                 << " ";
             out << std::setw(12) << "Invocations"
                 << " ";
-            out << std::setw(12) << "Runtime, ms" << std::endl;
+            out << std::setw(12) << "Runtime, ms" << " ";
+            out << std::setw(12) << "Min, ms" << " ";
+            out << std::setw(12) << "Median, ms" << " ";
+            out << std::setw(12) << "Max, ms" << std::endl;
         }
-        for (size_t i = 0; i < value.mLayerNames.size(); i++)
+        for (size_t i = 0; i < profile.size(); i++)
         {
-            const std::string layerName = value.mLayerNames[i];
-            auto elem = value.mProfile.at(layerName);
-            out << std::setw(maxLayerNameLength) << layerName << " ";
+            const Record& elem = profile[i];
+            if (elem.count == 0)
+            {
+                continue;
+            }
+            out << std::setw(maxLayerNameLength) << value.mNames[i] << " ";
             out << std::setw(12) << std::fixed << std::setprecision(1) << (elem.time * 100.0F / totalTime) << "%"
                 << " ";
             out << std::setw(12) << elem.count << " ";
-            out << std::setw(12) << std::fixed << std::setprecision(2) << elem.time << std::endl;
+            out << std::setw(12) << std::fixed << std::setprecision(2) << elem.time << " ";
+            out << std::setw(12) << std::setprecision(3) << elem.min << " ";
+            out << std::setw(12) << elem.histogram.getPercentile(50) << " ";
+            out << std::setw(12) << elem.max << std::endl;
         }
         out.flags(old_settings);
         out.precision(old_precision);
@@ -229,9 +294,126 @@ struct SimpleProfiler : public nvinfer1::IProfiler
     }
 
 private:
+    struct ThreadRecords
+    {
+        std::vector<Record> layers;                                      //!< Indexed by layer ID
+        std::unordered_map<const char*, std::pair<int, const char*>> ids; //!< Name pointer to ID and interned name
+    };
+
+    //! Profilers a thread reports to without taking a lock, the least recently registered one is evicted
+    static constexpr size_t kTHREAD_CACHE_SIZE{4};
+
+    struct CachedRecords
+    {
+        uint64_t id{0}; //!< 0 for an empty slot, profiler IDs start at 1
+        ThreadRecords* records{nullptr};
+    };
+
+    static uint64_t nextId()
+    {
+        static std::atomic<uint64_t> id{0};
+        return ++id;
+    }
+
+    ThreadRecords& getThreadRecords()
+    {
+        // Profiler IDs are never reused, so the slot of a destroyed profiler never matches again and is recycled
+        thread_local std::array<CachedRecords, kTHREAD_CACHE_SIZE> cache;
+        thread_local size_t nextSlot{0};
+        for (const auto& cached : cache)
+        {
+            if (cached.id == mId)
+            {
+                return *cached.records;
+            }
+        }
+
+        ThreadRecords* records{nullptr};
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            ThreadRecords*& owned = mThreadRecords[std::this_thread::get_id()];
+            if (!owned)
+            {
+                mThreads.emplace_back(new ThreadRecords);
+                owned = mThreads.back().get();
+            }
+            records = owned;
+        }
+        cache[nextSlot].id = mId;
+        cache[nextSlot].records = records;
+        nextSlot = (nextSlot + 1) % kTHREAD_CACHE_SIZE;
+        return *records;
+    }
+
+    int getLayerId(ThreadRecords& records, const char* layerName)
+    {
+        auto cached = records.ids.find(layerName);
+        if (cached != records.ids.end() && !strcmp(cached->second.second, layerName))
+        {
+            return cached->second.first;
+        }
+        std::lock_guard<std::mutex> lock(mMutex);
+        const int id = intern(layerName);
+        // Deque elements do not move, the interned name can be compared without the lock
+        records.ids[layerName] = std::make_pair(id, mNames[id].c_str());
+        return id;
+    }
+
+    int intern(const std::string& layerName)
+    {
+        auto it = mIds.find(layerName);
+        if (it != mIds.end())
+        {
+            return it->second;
+        }
+        mNames.push_back(layerName);
+        mIds.emplace(layerName, static_cast<int>(mNames.size() - 1));
+        return static_cast<int>(mNames.size() - 1);
+    }
+
+    //!
+    //! \brief Sum the records of all threads by layer ID
+    //!
+    std::vector<Record> getProfile() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector<Record> profile(mNames.size());
+        for (const auto& records : mThreads)
+        {
+            for (size_t i = 0; i < records->layers.size(); i++)
+            {
+                profile[i].merge(records->layers[i]);
+            }
+        }
+        return profile;
+    }
+
+    //!
+    //! \brief Add the records of this profiler to the ones of dst, as reported from the calling thread
+    //!
+    void mergeInto(SimpleProfiler& dst) const
+    {
+        const std::vector<Record> profile = getProfile();
+        ThreadRecords& records = dst.getThreadRecords();
+        std::lock_guard<std::mutex> lock(dst.mMutex);
+        for (size_t i = 0; i < profile.size(); i++)
+        {
+            const int id = dst.intern(mNames[i]);
+            if (id >= static_cast<int>(records.layers.size()))
+            {
+                records.layers.resize(id + 1);
+            }
+            records.layers[id].merge(profile[i]);
+        }
+    }
+
     std::string mName;
-    std::vector<std::string> mLayerNames;
-    std::map<std::string, Record> mProfile;
+    uint64_t mId{0};
+    mutable std::mutex mMutex;                 //!< Guards the interning tables and the list of threads
+    std::deque<std::string> mNames;            //!< Interned names, indexed by ID
+    std::unordered_map<std::string, int> mIds;
+    std::vector<std::unique_ptr<ThreadRecords>> mThreads;
+    std::unordered_map<std::thread::id, ThreadRecords*> mThreadRecords; //!< Records of each thread, in mThreads
 };
 
 // Locate path to file, given its filename or filepath suffix and possible dirs it might lie in
@@ -0,0 +1,532 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#ifndef _MSC_VER
+#include <dirent.h>
+#include <sys/stat.h>
+#else
+// Needed so that the max/min definitions in windows.h do not conflict with std::max/min.
+#define NOMINMAX
+#include <windows.h>
+#undef NOMINMAX
+#endif
+
+#include "atomicFile.h"
+#include "engineCache.h"
+
+namespace sample
+{
+
+namespace
+{
+
+constexpr uint64_t kC1{0x87c37b91114253d5ULL};
+constexpr uint64_t kC2{0x4cf5ad432745937fULL};
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+inline uint64_t mixK1(uint64_t k1)
+{
+    return rotl(k1 * kC1, 31) * kC2;
+}
+
+inline uint64_t mixK2(uint64_t k2)
+{
+    return rotl(k2 * kC2, 33) * kC1;
+}
+
+bool addFile(ContentHasher& hasher, const std::string& fileName, std::ostream& err)
+{
+    samplesCommon::MappedFile file;
+    if (!file.open(fileName, samplesCommon::MappedFile::Advice::kSEQUENTIAL))
+    {
+        err << "Cannot read " << fileName << " to compute the engine cache key" << std::endl;
+        return false;
+    }
+    hasher.add(static_cast<int64_t>(file.size())).update(file.data(), file.size());
+    return true;
+}
+
+void addDims(ContentHasher& hasher, const nvinfer1::Dims& dims)
+{
+    hasher.add(dims.nbDims);
+    for (int i = 0; i < dims.nbDims; ++i)
+    {
+        hasher.add(dims.d[i]);
+    }
+}
+
+void addFormats(ContentHasher& hasher, const std::vector<IOFormat>& formats)
+{
+    hasher.add(static_cast<int64_t>(formats.size()));
+    for (const auto& f : formats)
+    {
+        hasher.add(static_cast<int64_t>(f.first)).add(static_cast<int64_t>(f.second));
+    }
+}
+
+const char* kKEY_VERSION{"engine-cache 1"};
+const char* kINDEX_HEADER{"engine-cache 2"};
+constexpr size_t kKEY_LENGTH{32};
+const char* kENGINE_SUFFIX{".engine"};
+
+bool isDigest(const std::string& s)
+{
+    return s.size() == kKEY_LENGTH && s.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+
+std::string hashOf(const samplesCommon::MappedFile& file)
+{
+    return ContentHasher().update(file.data(), file.size()).digest();
+}
+
+//!
+//! \brief Collect the keys and sizes of the engine files in directory
+//!
+std::map<std::string, size_t> listEngines(const std::string& directory)
+{
+    std::map<std::string, size_t> engines;
+    const size_t nameLength = kKEY_LENGTH + std::strlen(kENGINE_SUFFIX);
+    auto addFile = [&](const std::string& name, size_t size) {
+        if (name.size() == nameLength && name.compare(kKEY_LENGTH, std::string::npos, kENGINE_SUFFIX) == 0
+            && isDigest(name.substr(0, kKEY_LENGTH)))
+        {
+            engines[name.substr(0, kKEY_LENGTH)] = size;
+        }
+    };
+#ifndef _MSC_VER
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+    {
+        return engines;
+    }
+    while (const dirent* entry = readdir(dir))
+    {
+        struct stat st;
+        const std::string name = entry->d_name;
+        if (stat((directory + "/" + name).c_str(), &st) == 0 && S_ISREG(st.st_mode))
+        {
+            addFile(name, static_cast<size_t>(st.st_size));
+        }
+    }
+    closedir(dir);
+#else
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((directory + "/*" + kENGINE_SUFFIX).c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return engines;
+    }
+    do
+    {
+        addFile(data.cFileName, (static_cast<size_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#endif
+    return engines;
+}
+
+} // namespace
+
+void ContentHasher::block(const uint8_t* data)
+{
+    uint64_t k1;
+    uint64_t k2;
+    std::memcpy(&k1, data, sizeof(k1));
+    std::memcpy(&k2, data + sizeof(k1), sizeof(k2));
+
+    mH1 ^= mixK1(k1);
+    mH1 = (rotl(mH1, 27) + mH2) * 5 + 0x52dce729;
+    mH2 ^= mixK2(k2);
+    mH2 = (rotl(mH2, 31) + mH1) * 5 + 0x38495ab5;
+}
+
+ContentHasher& ContentHasher::update(const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    mLength += size;
+    if (mTailSize)
+    {
+        const size_t n = std::min(size, sizeof(mTail) - mTailSize);
+        std::memcpy(mTail + mTailSize, bytes, n);
+        mTailSize += n;
+        bytes += n;
+        size -= n;
+        if (mTailSize < sizeof(mTail))
+        {
+            return *this;
+        }
+        block(mTail);
+        mTailSize = 0;
+    }
+    for (; size >= sizeof(mTail); bytes += sizeof(mTail), size -= sizeof(mTail))
+    {
+        block(bytes);
+    }
+    std::memcpy(mTail, bytes, size);
+    mTailSize = size;
+    return *this;
+}
+
+ContentHasher& ContentHasher::add(const std::string& value)
+{
+    return add(static_cast<int64_t>(value.size())).update(value.data(), value.size());
+}
+
+ContentHasher& ContentHasher::add(int64_t value)
+{
+    return update(&value, sizeof(value));
+}
+
+std::string ContentHasher::digest() const
+{
+    uint64_t h1 = mH1;
+    uint64_t h2 = mH2;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    for (size_t i = mTailSize; i > 8; --i)
+    {
+        k2 = (k2 << 8) | mTail[i - 1];
+    }
+    for (size_t i = std::min(mTailSize, size_t(8)); i > 0; --i)
+    {
+        k1 = (k1 << 8) | mTail[i - 1];
+    }
+    if (mTailSize > 8)
+    {
+        h2 ^= mixK2(k2);
+    }
+    if (mTailSize > 0)
+    {
+        h1 ^= mixK1(k1);
+    }
+
+    h1 ^= mLength;
+    h2 ^= mLength;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    std::ostringstream os;
+    os << std::hex << std::setfill('0') << std::setw(16) << h1 << std::setw(16) << h2;
+    return os.str();
+}
+
+bool computeEngineKey(const ModelOptions& model, const BuildOptions& build, const SystemOptions& sys,
+    const std::string& platform, std::string& key, std::ostream& err)
+{
+    ContentHasher hasher;
+    hasher.add(kKEY_VERSION).add(platform);
+
+    // Files are keyed by contents, not by name, so that moving a model keeps its engine
+    hasher.add(static_cast<int64_t>(model.baseModel.format));
+    if (!addFile(hasher, model.baseModel.model, err))
+    {
+        return false;
+    }
+    hasher.add(!model.prototxt.empty());
+    if (!model.prototxt.empty() && !addFile(hasher, model.prototxt, err))
+    {
+        return false;
+    }
+    hasher.add(static_cast<int64_t>(model.outputs.size()));
+    for (const auto& o : model.outputs)
+    {
+        hasher.add(o);
+    }
+    hasher.add(static_cast<int64_t>(model.uffInputs.inputs.size())).add(model.uffInputs.NHWC);
+    for (const auto& i : model.uffInputs.inputs)
+    {
+        hasher.add(i.first);
+        addDims(hasher, i.second);
+    }
+
+    hasher.add(build.maxBatch).add(build.workspace).add(build.minTiming).add(build.avgTiming);
+    hasher.add(build.fp16).add(build.int8).add(build.safe);
+    // A calibration cache that does not exist yet is generated by the build, so only its absence is keyed
+    samplesCommon::MappedFile calibration;
+    const bool hasCalibration = !build.calibration.empty() && calibration.open(build.calibration);
+    hasher.add(hasCalibration);
+    if (hasCalibration)
+    {
+        hasher.add(static_cast<int64_t>(calibration.size())).update(calibration.data(), calibration.size());
+    }
+    std::vector<std::string> names;
+    for (const auto& s : build.shapes)
+    {
+        names.push_back(s.first);
+    }
+    std::sort(names.begin(), names.end());
+    hasher.add(static_cast<int64_t>(names.size()));
+    for (const auto& n : names)
+    {
+        hasher.add(n);
+        for (const auto& dims : build.shapes.at(n))
+        {
+            addDims(hasher, dims);
+        }
+    }
+    addFormats(hasher, build.inputFormats);
+    addFormats(hasher, build.outputFormats);
+
+    hasher.add(sys.DLACore).add(sys.fallback);
+    hasher.add(static_cast<int64_t>(sys.plugins.size()));
+    for (const auto& p : sys.plugins)
+    {
+        if (!addFile(hasher, p, err))
+        {
+            return false;
+        }
+    }
+
+    key = hasher.digest();
+    return true;
+}
+
+EngineCache::EngineCache(const std::string& directory, size_t capacity)
+    : mDirectory(directory)
+    , mCapacity(capacity)
+{
+    samplesCommon::makeDirectory(mDirectory);
+    readIndex();
+}
+
+std::string EngineCache::enginePath(const std::string& key) const
+{
+    return mDirectory + "/" + key + ".engine";
+}
+
+void EngineCache::readIndex()
+{
+    // Other processes may have used the cache since the last read
+    mEntries.clear();
+    std::ifstream index(mDirectory + "/index");
+    if (!index)
+    {
+        rebuildIndex();
+        return;
+    }
+    if (!parseIndex(index))
+    {
+        mEntries.clear();
+        rebuildIndex();
+    }
+}
+
+bool EngineCache::parseIndex(std::istream& index)
+{
+    std::string line;
+    if (!std::getline(index, line) || line != kINDEX_HEADER)
+    {
+        return false;
+    }
+    while (std::getline(index, line))
+    {
+        std::istringstream fields(line);
+        std::string key;
+        std::string hash;
+        Entry entry{0, 0, ""};
+        std::string rest;
+        if (!(fields >> key >> entry.size >> entry.lastUse >> hash) || (fields >> rest) || !isDigest(key)
+            || (hash != "-" && !isDigest(hash)) || mEntries.count(key))
+        {
+            return false;
+        }
+        entry.hash = hash == "-" ? "" : hash;
+        mEntries[key] = entry;
+        mClock = std::max(mClock, entry.lastUse);
+    }
+    return index.eof();
+}
+
+void EngineCache::rebuildIndex()
+{
+    // Recovered engines are older than any use to come and their hash is recorded when they are next loaded
+    for (const auto& e : listEngines(mDirectory))
+    {
+        mEntries[e.first] = Entry{e.second, 0, ""};
+    }
+    if (!mEntries.empty())
+    {
+        evict("");
+    }
+    writeIndex();
+}
+
+bool EngineCache::writeIndex()
+{
+    std::ostringstream index;
+    index << kINDEX_HEADER << std::endl;
+    for (const auto& e : mEntries)
+    {
+        index << e.first << " " << e.second.size << " " << e.second.lastUse << " "
+              << (e.second.hash.empty() ? "-" : e.second.hash) << std::endl;
+    }
+    return samplesCommon::writeFileAtomically(mDirectory + "/index", index.str());
+}
+
+void EngineCache::evict(const std::string& keep)
+{
+    size_t total{0};
+    for (const auto& e : mEntries)
+    {
+        total += e.second.size;
+    }
+    while (total > mCapacity)
+    {
+        auto lru = mEntries.end();
+        for (auto e = mEntries.begin(); e != mEntries.end(); ++e)
+        {
+            if (e->first != keep && (lru == mEntries.end() || e->second.lastUse < lru->second.lastUse))
+            {
+                lru = e;
+            }
+        }
+        if (lru == mEntries.end())
+        {
+            break;
+        }
+        std::remove(enginePath(lru->first).c_str());
+        total -= lru->second.size;
+        mEntries.erase(lru);
+    }
+}
+
+bool EngineCache::load(const std::string& key, samplesCommon::MappedFile& engine)
+{
+    readIndex();
+    if (!engine.open(enginePath(key), samplesCommon::MappedFile::Advice::kSEQUENTIAL))
+    {
+        if (mEntries.erase(key))
+        {
+            writeIndex();
+        }
+        return false;
+    }
+    // Deserializing a damaged engine may crash rather than fail, so it is checked first. Hashing also pages the
+    // engine in for the deserialization that follows.
+    const std::string hash = hashOf(engine);
+    const auto entry = mEntries.find(key);
+    if (entry != mEntries.end()
+        && (entry->second.size != engine.size() || (!entry->second.hash.empty() && entry->second.hash != hash)))
+    {
+        engine.close();
+        remove(key);
+        return false;
+    }
+    // Also adopts an engine stored by a process whose index update was lost
+    mEntries[key] = Entry{engine.size(), ++mClock, hash};
+    writeIndex();
+    return true;
+}
+
+bool EngineCache::store(const std::string& key, const void* data, size_t size, std::ostream& err)
+{
+    if (!samplesCommon::writeFileAtomically(enginePath(key), data, size))
+    {
+        err << "Cannot write " << enginePath(key) << std::endl;
+        return false;
+    }
+    readIndex();
+    mEntries[key] = Entry{size, ++mClock, ContentHasher().update(data, size).digest()};
+    evict(key);
+    if (!writeIndex())
+    {
+        err << "Cannot write the engine cache index in " << mDirectory << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void EngineCache::remove(const std::string& key)
+{
+    readIndex();
+    std::remove(enginePath(key).c_str());
+    if (mEntries.erase(key))
+    {
+        writeIndex();
+    }
+}
+
+size_t EngineCache::size()
+{
+    readIndex();
+    size_t total{0};
+    for (const auto& e : mEntries)
+    {
+        total += e.second.size;
+    }
+    return total;
+}
+
+} // namespace sample
@@ -0,0 +1,171 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_ENGINE_CACHE_H
+#define TRT_SAMPLE_ENGINE_CACHE_H
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "mappedFile.h"
+#include "sampleOptions.h"
+
+namespace sample
+{
+
+//!
+//! \brief Incremental 128 bit MurmurHash3 (x64 variant) of a byte stream
+//!
+//! \details Fast enough to hash multi-gigabyte models in a fraction of a build, and wide enough that two different
+//!          inputs sharing a digest is not a practical concern. Not a cryptographic hash.
+//!
+class ContentHasher
+{
+public:
+    ContentHasher& update(const void* data, size_t size);
+
+    //!
+    //! \brief Hash a value together with its size, so that consecutive fields cannot run into each other
+    //!
+    ContentHasher& add(const std::string& value);
+
+    ContentHasher& add(int64_t value);
+
+    //!
+    //! \brief Returns the 32 hex digits hash of everything added so far
+    //!
+    std::string digest() const;
+
+private:
+    void block(const uint8_t* data);
+
+    uint64_t mH1{0};
+    uint64_t mH2{0};
+    uint64_t mLength{0};
+    uint8_t mTail[16]{};
+    size_t mTailSize{0};
+};
+
+//!
+//! \brief Compute the key of the engine that modelToEngine builds for these options
+//!
+//! \details The key covers the bytes of the model, prototxt, calibration cache and plugin files, every option that
+//!          changes the built engine, and platform, which identifies the library version and GPU.
+//!
+//! \return false if one of the files could not be read
+//!
+bool computeEngineKey(const ModelOptions& model, const BuildOptions& build, const SystemOptions& sys,
+    const std::string& platform, std::string& key, std::ostream& err);
+
+//!
+//! \brief  Directory of serialized engines named by their key, with an LRU index bounded in size.
+//!
+//! \details Engines and the index are written atomically, so an interrupted or concurrent run never leaves a
+//!          partial file behind. Concurrent processes may lose each other's recency updates, which only makes the
+//!          eviction order slightly less accurate.
+//!          Nothing read back is trusted: an index that does not parse is rebuilt from the engines in the directory,
+//!          and an engine whose size or hash differs from its index entry is dropped like a miss.
+//!
+class EngineCache
+{
+public:
+    //!
+    //! \param directory Where engines are stored, created if missing
+    //! \param capacity Total size of the engines kept, in bytes
+    //!
+    EngineCache(const std::string& directory, size_t capacity);
+
+    //!
+    //! \brief Map the engine stored under key and mark it as most recently used
+    //!
+    //! \return false on a miss, or if the engine does not match its index entry
+    //!
+    bool load(const std::string& key, samplesCommon::MappedFile& engine);
+
+    //!
+    //! \brief Store an engine under key, then evict least recently used engines until the cache fits its capacity
+    //!
+    bool store(const std::string& key, const void* data, size_t size, std::ostream& err);
+
+    //!
+    //! \brief Drop the engine stored under key, for instance if it cannot be deserialized
+    //!
+    void remove(const std::string& key);
+
+    //!
+    //! \brief Returns the total size of the engines in the cache
+    //!
+    size_t size();
+
+private:
+    struct Entry
+    {
+        size_t size;
+        uint64_t lastUse;
+        std::string hash; //!< ContentHasher digest of the engine, empty until it is first loaded if adopted
+    };
+
+    std::string enginePath(const std::string& key) const;
+    void readIndex();
+    bool parseIndex(std::istream& index);
+    void rebuildIndex();
+    bool writeIndex();
+    void evict(const std::string& keep);
+
+    std::string mDirectory;
+    size_t mCapacity;
+    std::map<std::string, Entry> mEntries;
+    uint64_t mClock{0}; //!< Logical time of the most recent use
+};
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_ENGINE_CACHE_H
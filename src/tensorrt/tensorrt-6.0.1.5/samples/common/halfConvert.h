@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HALF_CONVERT_H
+#define HALF_CONVERT_H
+
+#include "half.h"
+#include "parallelFor.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HALF_CONVERT_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define HALF_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+//!
+//! \file halfConvert.h
+//!
+//! Bulk conversions between float and half_float::half.
+//!
+//! The conversions round to nearest, ties to even, as the GPU and the F16C instructions do. Every code path gives
+//! the same bits, which are those of half_cast<half, std::round_to_nearest> when half.h is built with
+//! HALF_ROUND_TIES_TO_EVEN. NaNs stay NaNs, quieted, with the payload truncated or extended.
+//!
+namespace half_float
+{
+namespace convert
+{
+
+static_assert(sizeof(half) == sizeof(uint16_t), "half must be stored in 16 bits");
+
+//! Instruction sets the conversions are written for.
+enum class Isa
+{
+    kAUTO,
+    kSCALAR,
+    kF16C,
+    kAVX512,
+    kNEON
+};
+
+//! Elements converted per worker at least, below which threads cost more than they save.
+constexpr size_t kMIN_ELEMENTS_PER_WORKER{1 << 18};
+
+inline uint16_t floatToHalfBits(float value)
+{
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+    x &= 0x7FFFFFFF;
+
+    if (x >= 0x7F800000) // Inf or NaN
+    {
+        return sign | (x > 0x7F800000 ? 0x7E00 | ((x >> 13) & 0x3FF) : 0x7C00);
+    }
+    if (x >= 0x477FF000) // Rounds to Inf
+    {
+        return sign | 0x7C00;
+    }
+    if (x < 0x38800000) // Subnormal half or zero
+    {
+        if (x <= 0x33000000)
+        {
+            return sign;
+        }
+        const uint32_t shift = 126 - (x >> 23);
+        const uint32_t mantissa = (x & 0x7FFFFF) | 0x800000;
+        const uint32_t half = 1U << (shift - 1);
+        const uint32_t remainder = mantissa & ((half << 1) - 1);
+        uint32_t bits = mantissa >> shift;
+        bits += remainder > half || (remainder == half && (bits & 1));
+        return sign | static_cast<uint16_t>(bits);
+    }
+    // Rebias the exponent, then round the 13 dropped bits, a carry into the exponent being the right result.
+    const uint32_t rebiased = x - 0x38000000;
+    return sign | static_cast<uint16_t>((rebiased + 0xFFF + ((rebiased >> 13) & 1)) >> 13);
+}
+
+inline float halfBitsToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+    uint32_t x;
+    if (exponent == 0x1F)
+    {
+        x = sign | 0x7F800000 | (mantissa << 13) | (mantissa ? 0x400000 : 0);
+    }
+    else if (exponent == 0)
+    {
+        // Subnormals are exact in float, mantissa * 2^-24.
+        const float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-8F;
+        std::memcpy(&x, &magnitude, sizeof(x));
+        x |= sign;
+    }
+    else
+    {
+        x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &x, sizeof(result));
+    return result;
+}
+
+inline void toHalfScalar(const float* src, uint16_t* dst, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        dst[i] = floatToHalfBits(src[i]);
+    }
+}
+
+inline void toFloatScalar(const uint16_t* src, float* dst, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        dst[i] = halfBitsToFloat(src[i]);
+    }
+}
+
+#if HALF_CONVERT_X86
+__attribute__((target("avx,f16c"))) inline void toHalfF16C(const float* src, uint16_t* dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    toHalfScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx,f16c"))) inline void toFloatF16C(const uint16_t* src, float* dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+    }
+    toFloatScalar(src + i, dst + i, n - i);
+}
+
+// The zero-masked forms are used as the unmasked ones trip -Wmaybe-uninitialized in the GCC headers.
+__attribute__((target("avx512f"))) inline void toHalfAVX512(const float* src, uint16_t* dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i h = _mm512_maskz_cvtps_ph(0xFFFF, _mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), h);
+    }
+    toHalfScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void toFloatAVX512(const uint16_t* src, float* dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm512_storeu_ps(dst + i, _mm512_maskz_cvtph_ps(0xFFFF, h));
+    }
+    toFloatScalar(src + i, dst + i, n - i);
+}
+#endif // HALF_CONVERT_X86
+
+#if HALF_CONVERT_NEON
+// The conversions follow the rounding mode of FPCR, round to nearest even unless changed by the application.
+inline void toHalfNEON(const float* src, uint16_t* dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const float16x4_t low = vcvt_f16_f32(vld1q_f32(src + i));
+        const float16x4_t high = vcvt_f16_f32(vld1q_f32(src + i + 4));
+        vst1q_u16(dst + i, vreinterpretq_u16_f16(vcombine_f16(low, high)));
+    }
+    toHalfScalar(src + i, dst + i, n - i);
+}
+
+inline void toFloatNEON(const uint16_t* src, float* dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(src + i));
+        vst1q_f32(dst + i, vcvt_f32_f16(vget_low_f16(h)));
+        vst1q_f32(dst + i + 4, vcvt_f32_f16(vget_high_f16(h)));
+    }
+    toFloatScalar(src + i, dst + i, n - i);
+}
+#endif // HALF_CONVERT_NEON
+
+//!
+//! \brief Returns whether the CPU supports isa.
+//!
+inline bool isSupported(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::kAUTO:
+    case Isa::kSCALAR: return true;
+#if HALF_CONVERT_X86
+    case Isa::kF16C: return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    case Isa::kAVX512: return __builtin_cpu_supports("avx512f");
+#endif
+#if HALF_CONVERT_NEON
+    case Isa::kNEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+//!
+//! \brief Returns the instruction set used by Isa::kAUTO.
+//!
+inline Isa getBestIsa()
+{
+    static const Isa best = [] {
+        for (auto isa : {Isa::kAVX512, Isa::kF16C, Isa::kNEON})
+        {
+            if (isSupported(isa))
+            {
+                return isa;
+            }
+        }
+        return Isa::kSCALAR;
+    }();
+    return best;
+}
+
+inline void toHalf(const float* src, uint16_t* dst, size_t n, Isa isa)
+{
+    switch (isa == Isa::kAUTO ? getBestIsa() : isSupported(isa) ? isa : Isa::kSCALAR)
+    {
+#if HALF_CONVERT_X86
+    case Isa::kF16C: toHalfF16C(src, dst, n); break;
+    case Isa::kAVX512: toHalfAVX512(src, dst, n); break;
+#endif
+#if HALF_CONVERT_NEON
+    case Isa::kNEON: toHalfNEON(src, dst, n); break;
+#endif
+    default: toHalfScalar(src, dst, n); break;
+    }
+}
+
+inline void toFloat(const uint16_t* src, float* dst, size_t n, Isa isa)
+{
+    switch (isa == Isa::kAUTO ? getBestIsa() : isSupported(isa) ? isa : Isa::kSCALAR)
+    {
+#if HALF_CONVERT_X86
+    case Isa::kF16C: toFloatF16C(src, dst, n); break;
+    case Isa::kAVX512: toFloatAVX512(src, dst, n); break;
+#endif
+#if HALF_CONVERT_NEON
+    case Isa::kNEON: toFloatNEON(src, dst, n); break;
+#endif
+    default: toFloatScalar(src, dst, n); break;
+    }
+}
+
+} // namespace convert
+
+//!
+//! \brief Convert n floats to halves, rounding to nearest even.
+//!
+//! \details Large arrays are split over up to nbWorkers threads, nbWorkers <= 0 selecting one per CPU.
+//!
+inline void convert_n(
+    const float* src, half* dst, size_t n, int nbWorkers = 0, convert::Isa isa = convert::Isa::kAUTO)
+{
+    uint16_t* bits = reinterpret_cast<uint16_t*>(dst);
+    samplesCommon::parallelFor(0, static_cast<int64_t>(n),
+        [&](int64_t first, int64_t last) { convert::toHalf(src + first, bits + first, last - first, isa); },
+        convert::kMIN_ELEMENTS_PER_WORKER, nbWorkers);
+}
+
+//!
+//! \brief Convert n halves to floats, exactly.
+//!
+//! \details Large arrays are split over up to nbWorkers threads, nbWorkers <= 0 selecting one per CPU.
+//!
+inline void convert_n(
+    const half* src, float* dst, size_t n, int nbWorkers = 0, convert::Isa isa = convert::Isa::kAUTO)
+{
+    const uint16_t* bits = reinterpret_cast<const uint16_t*>(src);
+    samplesCommon::parallelFor(0, static_cast<int64_t>(n),
+        [&](int64_t first, int64_t last) { convert::toFloat(bits + first, dst + first, last - first, isa); },
+        convert::kMIN_ELEMENTS_PER_WORKER, nbWorkers);
+}
+
+} // namespace half_float
+
+#endif // HALF_CONVERT_H
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IMAGE_FILE_H
+#define IMAGE_FILE_H
+
+#include "common.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Description of a binary PGM (P5) or PPM (P6) image, read from its header.
+//!
+struct ImageInfo
+{
+    std::string fileName;
+    int c{0};              //!< Channels, 1 for PGM and 3 for PPM
+    int h{0};              //!< Rows
+    int w{0};              //!< Columns
+    int max{0};            //!< Largest pixel value, at most 255
+    size_t dataOffset{0};  //!< Offset of the first pixel in the file
+
+    //!
+    //! \brief Returns the size of the pixels in bytes, stored HWC.
+    //!
+    size_t size() const
+    {
+        return static_cast<size_t>(c) * h * w;
+    }
+};
+
+//!
+//! \brief A runtime sized image that owns its pixels.
+//!
+struct Image
+{
+    ImageInfo info;
+    std::vector<uint8_t> buffer; //!< HWC pixels
+};
+
+namespace imageFile
+{
+
+//! Longest header accepted, comments included.
+constexpr size_t kMAX_HEADER_SIZE{4096};
+
+//!
+//! \brief Parse the header of a binary PGM or PPM image from its first bytes.
+//!
+inline bool parseHeader(const uint8_t* data, size_t size, ImageInfo& info, std::string& err)
+{
+    size_t pos = 0;
+    // Read the next number, skipping whitespace and comments.
+    auto readNumber = [&](int& value) {
+        while (pos < size && (std::isspace(data[pos]) || data[pos] == '#'))
+        {
+            if (data[pos] == '#')
+            {
+                while (pos < size && data[pos] != '\n')
+                {
+                    ++pos;
+                }
+            }
+            else
+            {
+                ++pos;
+            }
+        }
+        int64_t number = 0;
+        const size_t start = pos;
+        while (pos < size && std::isdigit(data[pos]) && number <= INT32_MAX)
+        {
+            number = number * 10 + (data[pos++] - '0');
+        }
+        value = static_cast<int>(std::min<int64_t>(number, INT32_MAX));
+        return pos > start && pos < size && number <= INT32_MAX;
+    };
+
+    if (size < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6'))
+    {
+        err = info.fileName + " is not a binary PGM or PPM image";
+        return false;
+    }
+    info.c = data[1] == '5' ? 1 : 3;
+    pos = 2;
+    if (!readNumber(info.w) || !readNumber(info.h) || !readNumber(info.max) || !std::isspace(data[pos]))
+    {
+        err = "Invalid header in " + info.fileName;
+        return false;
+    }
+    if (info.w <= 0 || info.h <= 0 || info.max <= 0 || info.max > 255)
+    {
+        err = info.fileName + " has an unsupported size or depth";
+        return false;
+    }
+    // A single whitespace separates the header from the pixels.
+    info.dataOffset = pos + 1;
+    return true;
+}
+
+//!
+//! \brief Check that the file holds all the pixels and that they fit in the destination buffer.
+//!
+inline bool checkSizes(const ImageInfo& info, size_t fileSize, size_t bufferSize, std::string& err)
+{
+    if (fileSize < info.dataOffset || fileSize - info.dataOffset < info.size())
+    {
+        err = info.fileName + " is truncated";
+        return false;
+    }
+    if (bufferSize < info.size())
+    {
+        err = "The buffer of " + std::to_string(bufferSize) + " bytes is too small for the " + std::to_string(info.w)
+            + "x" + std::to_string(info.h) + "x" + std::to_string(info.c) + " image " + info.fileName;
+        return false;
+    }
+    return true;
+}
+
+} // namespace imageFile
+
+//!
+//! \brief Read the header of a binary PGM or PPM image.
+//!
+//! \return true if the header is valid, otherwise err holds the reason.
+//!
+inline bool readImageInfo(const std::string& fileName, ImageInfo& info, std::string& err)
+{
+    info = ImageInfo{};
+    info.fileName = fileName;
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+    {
+        err = "Cannot open " + fileName;
+        return false;
+    }
+    uint8_t header[imageFile::kMAX_HEADER_SIZE];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    return imageFile::parseHeader(header, static_cast<size_t>(file.gcount()), info, err);
+}
+
+//!
+//! \brief Decode a binary PGM or PPM image straight into a caller provided buffer, which may be pinned memory.
+//!
+//! \details The header is validated and the pixels, stored HWC, are read directly into buffer without any
+//!          intermediate copy. With map set, the file is memory mapped instead of read.
+//!
+//! \return true on success, otherwise err holds the reason.
+//!
+inline bool readImage(const std::string& fileName, ImageInfo& info, uint8_t* buffer, size_t bufferSize,
+    std::string& err, bool map = false)
+{
+    info = ImageInfo{};
+    info.fileName = fileName;
+    if (map)
+    {
+        MappedFile file;
+        if (!file.open(fileName, MappedFile::Advice::kSEQUENTIAL))
+        {
+            err = "Cannot map " + fileName;
+            return false;
+        }
+        if (!imageFile::parseHeader(file.data(), std::min(file.size(), imageFile::kMAX_HEADER_SIZE), info, err)
+            || !imageFile::checkSizes(info, file.size(), bufferSize, err))
+        {
+            return false;
+        }
+        std::memcpy(buffer, file.data() + info.dataOffset, info.size());
+        return true;
+    }
+
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        err = "Cannot open " + fileName;
+        return false;
+    }
+    const size_t fileSize = static_cast<size_t>(file.tellg());
+    uint8_t header[imageFile::kMAX_HEADER_SIZE];
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(header), std::min(fileSize, sizeof(header)));
+    if (!imageFile::parseHeader(header, static_cast<size_t>(file.gcount()), info, err)
+        || !imageFile::checkSizes(info, fileSize, bufferSize, err))
+    {
+        return false;
+    }
+    file.clear();
+    file.seekg(info.dataOffset);
+    if (!file.read(reinterpret_cast<char*>(buffer), info.size()))
+    {
+        err = "Cannot read the pixels of " + fileName;
+        return false;
+    }
+    return true;
+}
+
+//!
+//! \brief Read a binary PGM or PPM image of any size into an Image.
+//!
+inline bool readImage(const std::string& fileName, Image& image, std::string& err)
+{
+    if (!readImageInfo(fileName, image.info, err))
+    {
+        return false;
+    }
+    image.buffer.resize(image.info.size());
+    return readImage(fileName, image.info, image.buffer.data(), image.buffer.size(), err);
+}
+
+//!
+//! \brief Read images of c x h x w pixels one after the other into a caller provided staging buffer.
+//!
+//! \details staging must hold fileNames.size() * c * h * w bytes. Images of other dimensions are rejected.
+//!
+inline bool readImageBatch(const std::vector<std::string>& fileNames, int c, int h, int w, uint8_t* staging,
+    std::vector<ImageInfo>& infos, std::string& err)
+{
+    const size_t imageSize = static_cast<size_t>(c) * h * w;
+    infos.resize(fileNames.size());
+    for (size_t i = 0; i < fileNames.size(); ++i)
+    {
+        if (!readImage(fileNames[i], infos[i], staging + i * imageSize, imageSize, err))
+        {
+            return false;
+        }
+        if (infos[i].c != c || infos[i].h != h || infos[i].w != w)
+        {
+            err = fileNames[i] + " is not a " + std::to_string(w) + "x" + std::to_string(h) + "x" + std::to_string(c)
+                + " image";
+            return false;
+        }
+    }
+    return true;
+}
+
+//!
+//! \brief Write the HWC pixels of a PPM image to filename with bbox drawn in red.
+//!
+inline void writePPMFileWithBBox(const std::string& filename, const ImageInfo& info, uint8_t* pixels, const BBox& bbox)
+{
+    std::ofstream outfile("./" + filename, std::ofstream::binary);
+    assert(!outfile.fail() && info.c == 3);
+    outfile << "P6"
+            << "\n"
+            << info.w << " " << info.h << "\n"
+            << info.max << "\n";
+    auto round = [](float x) -> int { return int(std::floor(x + 0.5f)); };
+    const int x1 = std::min(std::max(0, round(bbox.x1)), info.w - 1);
+    const int x2 = std::min(std::max(0, round(bbox.x2)), info.w - 1);
+    const int y1 = std::min(std::max(0, round(bbox.y1)), info.h - 1);
+    const int y2 = std::min(std::max(0, round(bbox.y2)), info.h - 1);
+    auto paint = [&](int x, int y) {
+        uint8_t* pixel = pixels + (static_cast<size_t>(y) * info.w + x) * 3;
+        pixel[0] = 255;
+        pixel[1] = 0;
+        pixel[2] = 0;
+    };
+    for (int x = x1; x <= x2; ++x)
+    {
+        paint(x, y1);
+        paint(x, y2);
+    }
+    for (int y = y1; y <= y2; ++y)
+    {
+        paint(x1, y);
+        paint(x2, y);
+    }
+    outfile.write(reinterpret_cast<char*>(pixels), info.size());
+}
+
+} // namespace samplesCommon
+
+#endif // IMAGE_FILE_H
@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IMAGE_PREPROCESS_H
+#define IMAGE_PREPROCESS_H
+
+#include "parallelFor.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRT_PREPROCESS_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define TRT_PREPROCESS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Instruction sets the image preprocessing kernels are written for.
+//!
+enum class PreprocessIsa
+{
+    kAUTO,   //!< Best instruction set supported by the CPU
+    kSCALAR, //!< Portable C++
+    kSSE41,  //!< x86 SSE4.1
+    kAVX2,   //!< x86 AVX2
+    kNEON    //!< ARM NEON
+};
+
+//!
+//! \brief Describes how interleaved uint8 pixels are turned into planar floats.
+//!
+//! \details Output channel c is read from input channel channelOrder[c] and set to scale[c] * pixel + bias[c].
+//!          A mean is subtracted by setting bias to -scale * mean, see setMeanScale().
+//!
+struct ImagePreprocessParams
+{
+    int channels{3};                                 //!< Number of channels, at most 4
+    std::array<int, 4> channelOrder{{0, 1, 2, 3}};   //!< Input channel of each output channel
+    std::array<float, 4> scale{{1.F, 1.F, 1.F, 1.F}}; //!< Per output channel scale
+    std::array<float, 4> bias{{0.F, 0.F, 0.F, 0.F}};  //!< Per output channel bias
+    PreprocessIsa isa{PreprocessIsa::kAUTO};
+
+    //!
+    //! \brief Reverse the channel order, to turn RGB images into BGR inputs and vice versa.
+    //!
+    void swapRB()
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            channelOrder[c] = channels - 1 - c;
+        }
+    }
+
+    //!
+    //! \brief Compute scale * (pixel - mean[c]) for each output channel c.
+    //!
+    void setMeanScale(const std::array<float, 4>& mean, float s)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            scale[c] = s;
+            bias[c] = -s * mean[c];
+        }
+    }
+};
+
+namespace preprocess
+{
+
+//!
+//! \brief Signature of the kernels converting one row of pixels.
+//!
+//! \details Output channel c of the row starts at dst + c * planeSize. The SIMD kernels handle 3 channels and fall
+//!          back to rowScalar() for other channel counts.
+//!
+using RowKernel
+    = void (*)(const uint8_t* src, int width, float* dst, int64_t planeSize, const ImagePreprocessParams& p);
+
+inline void rowScalar(const uint8_t* src, int width, float* dst, int64_t planeSize, const ImagePreprocessParams& p)
+{
+    const int channels = p.channels;
+    for (int c = 0; c < channels; ++c)
+    {
+        const uint8_t* in = src + p.channelOrder[c];
+        float* out = dst + c * planeSize;
+        const float scale = p.scale[c];
+        const float bias = p.bias[c];
+        for (int x = 0; x < width; ++x)
+        {
+            out[x] = scale * static_cast<float>(in[x * channels]) + bias;
+        }
+    }
+}
+
+#if TRT_PREPROCESS_X86
+//!
+//! \brief Shuffle masks gathering the 16 bytes of each channel out of 16 interleaved 3-channel pixels.
+//!
+//! \details masks[k][r] selects, from the r-th 16-byte block of the pixels, the bytes of channel k.
+//!
+struct Deinterleave3Masks
+{
+    Deinterleave3Masks()
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            for (int r = 0; r < 3; ++r)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    const int byte = 3 * i + k;
+                    masks[k][r][i] = byte / 16 == r ? static_cast<int8_t>(byte % 16) : static_cast<int8_t>(-128);
+                }
+            }
+        }
+    }
+
+    alignas(16) int8_t masks[3][3][16];
+};
+
+inline const Deinterleave3Masks& getDeinterleave3Masks()
+{
+    static const Deinterleave3Masks masks;
+    return masks;
+}
+
+__attribute__((target("sse4.1"))) inline void deinterleave3(const uint8_t* src, __m128i (&channels)[3])
+{
+    const auto& m = getDeinterleave3Masks().masks;
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+    for (int k = 0; k < 3; ++k)
+    {
+        const __m128i fromA = _mm_shuffle_epi8(a, _mm_load_si128(reinterpret_cast<const __m128i*>(m[k][0])));
+        const __m128i fromB = _mm_shuffle_epi8(b, _mm_load_si128(reinterpret_cast<const __m128i*>(m[k][1])));
+        const __m128i fromC = _mm_shuffle_epi8(c, _mm_load_si128(reinterpret_cast<const __m128i*>(m[k][2])));
+        channels[k] = _mm_or_si128(_mm_or_si128(fromA, fromB), fromC);
+    }
+}
+
+//! Store scale * x + bias for the 4 low bytes x of bytes.
+__attribute__((target("sse4.1"))) inline void storeScaled(float* out, __m128i bytes, __m128 scale, __m128 bias)
+{
+    _mm_storeu_ps(out, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(bytes)), scale), bias));
+}
+
+//! Store scale * x + bias for the 8 low bytes x of bytes.
+__attribute__((target("avx2"))) inline void storeScaled(float* out, __m128i bytes, __m256 scale, __m256 bias)
+{
+    // Multiply and add separately so that the results match the other kernels bit for bit.
+    _mm256_storeu_ps(out, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)), scale), bias));
+}
+
+__attribute__((target("sse4.1"))) inline void rowSSE41(
+    const uint8_t* src, int width, float* dst, int64_t planeSize, const ImagePreprocessParams& p)
+{
+    if (p.channels != 3)
+    {
+        rowScalar(src, width, dst, planeSize, p);
+        return;
+    }
+    __m128 scale[3], bias[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        scale[c] = _mm_set1_ps(p.scale[c]);
+        bias[c] = _mm_set1_ps(p.bias[c]);
+    }
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i in[3];
+        deinterleave3(src + 3 * x, in);
+        for (int c = 0; c < 3; ++c)
+        {
+            const __m128i bytes = in[p.channelOrder[c]];
+            float* out = dst + c * planeSize + x;
+            storeScaled(out, bytes, scale[c], bias[c]);
+            storeScaled(out + 4, _mm_srli_si128(bytes, 4), scale[c], bias[c]);
+            storeScaled(out + 8, _mm_srli_si128(bytes, 8), scale[c], bias[c]);
+            storeScaled(out + 12, _mm_srli_si128(bytes, 12), scale[c], bias[c]);
+        }
+    }
+    rowScalar(src + 3 * x, width - x, dst + x, planeSize, p);
+}
+
+__attribute__((target("avx2"))) inline void rowAVX2(
+    const uint8_t* src, int width, float* dst, int64_t planeSize, const ImagePreprocessParams& p)
+{
+    if (p.channels != 3)
+    {
+        rowScalar(src, width, dst, planeSize, p);
+        return;
+    }
+    __m256 scale[3], bias[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        scale[c] = _mm256_set1_ps(p.scale[c]);
+        bias[c] = _mm256_set1_ps(p.bias[c]);
+    }
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i in[3];
+        deinterleave3(src + 3 * x, in);
+        for (int c = 0; c < 3; ++c)
+        {
+            const __m128i bytes = in[p.channelOrder[c]];
+            float* out = dst + c * planeSize + x;
+            storeScaled(out, bytes, scale[c], bias[c]);
+            storeScaled(out + 8, _mm_srli_si128(bytes, 8), scale[c], bias[c]);
+        }
+    }
+    rowScalar(src + 3 * x, width - x, dst + x, planeSize, p);
+}
+#endif // TRT_PREPROCESS_X86
+
+#if TRT_PREPROCESS_NEON
+inline void rowNEON(const uint8_t* src, int width, float* dst, int64_t planeSize, const ImagePreprocessParams& p)
+{
+    if (p.channels != 3)
+    {
+        rowScalar(src, width, dst, planeSize, p);
+        return;
+    }
+    float32x4_t scale[3], bias[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        scale[c] = vdupq_n_f32(p.scale[c]);
+        bias[c] = vdupq_n_f32(p.bias[c]);
+    }
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        const uint8x16x3_t in = vld3q_u8(src + 3 * x);
+        for (int c = 0; c < 3; ++c)
+        {
+            const uint8x16_t bytes = in.val[p.channelOrder[c]];
+            const uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+            const uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+            const uint32x4_t words[4]
+                = {vmovl_u16(vget_low_u16(low)), vmovl_u16(vget_high_u16(low)), vmovl_u16(vget_low_u16(high)),
+                    vmovl_u16(vget_high_u16(high))};
+            float* out = dst + c * planeSize + x;
+            for (int i = 0; i < 4; ++i)
+            {
+                vst1q_f32(out + 4 * i, vaddq_f32(vmulq_f32(vcvtq_f32_u32(words[i]), scale[c]), bias[c]));
+            }
+        }
+    }
+    rowScalar(src + 3 * x, width - x, dst + x, planeSize, p);
+}
+#endif // TRT_PREPROCESS_NEON
+
+} // namespace preprocess
+
+//!
+//! \brief Returns whether the CPU can run the kernels of isa.
+//!
+inline bool isPreprocessIsaSupported(PreprocessIsa isa)
+{
+    switch (isa)
+    {
+    case PreprocessIsa::kAUTO:
+    case PreprocessIsa::kSCALAR: return true;
+#if TRT_PREPROCESS_X86
+    case PreprocessIsa::kSSE41: return __builtin_cpu_supports("sse4.1");
+    case PreprocessIsa::kAVX2: return __builtin_cpu_supports("avx2");
+#endif
+#if TRT_PREPROCESS_NEON
+    case PreprocessIsa::kNEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+//!
+//! \brief Returns the instruction set selected by PreprocessIsa::kAUTO.
+//!
+inline PreprocessIsa getPreprocessIsa()
+{
+    for (auto isa : {PreprocessIsa::kAVX2, PreprocessIsa::kSSE41, PreprocessIsa::kNEON})
+    {
+        if (isPreprocessIsaSupported(isa))
+        {
+            return isa;
+        }
+    }
+    return PreprocessIsa::kSCALAR;
+}
+
+inline const char* preprocessIsaToString(PreprocessIsa isa)
+{
+    switch (isa)
+    {
+    case PreprocessIsa::kAUTO: return "auto";
+    case PreprocessIsa::kSCALAR: return "scalar";
+    case PreprocessIsa::kSSE41: return "SSE4.1";
+    case PreprocessIsa::kAVX2: return "AVX2";
+    case PreprocessIsa::kNEON: return "NEON";
+    }
+    return "unknown";
+}
+
+namespace preprocess
+{
+
+inline RowKernel getRowKernel(PreprocessIsa isa)
+{
+    if (isa == PreprocessIsa::kAUTO)
+    {
+        static const PreprocessIsa best = getPreprocessIsa();
+        isa = best;
+    }
+    else if (!isPreprocessIsaSupported(isa))
+    {
+        isa = PreprocessIsa::kSCALAR;
+    }
+    switch (isa)
+    {
+#if TRT_PREPROCESS_X86
+    case PreprocessIsa::kSSE41: return rowSSE41;
+    case PreprocessIsa::kAVX2: return rowAVX2;
+#endif
+#if TRT_PREPROCESS_NEON
+    case PreprocessIsa::kNEON: return rowNEON;
+#endif
+    default: return rowScalar;
+    }
+}
+
+//! Pixels handed to a worker at least, so that small images are not split across threads.
+constexpr int64_t kMIN_PIXELS_PER_WORKER{1 << 16};
+
+} // namespace preprocess
+
+//!
+//! \brief Convert a batch of interleaved (HWC) uint8 images into planar (CHW) floats.
+//!
+//! \details The images are converted a row at a time, channel reordering, scaling and bias included, and the rows
+//!          of the batch are spread over up to nbWorkers threads (nbWorkers <= 0 selects getNbWorkers()).
+//!
+//! \param images Pointers to the first pixel of each image.
+//! \param srcRowStride Distance in bytes between the rows of an image, 0 for width * channels.
+//! \param dst Output of images.size() x channels x height x width floats.
+//!
+inline void preprocessHWCBatch(const std::vector<const uint8_t*>& images, int height, int width,
+    size_t srcRowStride, float* dst, const ImagePreprocessParams& params, int nbWorkers = 0)
+{
+    const preprocess::RowKernel kernel = preprocess::getRowKernel(params.isa);
+    const size_t rowStride = srcRowStride ? srcRowStride : static_cast<size_t>(width) * params.channels;
+    const int64_t planeSize = static_cast<int64_t>(height) * width;
+    const int64_t imageSize = planeSize * params.channels;
+    const int64_t nbRows = static_cast<int64_t>(images.size()) * height;
+    const int64_t minRows = std::max<int64_t>(1, preprocess::kMIN_PIXELS_PER_WORKER / std::max(width, 1));
+
+    parallelFor(0, nbRows,
+        [&](int64_t first, int64_t last) {
+            for (int64_t row = first; row < last; ++row)
+            {
+                const int64_t n = row / height;
+                const int64_t y = row % height;
+                kernel(images[n] + y * rowStride, width, dst + n * imageSize + y * width, planeSize, params);
+            }
+        },
+        minRows, nbWorkers);
+}
+
+//!
+//! \brief Convert one interleaved (HWC) uint8 image into planar (CHW) floats, see preprocessHWCBatch().
+//!
+inline void preprocessHWC(const uint8_t* image, int height, int width, size_t srcRowStride, float* dst,
+    const ImagePreprocessParams& params, int nbWorkers = 0)
+{
+    preprocessHWCBatch({image}, height, width, srcRowStride, dst, params, nbWorkers);
+}
+
+} // namespace samplesCommon
+
+#endif // IMAGE_PREPROCESS_H
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace samplesCommon
+{
+
+//!
+//! \brief  The MappedFile class is a read-only view of a whole file.
+//!
+//! \details On POSIX systems the file is memory mapped, so pages are only read from disk when they are touched.
+//!          On other platforms the file is read into a host buffer, which keeps the interface identical.
+//!          The class is move-only; the mapping is released when the object goes out of scope.
+//!
+class MappedFile
+{
+public:
+    //!
+    //! \brief Access pattern hint passed to the kernel when the file is mapped.
+    //!
+    enum class Advice
+    {
+        kNORMAL,
+        kSEQUENTIAL,
+        kRANDOM,
+        kWILLNEED
+    };
+
+    MappedFile() = default;
+
+    MappedFile(const std::string& fileName, Advice advice = Advice::kNORMAL)
+    {
+        open(fileName, advice);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other)
+        : mData(other.mData)
+        , mSize(other.mSize)
+        , mMapped(other.mMapped)
+        , mBuffer(std::move(other.mBuffer))
+    {
+        other.mData = nullptr;
+        other.mSize = 0;
+        other.mMapped = false;
+    }
+
+    MappedFile& operator=(MappedFile&& other)
+    {
+        if (this != &other)
+        {
+            close();
+            mData = other.mData;
+            mSize = other.mSize;
+            mMapped = other.mMapped;
+            mBuffer = std::move(other.mBuffer);
+            other.mData = nullptr;
+            other.mSize = 0;
+            other.mMapped = false;
+        }
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    //!
+    //! \brief Map fileName, releasing any previous mapping.
+    //!
+    //! \return true if the file could be opened and mapped.
+    //!
+    bool open(const std::string& fileName, Advice advice = Advice::kNORMAL)
+    {
+        close();
+#ifndef _MSC_VER
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        mSize = static_cast<size_t>(st.st_size);
+        if (mSize == 0)
+        {
+            // mmap rejects empty ranges, an empty file is still a valid (empty) view.
+            ::close(fd);
+            return true;
+        }
+        void* addr = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            mSize = 0;
+            return false;
+        }
+        mData = static_cast<const uint8_t*>(addr);
+        mMapped = true;
+        advise(advice);
+        return true;
+#else
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            return false;
+        }
+        mBuffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0, file.beg);
+        file.read(reinterpret_cast<char*>(mBuffer.data()), mBuffer.size());
+        if (!file)
+        {
+            mBuffer.clear();
+            return false;
+        }
+        mData = mBuffer.data();
+        mSize = mBuffer.size();
+        return true;
+#endif
+    }
+
+    //!
+    //! \brief Release the mapping. This is a no-op if nothing is mapped.
+    //!
+    void close()
+    {
+#ifndef _MSC_VER
+        if (mMapped)
+        {
+            munmap(const_cast<uint8_t*>(mData), mSize);
+        }
+#endif
+        mBuffer.clear();
+        mData = nullptr;
+        mSize = 0;
+        mMapped = false;
+    }
+
+    //!
+    //! \brief Change the access pattern hint for the whole mapping.
+    //!
+    void advise(Advice advice) const
+    {
+#ifndef _MSC_VER
+        if (!mMapped)
+        {
+            return;
+        }
+        int flag = MADV_NORMAL;
+        switch (advice)
+        {
+        case Advice::kNORMAL: flag = MADV_NORMAL; break;
+        case Advice::kSEQUENTIAL: flag = MADV_SEQUENTIAL; break;
+        case Advice::kRANDOM: flag = MADV_RANDOM; break;
+        case Advice::kWILLNEED: flag = MADV_WILLNEED; break;
+        }
+        madvise(const_cast<uint8_t*>(mData), mSize, flag);
+#endif
+    }
+
+    //!
+    //! \brief Returns a pointer to the first byte of the file, or nullptr if the view is empty.
+    //!
+    const uint8_t* data() const { return mData; }
+
+    //!
+    //! \brief Returns the size of the file in bytes.
+    //!
+    size_t size() const { return mSize; }
+
+    //!
+    //! \brief Returns true if the data is backed by an actual memory mapping rather than a host copy.
+    //!
+    bool isMapped() const { return mMapped; }
+
+private:
+    const uint8_t* mData{nullptr};
+    size_t mSize{0};
+    bool mMapped{false};
+    std::vector<uint8_t> mBuffer; //!< Host copy of the file where mmap is not available
+};
+
+} // namespace samplesCommon
+
+#endif // MAPPED_FILE_H
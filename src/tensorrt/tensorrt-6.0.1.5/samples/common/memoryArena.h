@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Counters of a MemoryArena, in bytes of size class for the byte counts
+//!
+struct ArenaStats
+{
+    size_t requests{0};       //!< Calls to allocate
+    size_t reused{0};         //!< Requests served from a free list
+    size_t backendAllocs{0};  //!< Blocks obtained from the backend
+    size_t backendFrees{0};   //!< Blocks given back to the backend
+    size_t bytesInUse{0};     //!< Bytes currently handed out
+    size_t peakBytesInUse{0}; //!< Highest bytesInUse seen
+    size_t bytesCached{0};    //!< Bytes sitting in free lists
+};
+
+inline std::ostream& operator<<(std::ostream& os, const ArenaStats& stats)
+{
+    os << stats.requests << " requests, " << stats.reused << " reused, " << stats.backendAllocs << " allocated and "
+       << stats.backendFrees << " freed blocks, " << stats.bytesInUse << " bytes in use (peak " << stats.peakBytesInUse
+       << "), " << stats.bytesCached << " bytes cached";
+    return os;
+}
+
+//!
+//! \brief  The MemoryArena class caches freed blocks of a backend allocator in size-class free lists.
+//!
+//! \details Requests are rounded up to one of four classes per power of two, so a class wastes at most a quarter of
+//!          the block, and a freed block is kept for the next request of the same class instead of being returned.
+//!          Backend is a type with static bool allocate(void** ptr, size_t size) and static void release(void* ptr).
+//!          The arena is thread-safe. Cached blocks beyond the cache limit are released straight to the backend,
+//!          and the whole cache is released when the last registered user goes away, see ArenaUser.
+//!
+template <typename Backend>
+class MemoryArena
+{
+public:
+    static constexpr size_t kMIN_BLOCK = 256;
+
+    //! Default limit of the cached bytes, small since pinned blocks are taken from the pageable memory of the system
+    static constexpr size_t kDEFAULT_CACHE_LIMIT = size_t(32) << 20;
+
+    explicit MemoryArena(size_t cacheLimit = kDEFAULT_CACHE_LIMIT)
+        : mCacheLimit(cacheLimit)
+    {
+    }
+
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    //!
+    //! \brief Blocks still handed out are not released; they belong to their owners.
+    //!
+    ~MemoryArena()
+    {
+        trim();
+    }
+
+    //!
+    //! \brief Round a request up to its size class
+    //!
+    static size_t sizeClass(size_t size)
+    {
+        if (size <= kMIN_BLOCK)
+        {
+            return kMIN_BLOCK;
+        }
+        int log2 = 0;
+        while ((size - 1) >> (log2 + 1))
+        {
+            ++log2;
+        }
+        const size_t step = size_t(1) << (log2 - 2);
+        return (size + step - 1) & ~(step - 1);
+    }
+
+    bool allocate(void** ptr, size_t size)
+    {
+        const size_t bytes = sizeClass(size);
+        std::unique_lock<std::mutex> lock(mMutex);
+        ++mStats.requests;
+        auto& freeList = mFreeLists[bytes];
+        if (!freeList.empty())
+        {
+            *ptr = freeList.back();
+            freeList.pop_back();
+            ++mStats.reused;
+            mStats.bytesCached -= bytes;
+        }
+        else
+        {
+            lock.unlock();
+            bool ok = Backend::allocate(ptr, bytes);
+            if (!ok)
+            {
+                // Give the cache back before declaring failure, pinned memory in particular is a scarce resource
+                trim();
+                ok = Backend::allocate(ptr, bytes);
+            }
+            lock.lock();
+            if (!ok)
+            {
+                *ptr = nullptr;
+                return false;
+            }
+            ++mStats.backendAllocs;
+        }
+        mLive[*ptr] = bytes;
+        mStats.bytesInUse += bytes;
+        mStats.peakBytesInUse = std::max(mStats.peakBytesInUse, mStats.bytesInUse);
+        return true;
+    }
+
+    //!
+    //! \brief Return a block to its free list. Accepts nullptr.
+    //!
+    void release(void* ptr)
+    {
+        if (!ptr)
+        {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mMutex);
+        const auto it = mLive.find(ptr);
+        if (it == mLive.end())
+        {
+            return;
+        }
+        const size_t bytes = it->second;
+        mLive.erase(it);
+        mStats.bytesInUse -= bytes;
+        if (mStats.bytesCached + bytes > mCacheLimit)
+        {
+            ++mStats.backendFrees;
+            lock.unlock();
+            Backend::release(ptr);
+            return;
+        }
+        mFreeLists[bytes].push_back(ptr);
+        mStats.bytesCached += bytes;
+    }
+
+    //!
+    //! \brief Give every cached block back to the backend
+    //!
+    void trim()
+    {
+        std::vector<void*> blocks;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto& freeList : mFreeLists)
+            {
+                blocks.insert(blocks.end(), freeList.second.begin(), freeList.second.end());
+                freeList.second.clear();
+            }
+            mStats.backendFrees += blocks.size();
+            mStats.bytesCached = 0;
+        }
+        for (void* block : blocks)
+        {
+            Backend::release(block);
+        }
+    }
+
+    void setCacheLimit(size_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCacheLimit = bytes;
+            if (mStats.bytesCached <= mCacheLimit)
+            {
+                return;
+            }
+        }
+        trim();
+    }
+
+    size_t getCacheLimit() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mCacheLimit;
+    }
+
+    ArenaStats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+    //!
+    //! \brief Register an owner of blocks, such as a BufferManager, for the duration of its life
+    //!
+    void addUser()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mUsers;
+    }
+
+    //!
+    //! \brief Unregister an owner of blocks, trimming the cache if it was the last one
+    //!
+    void removeUser()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (--mUsers > 0)
+            {
+                return;
+            }
+        }
+        trim();
+    }
+
+private:
+    mutable std::mutex mMutex;
+    size_t mCacheLimit;
+    int mUsers{0};                                             //!< Registered owners of blocks
+    std::unordered_map<size_t, std::vector<void*>> mFreeLists; //!< Cached blocks by size class
+    std::unordered_map<void*, size_t> mLive;                   //!< Size class of every block handed out
+    ArenaStats mStats;
+};
+
+template <typename Backend>
+constexpr size_t MemoryArena<Backend>::kMIN_BLOCK;
+
+template <typename Backend>
+constexpr size_t MemoryArena<Backend>::kDEFAULT_CACHE_LIMIT;
+
+//!
+//! \brief The process wide arena of a backend, shared by every buffer allocating from it
+//!
+template <typename Backend>
+MemoryArena<Backend>& getArena()
+{
+    static MemoryArena<Backend> arena;
+    return arena;
+}
+
+//!
+//! \brief Registers its owner as a user of the process wide arena of Backend while it lives
+//!
+//! \details Idle blocks stay cached while at least one user is alive, and go back to the backend with the last one,
+//!          so that a process does not keep memory cached after it is done with its buffers.
+//!
+template <typename Backend>
+class ArenaUser
+{
+public:
+    ArenaUser()
+    {
+        getArena<Backend>().addUser();
+    }
+
+    ArenaUser(const ArenaUser&)
+        : ArenaUser()
+    {
+    }
+
+    ArenaUser& operator=(const ArenaUser&) = default;
+
+    ~ArenaUser()
+    {
+        getArena<Backend>().removeUser();
+    }
+};
+
+//!
+//! \brief Host memory aligned for any vector load, needing no GPU
+//!
+struct AlignedHostMemory
+{
+    static constexpr size_t kALIGNMENT = 64;
+
+    static bool allocate(void** ptr, size_t size)
+    {
+#ifdef _MSC_VER
+        *ptr = _aligned_malloc(size, kALIGNMENT);
+        return *ptr != nullptr;
+#else
+        return posix_memalign(ptr, kALIGNMENT, size) == 0;
+#endif
+    }
+
+    static void release(void* ptr)
+    {
+#ifdef _MSC_VER
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+};
+
+//!
+//! \brief GenericBuffer allocation functors drawing from the arena of Backend
+//!
+template <typename Backend>
+class ArenaAllocator
+{
+public:
+    bool operator()(void** ptr, size_t size) const
+    {
+        return getArena<Backend>().allocate(ptr, size);
+    }
+};
+
+template <typename Backend>
+class ArenaFree
+{
+public:
+    void operator()(void* ptr) const
+    {
+        getArena<Backend>().release(ptr);
+    }
+};
+
+} // namespace samplesCommon
+
+#endif // MEMORY_ARENA_H
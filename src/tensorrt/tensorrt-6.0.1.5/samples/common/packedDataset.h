@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PACKED_DATASET_H
+#define PACKED_DATASET_H
+
+#include "mappedFile.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Layout of a packed dataset file.
+//!
+//! \details A packed dataset holds every sample of a calibration or evaluation set in one file:
+//!
+//!          PackedDatasetHeader
+//!          C x {scale, bias}   float pairs, element = scale * stored + bias for channel c
+//!          N x offset          uint64 offset of each sample from the start of the file
+//!          N x label           float labels, present if hasLabels is set
+//!          N x sample          CHW tensors of dataType, each starting on a kPACKED_ALIGNMENT boundary
+//!
+//!          All values are little endian. The index makes every sample reachable in O(1), so streams can start
+//!          or resume at any batch without reading the preceding ones.
+//!
+constexpr char kPACKED_MAGIC[8] = {'T', 'R', 'T', 'P', 'A', 'C', 'K', '\0'};
+constexpr uint32_t kPACKED_VERSION{1};
+constexpr uint64_t kPACKED_ALIGNMENT{64};
+
+enum class PackedDataType : uint32_t
+{
+    kFLOAT = 0, //!< Samples are stored preprocessed, scale and bias are 1 and 0
+    kUINT8 = 1  //!< Samples are stored as bytes, scale and bias restore the preprocessed values
+};
+
+struct PackedDatasetHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dataType;     //!< PackedDataType
+    int32_t dims[3];       //!< Sample dimensions, CHW
+    uint32_t hasLabels;
+    uint64_t nbSamples;
+    uint64_t channelsOffset; //!< Offset of the per-channel scale and bias
+    uint64_t indexOffset;    //!< Offset of the sample index
+    uint64_t labelsOffset;   //!< Offset of the labels
+    uint64_t dataOffset;     //!< Offset of the first sample
+    uint64_t sampleStride;   //!< Distance between consecutive samples written by PackedDatasetWriter
+};
+
+inline uint64_t alignPacked(uint64_t offset)
+{
+    return (offset + kPACKED_ALIGNMENT - 1) / kPACKED_ALIGNMENT * kPACKED_ALIGNMENT;
+}
+
+inline size_t getPackedDataTypeSize(PackedDataType type)
+{
+    return type == PackedDataType::kFLOAT ? sizeof(float) : sizeof(uint8_t);
+}
+
+//!
+//! \brief Read-only, memory mapped view of a packed dataset.
+//!
+class PackedDataset
+{
+public:
+    //!
+    //! \brief Map a packed dataset and validate its header and index.
+    //!
+    //! \return true if the file is a valid packed dataset, otherwise err holds the reason.
+    //!
+    bool open(const std::string& fileName, std::string& err)
+    {
+        if (!mFile.open(fileName, MappedFile::Advice::kRANDOM))
+        {
+            err = "Cannot map " + fileName;
+            return false;
+        }
+        if (mFile.size() < sizeof(PackedDatasetHeader))
+        {
+            err = fileName + " is too small to be a packed dataset";
+            return false;
+        }
+        std::memcpy(&mHeader, mFile.data(), sizeof(mHeader));
+        if (std::memcmp(mHeader.magic, kPACKED_MAGIC, sizeof(kPACKED_MAGIC)) || mHeader.version != kPACKED_VERSION)
+        {
+            err = fileName + " is not a version " + std::to_string(kPACKED_VERSION) + " packed dataset";
+            return false;
+        }
+        if (mHeader.dataType > static_cast<uint32_t>(PackedDataType::kUINT8) || mHeader.dims[0] <= 0
+            || mHeader.dims[1] <= 0 || mHeader.dims[2] <= 0
+            || static_cast<uint64_t>(mHeader.dims[0]) * mHeader.dims[1] > mFile.size() / mHeader.dims[2])
+        {
+            err = fileName + " has an invalid sample type or shape";
+            return false;
+        }
+
+        // The number of samples is bounded by the file before it is multiplied, so a huge count cannot wrap around.
+        const uint64_t n = mHeader.nbSamples;
+        if (!fitsArray(mHeader.indexOffset, n, sizeof(uint64_t))
+            || (mHeader.hasLabels && !fitsArray(mHeader.labelsOffset, n, sizeof(float))))
+        {
+            err = fileName + " has more samples than its index or labels can hold";
+            return false;
+        }
+        const uint64_t sampleSize = getSampleSize();
+        bool valid = fits(mHeader.channelsOffset, 2 * sizeof(float) * mHeader.dims[0]);
+        for (uint64_t i = 0; valid && i < n; ++i)
+        {
+            valid = fits(getOffset(i), sampleSize);
+        }
+        if (!valid)
+        {
+            err = fileName + " is truncated or has an invalid index";
+            return false;
+        }
+        return true;
+    }
+
+    const PackedDatasetHeader& getHeader() const { return mHeader; }
+
+    PackedDataType getDataType() const { return static_cast<PackedDataType>(mHeader.dataType); }
+
+    int64_t getNbSamples() const { return static_cast<int64_t>(mHeader.nbSamples); }
+
+    //!
+    //! \brief Returns the number of elements of a sample.
+    //!
+    int64_t getSampleVolume() const
+    {
+        return static_cast<int64_t>(mHeader.dims[0]) * mHeader.dims[1] * mHeader.dims[2];
+    }
+
+    //!
+    //! \brief Returns the size of a sample in bytes.
+    //!
+    size_t getSampleSize() const
+    {
+        return getSampleVolume() * getPackedDataTypeSize(getDataType());
+    }
+
+    const uint8_t* getSample(int64_t index) const { return mFile.data() + getOffset(index); }
+
+    float getLabel(int64_t index) const
+    {
+        return mHeader.hasLabels ? read<float>(mHeader.labelsOffset + index * sizeof(float)) : 0.F;
+    }
+
+    float getScale(int channel) const { return read<float>(mHeader.channelsOffset + 2 * channel * sizeof(float)); }
+
+    float getBias(int channel) const
+    {
+        return read<float>(mHeader.channelsOffset + (2 * channel + 1) * sizeof(float));
+    }
+
+    //!
+    //! \brief Hint the kernel that samples [first, first + count) will be read soon.
+    //!
+    void prefetch(int64_t first, int64_t count) const
+    {
+#ifndef _MSC_VER
+        if (!mFile.isMapped() || count <= 0)
+        {
+            return;
+        }
+        const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        const uint64_t begin = getOffset(first) / page * page;
+        const uint64_t end = getOffset(first + count - 1) + getSampleSize();
+        madvise(const_cast<uint8_t*>(mFile.data()) + begin, end - begin, MADV_WILLNEED);
+#endif
+    }
+
+private:
+    template <typename T>
+    T read(uint64_t offset) const
+    {
+        T value;
+        std::memcpy(&value, mFile.data() + offset, sizeof(T));
+        return value;
+    }
+
+    uint64_t getOffset(int64_t index) const { return read<uint64_t>(mHeader.indexOffset + index * sizeof(uint64_t)); }
+
+    bool fits(uint64_t offset, uint64_t size) const
+    {
+        return offset <= mFile.size() && size <= mFile.size() - offset;
+    }
+
+    //! Whether count elements of elementSize bytes fit at offset, without computing their size.
+    bool fitsArray(uint64_t offset, uint64_t count, uint64_t elementSize) const
+    {
+        return offset <= mFile.size() && count <= (mFile.size() - offset) / elementSize;
+    }
+
+    MappedFile mFile;
+    PackedDatasetHeader mHeader{};
+};
+
+//!
+//! \brief Sequential writer of packed datasets.
+//!
+//! \details The layout is computed up front from the number of samples, then samples are appended one at a time
+//!          so that the whole dataset never has to be held in memory.
+//!
+class PackedDatasetWriter
+{
+public:
+    //!
+    //! \brief Create fileName and write everything but the samples.
+    //!
+    //! \param scales, biases Per-channel values used to restore the preprocessed data, must hold dims[0] elements.
+    //! \param labels Labels of all the samples, or empty if the dataset has no labels.
+    //!
+    bool open(const std::string& fileName, PackedDataType type, const int32_t (&dims)[3], uint64_t nbSamples,
+        const std::vector<float>& scales, const std::vector<float>& biases, const std::vector<float>& labels)
+    {
+        mFile.open(fileName, std::ios::binary | std::ios::trunc);
+        if (!mFile)
+        {
+            return false;
+        }
+
+        PackedDatasetHeader header{};
+        std::memcpy(header.magic, kPACKED_MAGIC, sizeof(kPACKED_MAGIC));
+        header.version = kPACKED_VERSION;
+        header.dataType = static_cast<uint32_t>(type);
+        std::copy_n(dims, 3, header.dims);
+        header.hasLabels = labels.empty() ? 0 : 1;
+        header.nbSamples = nbSamples;
+        header.channelsOffset = alignPacked(sizeof(header));
+        header.indexOffset = alignPacked(header.channelsOffset + 2 * sizeof(float) * dims[0]);
+        header.labelsOffset = alignPacked(header.indexOffset + sizeof(uint64_t) * nbSamples);
+        header.dataOffset = alignPacked(header.labelsOffset + sizeof(float) * labels.size());
+        mSampleSize = static_cast<uint64_t>(dims[0]) * dims[1] * dims[2] * getPackedDataTypeSize(type);
+        header.sampleStride = alignPacked(mSampleSize);
+        mSampleStride = header.sampleStride;
+
+        std::vector<float> channels;
+        for (int c = 0; c < dims[0]; ++c)
+        {
+            channels.push_back(scales[c]);
+            channels.push_back(biases[c]);
+        }
+        std::vector<uint64_t> index(nbSamples);
+        for (uint64_t i = 0; i < nbSamples; ++i)
+        {
+            index[i] = header.dataOffset + i * header.sampleStride;
+        }
+
+        write(&header, sizeof(header), 0);
+        write(channels.data(), channels.size() * sizeof(float), header.channelsOffset);
+        write(index.data(), index.size() * sizeof(uint64_t), header.indexOffset);
+        write(labels.data(), labels.size() * sizeof(float), header.labelsOffset);
+        pad(header.dataOffset);
+        return static_cast<bool>(mFile);
+    }
+
+    //!
+    //! \brief Append the next sample, of the size implied by the type and dimensions given to open().
+    //!
+    bool addSample(const void* data)
+    {
+        const uint64_t start = mFile.tellp();
+        mFile.write(static_cast<const char*>(data), mSampleSize);
+        pad(start + mSampleStride);
+        return static_cast<bool>(mFile);
+    }
+
+    bool close()
+    {
+        mFile.close();
+        return !mFile.fail();
+    }
+
+private:
+    void write(const void* data, size_t size, uint64_t offset)
+    {
+        pad(offset);
+        mFile.write(static_cast<const char*>(data), size);
+    }
+
+    void pad(uint64_t offset)
+    {
+        static const char zeros[kPACKED_ALIGNMENT]{};
+        for (uint64_t position = mFile.tellp(); mFile && position < offset; position = mFile.tellp())
+        {
+            mFile.write(zeros, std::min(offset - position, kPACKED_ALIGNMENT));
+        }
+    }
+
+    std::ofstream mFile;
+    uint64_t mSampleSize{0};
+    uint64_t mSampleStride{0};
+};
+
+} // namespace samplesCommon
+
+#endif // PACKED_DATASET_H
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Returns the number of worker threads to use for host side data processing.
+//!
+inline int getNbWorkers()
+{
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+//!
+//! \brief Run fn(first, last) over contiguous chunks of [begin, end) on up to nbWorkers threads.
+//!
+//! \details The calling thread processes the first chunk, so a single chunk runs without any thread being created.
+//!          Chunks never contain fewer than minChunk elements. nbWorkers <= 0 selects getNbWorkers().
+//!
+inline void parallelFor(int64_t begin, int64_t end, const std::function<void(int64_t, int64_t)>& fn,
+    int64_t minChunk = 1, int nbWorkers = 0)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+    if (nbWorkers <= 0)
+    {
+        nbWorkers = getNbWorkers();
+    }
+    const int64_t count = end - begin;
+    const int64_t nbChunks = std::max<int64_t>(1, std::min<int64_t>(nbWorkers, count / std::max<int64_t>(minChunk, 1)));
+    const int64_t chunk = (count + nbChunks - 1) / nbChunks;
+
+    std::vector<std::thread> workers;
+    workers.reserve(nbChunks - 1);
+    for (int64_t first = begin + chunk; first < end; first += chunk)
+    {
+        workers.emplace_back(fn, first, std::min(first + chunk, end));
+    }
+    fn(begin, std::min(begin + chunk, end));
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+}
+
+} // namespace samplesCommon
+
+#endif // PARALLEL_FOR_H
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include "parallelFor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRT_QUANTIZE_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define TRT_QUANTIZE_NEON 1
+#include <arm_neon.h>
+#endif
+
+//!
+//! \file quantize.h
+//!
+//! Host side int8 quantization, per tensor or per channel:
+//!
+//!     q = saturate(round(x / scale) + zeroPoint)     x = (q - zeroPoint) * scale
+//!
+//! round() rounds to nearest even and saturate() clamps to [-128, 127], NaNs giving -128. All the code paths give
+//! the same results.
+//!
+namespace samplesCommon
+{
+
+//!
+//! \brief Instruction sets the quantization kernels are written for.
+//!
+enum class QuantizeIsa
+{
+    kAUTO,   //!< Best instruction set supported by the CPU
+    kSCALAR, //!< Portable C++
+    kSSE41,  //!< x86 SSE4.1
+    kAVX2,   //!< x86 AVX2
+    kNEON    //!< ARM NEON, AArch64 only
+};
+
+namespace quantize
+{
+
+//! Elements handed to a worker at least, below which threads cost more than they save.
+constexpr int64_t kMIN_ELEMENTS_PER_WORKER{1 << 18};
+
+inline int8_t quantizeValue(float x, float scale, float zeroPoint)
+{
+    float v = std::nearbyint(x / scale) + zeroPoint;
+    // Same comparisons as maxps/minps, so that NaNs saturate like in the SIMD kernels.
+    v = v > -128.F ? v : -128.F;
+    v = v < 127.F ? v : 127.F;
+    return static_cast<int8_t>(v);
+}
+
+inline void quantizeScalar(const float* src, int8_t* dst, int64_t n, float scale, float zeroPoint)
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        dst[i] = quantizeValue(src[i], scale, zeroPoint);
+    }
+}
+
+inline void dequantizeScalar(const int8_t* src, float* dst, int64_t n, float scale, float zeroPoint)
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        dst[i] = (static_cast<float>(src[i]) - zeroPoint) * scale;
+    }
+}
+
+#if TRT_QUANTIZE_X86
+__attribute__((target("sse4.1"))) inline __m128i quantize4(const float* src, __m128 scale, __m128 zeroPoint)
+{
+    __m128 v = _mm_round_ps(_mm_div_ps(_mm_loadu_ps(src), scale), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    v = _mm_min_ps(_mm_max_ps(_mm_add_ps(v, zeroPoint), _mm_set1_ps(-128.F)), _mm_set1_ps(127.F));
+    return _mm_cvttps_epi32(v);
+}
+
+__attribute__((target("sse4.1"))) inline void quantizeSSE41(
+    const float* src, int8_t* dst, int64_t n, float scale, float zeroPoint)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 z = _mm_set1_ps(zeroPoint);
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i low = _mm_packs_epi32(quantize4(src + i, s, z), quantize4(src + i + 4, s, z));
+        const __m128i high = _mm_packs_epi32(quantize4(src + i + 8, s, z), quantize4(src + i + 12, s, z));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi16(low, high));
+    }
+    quantizeScalar(src + i, dst + i, n - i, scale, zeroPoint);
+}
+
+__attribute__((target("sse4.1"))) inline void dequantizeSSE41(
+    const int8_t* src, float* dst, int64_t n, float scale, float zeroPoint)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 z = _mm_set1_ps(zeroPoint);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        int32_t bytes;
+        std::memcpy(&bytes, src + i, sizeof(bytes));
+        const __m128 q = _mm_cvtepi32_ps(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(bytes)));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_sub_ps(q, z), s));
+    }
+    dequantizeScalar(src + i, dst + i, n - i, scale, zeroPoint);
+}
+
+__attribute__((target("avx2"))) inline __m256i quantize8(const float* src, __m256 scale, __m256 zeroPoint)
+{
+    __m256 v = _mm256_round_ps(
+        _mm256_div_ps(_mm256_loadu_ps(src), scale), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    v = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(v, zeroPoint), _mm256_set1_ps(-128.F)), _mm256_set1_ps(127.F));
+    return _mm256_cvttps_epi32(v);
+}
+
+__attribute__((target("avx2"))) inline void quantizeAVX2(
+    const float* src, int8_t* dst, int64_t n, float scale, float zeroPoint)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 z = _mm256_set1_ps(zeroPoint);
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        // packs works within 128-bit lanes, the permutation puts the 16 values back in order.
+        const __m256i words = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(quantize8(src + i, s, z), quantize8(src + i + 8, s, z)), 0xD8);
+        const __m128i bytes = _mm_packs_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+    }
+    quantizeScalar(src + i, dst + i, n - i, scale, zeroPoint);
+}
+
+__attribute__((target("avx2"))) inline void dequantizeAVX2(
+    const int8_t* src, float* dst, int64_t n, float scale, float zeroPoint)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 z = _mm256_set1_ps(zeroPoint);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        const __m256 q = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(bytes));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_sub_ps(q, z), s));
+    }
+    dequantizeScalar(src + i, dst + i, n - i, scale, zeroPoint);
+}
+#endif // TRT_QUANTIZE_X86
+
+#if TRT_QUANTIZE_NEON
+inline int32x4_t quantize4(const float* src, float32x4_t scale, float32x4_t zeroPoint)
+{
+    float32x4_t v = vaddq_f32(vrndnq_f32(vdivq_f32(vld1q_f32(src), scale)), zeroPoint);
+    // vmaxq/vminq propagate NaNs, send them to -128 explicitly like the other kernels.
+    v = vbslq_f32(vcgtq_f32(v, vdupq_n_f32(-128.F)), v, vdupq_n_f32(-128.F));
+    v = vbslq_f32(vcltq_f32(v, vdupq_n_f32(127.F)), v, vdupq_n_f32(127.F));
+    return vcvtq_s32_f32(v);
+}
+
+inline void quantizeNEON(const float* src, int8_t* dst, int64_t n, float scale, float zeroPoint)
+{
+    const float32x4_t s = vdupq_n_f32(scale);
+    const float32x4_t z = vdupq_n_f32(zeroPoint);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const int16x8_t words
+            = vcombine_s16(vqmovn_s32(quantize4(src + i, s, z)), vqmovn_s32(quantize4(src + i + 4, s, z)));
+        vst1_s8(dst + i, vqmovn_s16(words));
+    }
+    quantizeScalar(src + i, dst + i, n - i, scale, zeroPoint);
+}
+
+inline void dequantizeNEON(const int8_t* src, float* dst, int64_t n, float scale, float zeroPoint)
+{
+    const float32x4_t s = vdupq_n_f32(scale);
+    const float32x4_t z = vdupq_n_f32(zeroPoint);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const int16x8_t words = vmovl_s8(vld1_s8(src + i));
+        const float32x4_t low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(words)));
+        const float32x4_t high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(words)));
+        vst1q_f32(dst + i, vmulq_f32(vsubq_f32(low, z), s));
+        vst1q_f32(dst + i + 4, vmulq_f32(vsubq_f32(high, z), s));
+    }
+    dequantizeScalar(src + i, dst + i, n - i, scale, zeroPoint);
+}
+#endif // TRT_QUANTIZE_NEON
+
+} // namespace quantize
+
+//!
+//! \brief Returns whether the CPU can run the kernels of isa.
+//!
+inline bool isQuantizeIsaSupported(QuantizeIsa isa)
+{
+    switch (isa)
+    {
+    case QuantizeIsa::kAUTO:
+    case QuantizeIsa::kSCALAR: return true;
+#if TRT_QUANTIZE_X86
+    case QuantizeIsa::kSSE41: return __builtin_cpu_supports("sse4.1");
+    case QuantizeIsa::kAVX2: return __builtin_cpu_supports("avx2");
+#endif
+#if TRT_QUANTIZE_NEON
+    case QuantizeIsa::kNEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+namespace quantize
+{
+
+using QuantizeKernel = void (*)(const float*, int8_t*, int64_t, float, float);
+using DequantizeKernel = void (*)(const int8_t*, float*, int64_t, float, float);
+
+inline QuantizeIsa resolveIsa(QuantizeIsa isa)
+{
+    if (isa == QuantizeIsa::kAUTO)
+    {
+        static const QuantizeIsa best = [] {
+            for (auto candidate : {QuantizeIsa::kAVX2, QuantizeIsa::kSSE41, QuantizeIsa::kNEON})
+            {
+                if (isQuantizeIsaSupported(candidate))
+                {
+                    return candidate;
+                }
+            }
+            return QuantizeIsa::kSCALAR;
+        }();
+        return best;
+    }
+    return isQuantizeIsaSupported(isa) ? isa : QuantizeIsa::kSCALAR;
+}
+
+inline QuantizeKernel getQuantizeKernel(QuantizeIsa isa)
+{
+    switch (resolveIsa(isa))
+    {
+#if TRT_QUANTIZE_X86
+    case QuantizeIsa::kSSE41: return quantizeSSE41;
+    case QuantizeIsa::kAVX2: return quantizeAVX2;
+#endif
+#if TRT_QUANTIZE_NEON
+    case QuantizeIsa::kNEON: return quantizeNEON;
+#endif
+    default: return quantizeScalar;
+    }
+}
+
+inline DequantizeKernel getDequantizeKernel(QuantizeIsa isa)
+{
+    switch (resolveIsa(isa))
+    {
+#if TRT_QUANTIZE_X86
+    case QuantizeIsa::kSSE41: return dequantizeSSE41;
+    case QuantizeIsa::kAVX2: return dequantizeAVX2;
+#endif
+#if TRT_QUANTIZE_NEON
+    case QuantizeIsa::kNEON: return dequantizeNEON;
+#endif
+    default: return dequantizeScalar;
+    }
+}
+
+} // namespace quantize
+
+//!
+//! \brief Quantize n floats with one scale and zero point.
+//!
+//! \details Large tensors are split over up to nbWorkers threads, nbWorkers <= 0 selecting one per CPU.
+//!
+inline void quantizeInt8(const float* src, int8_t* dst, int64_t n, float scale, int zeroPoint = 0,
+    int nbWorkers = 0, QuantizeIsa isa = QuantizeIsa::kAUTO)
+{
+    const quantize::QuantizeKernel kernel = quantize::getQuantizeKernel(isa);
+    const float z = static_cast<float>(zeroPoint);
+    parallelFor(0, n, [&](int64_t first, int64_t last) { kernel(src + first, dst + first, last - first, scale, z); },
+        quantize::kMIN_ELEMENTS_PER_WORKER, nbWorkers);
+}
+
+//!
+//! \brief Dequantize n int8 values with one scale and zero point.
+//!
+inline void dequantizeInt8(const int8_t* src, float* dst, int64_t n, float scale, int zeroPoint = 0,
+    int nbWorkers = 0, QuantizeIsa isa = QuantizeIsa::kAUTO)
+{
+    const quantize::DequantizeKernel kernel = quantize::getDequantizeKernel(isa);
+    const float z = static_cast<float>(zeroPoint);
+    parallelFor(0, n, [&](int64_t first, int64_t last) { kernel(src + first, dst + first, last - first, scale, z); },
+        quantize::kMIN_ELEMENTS_PER_WORKER, nbWorkers);
+}
+
+//!
+//! \brief Quantize a tensor of outer x channels x inner floats with a scale, and optionally a zero point, per channel.
+//!
+//! \param zeroPoints Zero point of each channel, or nullptr for zeros.
+//!
+inline void quantizeInt8PerChannel(const float* src, int8_t* dst, int64_t outer, int channels, int64_t inner,
+    const float* scales, const int* zeroPoints = nullptr, int nbWorkers = 0, QuantizeIsa isa = QuantizeIsa::kAUTO)
+{
+    const quantize::QuantizeKernel kernel = quantize::getQuantizeKernel(isa);
+    const int64_t minRows = std::max<int64_t>(1, quantize::kMIN_ELEMENTS_PER_WORKER / std::max<int64_t>(inner, 1));
+    parallelFor(0, outer * channels,
+        [&](int64_t first, int64_t last) {
+            for (int64_t row = first; row < last; ++row)
+            {
+                const int c = static_cast<int>(row % channels);
+                const float z = zeroPoints ? static_cast<float>(zeroPoints[c]) : 0.F;
+                kernel(src + row * inner, dst + row * inner, inner, scales[c], z);
+            }
+        },
+        minRows, nbWorkers);
+}
+
+//!
+//! \brief Dequantize a tensor of outer x channels x inner int8 values with a scale, and optionally a zero point,
+//!        per channel.
+//!
+inline void dequantizeInt8PerChannel(const int8_t* src, float* dst, int64_t outer, int channels, int64_t inner,
+    const float* scales, const int* zeroPoints = nullptr, int nbWorkers = 0, QuantizeIsa isa = QuantizeIsa::kAUTO)
+{
+    const quantize::DequantizeKernel kernel = quantize::getDequantizeKernel(isa);
+    const int64_t minRows = std::max<int64_t>(1, quantize::kMIN_ELEMENTS_PER_WORKER / std::max<int64_t>(inner, 1));
+    parallelFor(0, outer * channels,
+        [&](int64_t first, int64_t last) {
+            for (int64_t row = first; row < last; ++row)
+            {
+                const int c = static_cast<int>(row % channels);
+                const float z = zeroPoints ? static_cast<float>(zeroPoints[c]) : 0.F;
+                kernel(src + row * inner, dst + row * inner, inner, scales[c], z);
+            }
+        },
+        minRows, nbWorkers);
+}
+
+} // namespace samplesCommon
+
+#endif // QUANTIZE_H
@@ -47,6 +47,7 @@
  * Users Notice.
  */
 
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <random>
@@ -55,12 +56,15 @@
 #include <string>
 #include <map>
 #include <cuda.h>
+#include <cuda_runtime_api.h>
 
 #include "NvInfer.h"
 #include "NvCaffeParser.h"
 #include "NvOnnxParser.h"
 #include "NvUffParser.h"
 
+#include "calibrationTable.h"
+#include "engineCache.h"
 #include "logger.h"
 #include "sampleUtils.h"
 #include "sampleOptions.h"
@@ -243,16 +247,9 @@ bool RndInt8Calibrator::getBatch(void* bindings[], const char* names[], int nbBi
 
 const void* RndInt8Calibrator::readCalibrationCache(size_t& length)
 {
-    mCalibrationCache.clear();
-    std::ifstream input(mCacheFile, std::ios::binary);
-    input >> std::noskipws;
-    if (input.good())
-    {
-        std::copy(std::istream_iterator<char>(input), std::istream_iterator<char>(),
-            std::back_inserter(mCalibrationCache));
-    }
-
-    return mCalibrationCache.size() ? mCalibrationCache.data() : nullptr;
+    samplesCommon::readFile(mCacheFile, mCalibrationCache);
+    length = mCalibrationCache.size();
+    return length ? mCalibrationCache.data() : nullptr;
 }
 
 void setTensorScales(const INetworkDefinition& network, float inScales = 2.0f, float outScales = 4.0f)
@@ -436,7 +433,10 @@ ICudaEngine* networkToEngine(const BuildOptions& build, const SystemOptions& sys
     return builder.buildEngineWithConfig(network, *config);
 }
 
-ICudaEngine* modelToEngine(const ModelOptions& model, const BuildOptions& build, const SystemOptions& sys, std::ostream& err)
+namespace
+{
+
+ICudaEngine* buildEngine(const ModelOptions& model, const BuildOptions& build, const SystemOptions& sys, std::ostream& err)
 {
     unique_ptr<IBuilder> builder{createInferBuilder(gLogger.getTRTLogger())};
     if (builder == nullptr)
@@ -461,34 +461,101 @@ ICudaEngine* modelToEngine(const ModelOptions& model, const BuildOptions& build,
     return networkToEngine(build, sys, *builder, *network, err);
 }
 
-ICudaEngine* loadEngine(const std::string& engine, int DLACore, std::ostream& err)
+//!
+//! \brief What besides the options makes engines incompatible: the library version and the GPU
+//!
+std::string getPlatform()
 {
-    std::ifstream engineFile(engine, std::ios::binary);
-    if (!engineFile)
+    int device{0};
+    cudaDeviceProp properties{};
+    cudaGetDevice(&device);
+    cudaGetDeviceProperties(&properties, device);
+    return "TensorRT " + std::to_string(getInferLibVersion()) + " " + properties.name + " sm_"
+        + std::to_string(properties.major) + std::to_string(properties.minor);
+}
+
+using TimePoint = std::chrono::high_resolution_clock::time_point;
+
+//!
+//! \brief Deserialize an engine straight from the mapping of its plan and report how long it took
+//!
+//! \details The plan is only paged in as the runtime reads it, so no heap copy of the whole file is ever made, and
+//!          the pages can be dropped by the kernel as soon as the mapping is released.
+//!
+ICudaEngine* deserializeEngine(samplesCommon::MappedFile& plan, int DLACore, const TimePoint& start)
+{
+    unique_ptr<IRuntime> runtime{createInferRuntime(gLogger.getTRTLogger())};
+    if (DLACore != -1)
     {
-        err << "Error opening engine file: " << engine << std::endl;
-        return nullptr;
+        runtime->setDLACore(DLACore);
     }
 
-    engineFile.seekg(0, engineFile.end);
-    long int fsize = engineFile.tellg();
-    engineFile.seekg(0, engineFile.beg);
+    ICudaEngine* engine = runtime->deserializeCudaEngine(plan.data(), plan.size(), nullptr);
+    const size_t size = plan.size();
+    const bool mapped = plan.isMapped();
+    plan.close();
 
-    std::vector<char> engineData(fsize);
-    engineFile.read(engineData.data(), fsize);
-    if (!engineFile)
+    const auto end = std::chrono::high_resolution_clock::now();
+    const float ms = std::chrono::duration<float, std::milli>(end - start).count();
+    gLogInfo << "Engine deserialized in " << ms << " ms from " << (size >> 20) << " MB " << (mapped ? "mapped" : "read")
+             << std::endl;
+    return engine;
+}
+
+} // namespace
+
+ICudaEngine* modelToEngine(const ModelOptions& model, const BuildOptions& build, const SystemOptions& sys, std::ostream& err)
+{
+    if (build.cacheDir.empty())
     {
-        err << "Error loading engine file: " << engine << std::endl;
-        return nullptr;
+        return buildEngine(model, build, sys, err);
     }
 
-    unique_ptr<IRuntime> runtime{createInferRuntime(gLogger.getTRTLogger())};
-    if (DLACore != -1)
+    std::string key;
+    if (!computeEngineKey(model, build, sys, getPlatform(), key, err))
     {
-        runtime->setDLACore(DLACore);
+        gLogWarning << "Engine cache disabled" << std::endl;
+        return buildEngine(model, build, sys, err);
+    }
+    EngineCache cache(build.cacheDir, static_cast<size_t>(build.cacheSize) << 20);
+    samplesCommon::MappedFile cached;
+    const auto start = std::chrono::high_resolution_clock::now();
+    if (cache.load(key, cached))
+    {
+        ICudaEngine* engine = deserializeEngine(cached, sys.DLACore, start);
+        if (engine)
+        {
+            gLogInfo << "Engine cache hit: " << key << std::endl;
+            return engine;
+        }
+        gLogWarning << "Dropping cached engine " << key << " that could not be deserialized" << std::endl;
+        cache.remove(key);
+    }
+    gLogInfo << "Engine cache miss: " << key << std::endl;
+
+    ICudaEngine* engine = buildEngine(model, build, sys, err);
+    if (engine)
+    {
+        unique_ptr<IHostMemory> serializedEngine{engine->serialize()};
+        if (!serializedEngine || !cache.store(key, serializedEngine->data(), serializedEngine->size(), err))
+        {
+            gLogWarning << "Engine could not be added to the cache" << std::endl;
+        }
+    }
+    return engine;
+}
+
+ICudaEngine* loadEngine(const std::string& engine, int DLACore, std::ostream& err)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    samplesCommon::MappedFile plan;
+    if (!plan.open(engine, samplesCommon::MappedFile::Advice::kSEQUENTIAL))
+    {
+        err << "Error opening engine file: " << engine << std::endl;
+        return nullptr;
     }
 
-    return runtime->deserializeCudaEngine(engineData.data(), fsize, nullptr);
+    return deserializeEngine(plan, DLACore, start);
 }
 
 bool saveEngine(const ICudaEngine& engine, const std::string& fileName, std::ostream& err)
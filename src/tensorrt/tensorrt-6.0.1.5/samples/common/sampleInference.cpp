@@ -0,0 +1,377 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "NvInfer.h"
+
+#include "common.h"
+#include "sampleInference.h"
+
+using namespace nvinfer1;
+
+namespace sample
+{
+
+namespace
+{
+
+void CUDART_CB sleepCallback(void* ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(*static_cast<int*>(ms)));
+}
+
+} // namespace
+
+TrtStreamExecutor::TrtStreamExecutor(ICudaEngine& engine, const InferenceOptions& inference, IProfiler* profiler)
+    : mContext(engine.createExecutionContext())
+    , mBatch(inference.batch)
+    , mSleep(inference.sleep)
+{
+    if (profiler)
+    {
+        mContext->setProfiler(profiler);
+    }
+
+    for (int b = 0; b < engine.getNbBindings(); ++b)
+    {
+        if (!engine.bindingIsInput(b))
+        {
+            continue;
+        }
+        auto dims = mContext->getBindingDimensions(b);
+        if (dims.d[0] == -1)
+        {
+            // setUpInference checked that the shape is there
+            dims.d[0] = inference.shapes.find(engine.getBindingName(b))->second.d[0];
+            mContext->setBindingDimensions(b, dims);
+        }
+    }
+
+    // Use an aliasing shared_ptr since we don't want engine to be deleted when the buffers go out of scope.
+    std::shared_ptr<ICudaEngine> emptyPtr{};
+    std::shared_ptr<ICudaEngine> aliasPtr(emptyPtr, &engine);
+    mBuffers.reset(new samplesCommon::BufferManager(aliasPtr, mBatch, mBatch ? nullptr : mContext.get()));
+
+    CHECK(cudaStreamCreate(&mStream));
+    const unsigned int eventFlags = inference.spin ? cudaEventDefault : cudaEventBlockingSync;
+    CHECK(cudaEventCreateWithFlags(&mStart, eventFlags));
+    CHECK(cudaEventCreateWithFlags(&mEnd, eventFlags));
+}
+
+TrtStreamExecutor::~TrtStreamExecutor()
+{
+    cudaEventDestroy(mEnd);
+    cudaEventDestroy(mStart);
+    cudaStreamDestroy(mStream);
+}
+
+bool TrtStreamExecutor::enqueue()
+{
+    if (mSleep > 0)
+    {
+        // Holds the stream, not the host thread, so that other executors keep running
+        if (cudaLaunchHostFunc(mStream, sleepCallback, &mSleep) != cudaSuccess)
+        {
+            return false;
+        }
+    }
+    cudaEventRecord(mStart, mStream);
+    std::vector<void*>& bindings = mBuffers->getDeviceBindings();
+    const bool status = mBatch ? mContext->enqueue(mBatch, bindings.data(), mStream, nullptr)
+                               : mContext->enqueueV2(bindings.data(), mStream, nullptr);
+    cudaEventRecord(mEnd, mStream);
+    return status;
+}
+
+bool TrtStreamExecutor::synchronize(float& gpuTime)
+{
+    return cudaEventSynchronize(mEnd) == cudaSuccess && cudaEventElapsedTime(&gpuTime, mStart, mEnd) == cudaSuccess;
+}
+
+InferenceSchedule InferenceSchedule::fromOptions(const InferenceOptions& inference)
+{
+    InferenceSchedule schedule;
+    schedule.warmup = static_cast<float>(inference.warmup);
+    schedule.duration = 1000.F * inference.duration;
+    schedule.iterations = inference.iterations;
+    schedule.threads = inference.threads ? inference.streams : 1;
+    schedule.qps = inference.qps;
+    schedule.poisson = inference.poisson;
+    schedule.seed = inference.seed;
+    return schedule;
+}
+
+bool setUpInference(ICudaEngine& engine, const InferenceOptions& inference, IProfiler* profiler,
+    std::vector<std::unique_ptr<TrtStreamExecutor>>& executors, std::ostream& err)
+{
+    for (int b = 0; b < engine.getNbBindings(); ++b)
+    {
+        if (engine.bindingIsInput(b) && engine.getBindingDimensions(b).d[0] == -1
+            && inference.shapes.find(engine.getBindingName(b)) == inference.shapes.end())
+        {
+            err << "Missing dynamic batch size in inference" << std::endl;
+            return false;
+        }
+    }
+
+    executors.clear();
+    for (int s = 0; s < inference.streams; ++s)
+    {
+        // Per layer times of concurrent contexts would be mixed up, profile the first one only
+        executors.emplace_back(new TrtStreamExecutor(engine, inference, s == 0 ? profiler : nullptr));
+    }
+    return true;
+}
+
+bool runInference(const std::vector<IStreamExecutor*>& executors, const InferenceSchedule& schedule,
+    const TraceCallback& onTrace, std::ostream& err)
+{
+    using clock = std::chrono::high_resolution_clock;
+    if (executors.empty())
+    {
+        err << "No stream to run inference on" << std::endl;
+        return false;
+    }
+    const int nbThreads = std::max(1, std::min(schedule.threads, static_cast<int>(executors.size())));
+    std::atomic<bool> failed{false};
+    std::mutex traceMutex;
+
+    const clock::time_point start = clock::now();
+    const auto sinceStart = [&start](clock::time_point t) {
+        return std::chrono::duration<double, std::milli>(t - start).count();
+    };
+
+    const auto drive = [&](int thread) {
+        std::vector<int> mine;
+        for (int e = thread; e < static_cast<int>(executors.size()); e += nbThreads)
+        {
+            mine.push_back(e);
+        }
+        std::vector<double> launches(mine.size());
+        std::vector<float> enqueueTimes(mine.size());
+        std::vector<int> recorded(mine.size(), 0);
+
+        while (!failed)
+        {
+            for (size_t i = 0; i < mine.size(); ++i)
+            {
+                launches[i] = sinceStart(clock::now());
+                if (!executors[mine[i]]->enqueue())
+                {
+                    failed = true;
+                }
+                enqueueTimes[i] = static_cast<float>(sinceStart(clock::now()) - launches[i]);
+            }
+            for (size_t i = 0; i < mine.size(); ++i)
+            {
+                float gpuTime{0};
+                if (!executors[mine[i]]->synchronize(gpuTime))
+                {
+                    failed = true;
+                    continue;
+                }
+                const double end = sinceStart(clock::now());
+                if (launches[i] >= schedule.warmup)
+                {
+                    InferenceTrace trace;
+                    trace.stream = mine[i];
+                    trace.arrival = launches[i];
+                    trace.hostStart = launches[i];
+                    trace.hostEnd = end;
+                    trace.enqueueTime = enqueueTimes[i];
+                    trace.gpuTime = gpuTime;
+                    ++recorded[i];
+                    std::lock_guard<std::mutex> lock(traceMutex);
+                    onTrace(trace);
+                }
+            }
+
+            const bool measured = sinceStart(clock::now()) >= schedule.warmup + schedule.duration;
+            if (measured && *std::min_element(recorded.begin(), recorded.end()) >= schedule.iterations)
+            {
+                break;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < nbThreads; ++t)
+    {
+        threads.emplace_back(drive, t);
+    }
+    drive(0);
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (failed)
+    {
+        err << "Inference failed on at least one stream" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool runOpenLoopInference(const std::vector<IStreamExecutor*>& executors, const InferenceSchedule& schedule,
+    const TraceCallback& onTrace, OpenLoopStats& stats, std::ostream& err, IInferenceClock* clock)
+{
+    if (executors.empty() || schedule.qps <= 0)
+    {
+        err << "Open loop inference needs streams and a positive rate" << std::endl;
+        return false;
+    }
+    std::atomic<bool> failed{false};
+    std::mutex mutex; // Guards the arrivals, the stats and the callback
+    const double end = schedule.warmup + schedule.duration;
+    const double period = 1000. / schedule.qps;
+    std::mt19937_64 rng(schedule.seed);
+    std::exponential_distribution<double> gaps(1. / period);
+    int64_t next{0};
+    double nextArrival{0};
+    int64_t served{0};
+    stats = OpenLoopStats();
+
+    SteadyInferenceClock steadyClock;
+    IInferenceClock& time = clock ? *clock : steadyClock;
+
+    const auto drive = [&](int stream) {
+        IStreamExecutor& executor = *executors[stream];
+        struct Detach
+        {
+            IInferenceClock& time;
+            ~Detach() { time.detach(); }
+        } detach{time};
+        while (!failed)
+        {
+            double arrival{0};
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                // Arrivals are taken in order, the queue of due ones is the range before the current time
+                arrival = nextArrival;
+                ++next;
+                nextArrival = schedule.poisson ? nextArrival + gaps(rng) : next * period;
+                if (arrival >= end)
+                {
+                    break;
+                }
+                if (arrival >= schedule.warmup)
+                {
+                    ++stats.arrivals;
+                }
+            }
+
+            time.sleepUntil(arrival);
+            InferenceTrace trace;
+            trace.stream = stream;
+            trace.arrival = arrival;
+            trace.hostStart = time.now();
+            if (trace.hostStart >= end)
+            {
+                // The measurement is over, the arrivals still queued are not served
+                break;
+            }
+            if (!executor.enqueue())
+            {
+                failed = true;
+                break;
+            }
+            trace.enqueueTime = static_cast<float>(time.now() - trace.hostStart);
+            if (!executor.synchronize(trace.gpuTime))
+            {
+                failed = true;
+                break;
+            }
+            trace.hostEnd = time.now();
+            if (arrival >= schedule.warmup)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++served;
+                onTrace(trace);
+            }
+        }
+    };
+
+    for (size_t s = 0; s < executors.size(); ++s)
+    {
+        time.attach();
+    }
+    std::vector<std::thread> threads;
+    for (int s = 1; s < static_cast<int>(executors.size()); ++s)
+    {
+        threads.emplace_back(drive, s);
+    }
+    drive(0);
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (failed)
+    {
+        err << "Inference failed on at least one stream" << std::endl;
+        return false;
+    }
+    // Arrivals nobody took before the end are due all the same
+    for (; nextArrival < end; ++next)
+    {
+        stats.arrivals += nextArrival >= schedule.warmup ? 1 : 0;
+        nextArrival = schedule.poisson ? nextArrival + gaps(rng) : (next + 1) * period;
+    }
+    stats.unserved = stats.arrivals - served;
+    return true;
+}
+
+} // namespace sample
@@ -0,0 +1,324 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_INFERENCE_H
+#define TRT_SAMPLE_INFERENCE_H
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cuda_runtime_api.h>
+
+#include "NvInfer.h"
+
+#include "buffers.h"
+#include "sampleOptions.h"
+#include "sampleUtils.h"
+
+namespace sample
+{
+
+//!
+//! \brief Host and device timing of one inference
+//!
+struct InferenceTrace
+{
+    int stream{0};          //!< Index of the executor that ran the inference
+    double arrival{0};      //!< Time the inference was due, in ms since the start of the run
+    double hostStart{0};    //!< Host time of the launch, in ms since the start of the run
+    double hostEnd{0};      //!< Host time the inference was seen complete, in ms since the start of the run
+    float enqueueTime{0};   //!< Host time spent launching the inference, in ms
+    float gpuTime{0};       //!< Compute time measured on the device, in ms
+
+    //!
+    //! \brief Time from the arrival to the completion, the launch time in closed loop
+    //!
+    float latency() const { return static_cast<float>(hostEnd - arrival); }
+
+    //!
+    //! \brief Time spent waiting for a free executor, 0 in closed loop
+    //!
+    float queueTime() const { return static_cast<float>(hostStart - arrival); }
+};
+
+//!
+//! \brief Interface of something that runs inferences, one at a time, on its own stream
+//!
+//! \details The scheduler launches an inference with enqueue() and later collects it with synchronize(), so that one
+//!          host thread can keep several executors busy at once.
+//!
+class IStreamExecutor
+{
+public:
+    virtual ~IStreamExecutor() = default;
+
+    //!
+    //! \brief Launch one inference without waiting for it
+    //!
+    virtual bool enqueue() = 0;
+
+    //!
+    //! \brief Wait for the inference launched last and return its compute time in ms
+    //!
+    virtual bool synchronize(float& gpuTime) = 0;
+};
+
+//!
+//! \brief Executor running an engine with its own execution context, bindings and stream
+//!
+class TrtStreamExecutor : public IStreamExecutor
+{
+public:
+    //!
+    //! \param profiler Profiler attached to the context, or nullptr
+    //!
+    TrtStreamExecutor(nvinfer1::ICudaEngine& engine, const InferenceOptions& inference, nvinfer1::IProfiler* profiler);
+
+    ~TrtStreamExecutor() override;
+
+    bool enqueue() override;
+
+    bool synchronize(float& gpuTime) override;
+
+    samplesCommon::BufferManager& getBuffers() { return *mBuffers; }
+
+private:
+    unique_ptr<nvinfer1::IExecutionContext> mContext;
+    std::unique_ptr<samplesCommon::BufferManager> mBuffers;
+    cudaStream_t mStream{nullptr};
+    cudaEvent_t mStart{nullptr};
+    cudaEvent_t mEnd{nullptr};
+    int mBatch{0};
+    int mSleep{0}; //!< Gap in ms between the launch and the start of the compute
+};
+
+//!
+//! \brief Time source of the open loop scheduler, in ms since the start of the run
+//!
+//! \details The scheduler attaches one thread per executor before starting them, and each thread detaches when it
+//!          stops, so that a simulated clock can tell when all of them are waiting and move time forward.
+//!
+class IInferenceClock
+{
+public:
+    virtual ~IInferenceClock() = default;
+
+    virtual double now() = 0;
+
+    //!
+    //! \brief Block the calling thread until now() reaches time
+    //!
+    virtual void sleepUntil(double time) = 0;
+
+    virtual void attach() {}
+
+    virtual void detach() {}
+};
+
+//!
+//! \brief Wall clock, started at construction
+//!
+class SteadyInferenceClock : public IInferenceClock
+{
+public:
+    double now() override
+    {
+        return std::chrono::duration<double, std::milli>(clock::now() - mStart).count();
+    }
+
+    void sleepUntil(double time) override
+    {
+        std::this_thread::sleep_until(
+            mStart + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(time)));
+    }
+
+private:
+    using clock = std::chrono::high_resolution_clock;
+
+    clock::time_point mStart{clock::now()};
+};
+
+//!
+//! \brief CPU stand-in for an executor, running a host function in place of the engine
+//!
+//! \details The function runs on the scheduling thread in enqueue(), its duration being reported as compute time.
+//!          It lets the scheduler and the reports be exercised without a GPU.
+//!
+class CpuStreamExecutor : public IStreamExecutor
+{
+public:
+    explicit CpuStreamExecutor(std::function<bool()> work)
+        : mWork(std::move(work))
+    {
+    }
+
+    //!
+    //! \brief Stand-in sleeping for serviceTime ms per inference
+    //!
+    explicit CpuStreamExecutor(float serviceTime)
+        : mWork([serviceTime] {
+            std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(serviceTime));
+            return true;
+        })
+    {
+    }
+
+    //!
+    //! \brief Stand-in taking serviceTime ms of the given clock per inference, which it also times the work with
+    //!
+    CpuStreamExecutor(float serviceTime, IInferenceClock& clock)
+        : mWork([serviceTime, &clock] {
+            clock.sleepUntil(clock.now() + serviceTime);
+            return true;
+        })
+        , mClock(&clock)
+    {
+    }
+
+    bool enqueue() override
+    {
+        if (mClock)
+        {
+            const double start = mClock->now();
+            const bool ok = mWork();
+            mTime = static_cast<float>(mClock->now() - start);
+            return ok;
+        }
+        const auto start = std::chrono::high_resolution_clock::now();
+        const bool ok = mWork();
+        mTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return ok;
+    }
+
+    bool synchronize(float& gpuTime) override
+    {
+        gpuTime = mTime;
+        return true;
+    }
+
+private:
+    std::function<bool()> mWork;
+    IInferenceClock* mClock{nullptr}; //!< Clock timing the work, the wall clock if null
+    float mTime{0};
+};
+
+//!
+//! \brief Timing parameters of a run
+//!
+struct InferenceSchedule
+{
+    float warmup{0};    //!< Time in ms during which inferences run but are not recorded
+    float duration{0};  //!< Minimum time in ms of the measurement after the warm up
+    int iterations{0};  //!< Minimum number of recorded inferences per executor
+    int threads{1};     //!< Number of host threads sharing the executors
+    float qps{0};       //!< Rate of arrivals in open loop, 0 for closed loop
+    bool poisson{false}; //!< Whether open loop arrivals follow a Poisson process rather than a fixed rate
+    uint64_t seed{0};    //!< Seed of the Poisson arrivals
+
+    static InferenceSchedule fromOptions(const InferenceOptions& inference);
+};
+
+//!
+//! \brief Create one TensorRT executor per stream requested in the inference options
+//!
+//! \return False if the engine cannot run with the given options
+//!
+bool setUpInference(nvinfer1::ICudaEngine& engine, const InferenceOptions& inference, nvinfer1::IProfiler* profiler,
+    std::vector<std::unique_ptr<TrtStreamExecutor>>& executors, std::ostream& err);
+
+//!
+//! \brief Receives the trace of each inference recorded after the warm up
+//!
+//! \details Calls are serialized, so the callback needs no locking of its own, but it runs on the threads driving the
+//!          executors and should return quickly.
+//!
+using TraceCallback = std::function<void(const InferenceTrace&)>;
+
+//!
+//! \brief Run inferences on all executors following the schedule
+//!
+//! \details Executor i is driven by host thread i % schedule.threads. Each thread launches an inference on all its
+//!          executors, then waits for them in turn, until the warm up and the measurement are over and every executor
+//!          recorded its minimum number of iterations. Traces are passed to onTrace as inferences complete and are not
+//!          kept, so the memory used does not depend on the length of the run.
+//!
+//! \return False if an executor failed, in which case all threads stop
+//!
+bool runInference(const std::vector<IStreamExecutor*>& executors, const InferenceSchedule& schedule,
+    const TraceCallback& onTrace, std::ostream& err);
+
+//!
+//! \brief Counts of an open loop run, over the measurement
+//!
+struct OpenLoopStats
+{
+    int64_t arrivals{0}; //!< Inferences due during the measurement
+    int64_t unserved{0}; //!< Inferences due during the measurement and still queued at its end
+};
+
+//!
+//! \brief Run inferences arriving at schedule.qps, whether the executors keep up or not
+//!
+//! \details Arrivals are spaced by 1 / qps, or drawn from a Poisson process of that rate seeded with schedule.seed. Each
+//!          executor has its own thread, which takes the oldest arrival, sleeps until it is due and runs it. When all
+//!          executors are busy, arrivals queue up. Latencies are measured from the arrival rather than from the
+//!          launch, so that a slow engine is not hidden by a delayed load, that is, without coordinated omission.
+//!          Arrivals stop at the end of the measurement, the ones still queued being counted as unserved.
+//!
+//! \param clock Time source of the run, a wall clock started by the call if null
+//!
+bool runOpenLoopInference(const std::vector<IStreamExecutor*>& executors, const InferenceSchedule& schedule,
+    const TraceCallback& onTrace, OpenLoopStats& stats, std::ostream& err, IInferenceClock* clock = nullptr);
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_INFERENCE_H
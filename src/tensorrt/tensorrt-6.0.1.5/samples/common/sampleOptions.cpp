@@ -47,6 +47,7 @@
  * Users Notice.
  */
 
+#include <chrono>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -266,6 +267,16 @@ void BuildOptions::parse(Arguments& arguments)
     {
         throw std::invalid_argument("Incompatible load and save engine options selected");
     }
+    checkEraseOption(arguments, "--engineCache", cacheDir);
+    checkEraseOption(arguments, "--engineCacheSize", cacheSize);
+    if (load && !cacheDir.empty())
+    {
+        throw std::invalid_argument("Incompatible load engine and engine cache options selected");
+    }
+    if (cacheSize <= 0)
+    {
+        throw std::invalid_argument("Engine cache size must be positive");
+    }
 }
 
 void SystemOptions::parse(Arguments& arguments)
@@ -286,10 +297,89 @@ void InferenceOptions::parse(Arguments& arguments)
     checkEraseOption(arguments, "--iterations", iterations);
     checkEraseOption(arguments, "--duration", duration);
     checkEraseOption(arguments, "--warmUp", warmup);
+    checkEraseOption(arguments, "--sleepTime", sleep);
     checkEraseOption(arguments, "--useSpinWait", spin);
     checkEraseOption(arguments, "--threads", threads);
     checkEraseOption(arguments, "--useCudaGraph", graph);
     checkEraseOption(arguments, "--buildOnly", skip);
+    checkEraseOption(arguments, "--qps", qps);
+    std::string arrivals;
+    if (checkEraseOption(arguments, "--arrivals", arrivals))
+    {
+        if (arrivals != "fixed" && arrivals != "poisson")
+        {
+            throw std::invalid_argument(std::string("Unknown arrival process: ") + arrivals);
+        }
+        poisson = arrivals == "poisson";
+    }
+    if (qps < 0)
+    {
+        throw std::invalid_argument("Negative rate of arrivals " + std::to_string(qps));
+    }
+    std::string seedValue;
+    if (checkEraseOption(arguments, "--seed", seedValue))
+    {
+        if (seedValue.empty() || seedValue.size() > 19
+            || !std::all_of(seedValue.begin(), seedValue.end(), [](char c) { return c >= '0' && c <= '9'; }))
+        {
+            throw std::invalid_argument("Invalid seed " + seedValue);
+        }
+        seed = std::stoull(seedValue);
+    }
+    else
+    {
+        // Each run draws other arrivals, the seed printed with the options reproduces them
+        seed = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    }
+
+    std::string sweepList;
+    checkEraseOption(arguments, "--sweep", sweepList);
+    for (const auto& item : splitToStringVec(sweepList, ','))
+    {
+        if (item.empty())
+        {
+            throw std::invalid_argument("Empty batch size in sweep " + sweepList);
+        }
+        // Either N or a range A-B[:S], of plain decimal numbers so that typos such as "4-" are not read as 4
+        const auto toBatch = [&item](const std::string& value) {
+            if (value.empty() || value.size() > 9
+                || !std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; }))
+            {
+                throw std::invalid_argument("Invalid sweep range " + item);
+            }
+            return std::stoi(value);
+        };
+        const size_t dash{item.find('-')};
+        if (dash == std::string::npos)
+        {
+            sweep.push_back(toBatch(item));
+            continue;
+        }
+        const std::string bounds{item.substr(dash + 1)};
+        const size_t colon{bounds.find(':')};
+        const int first{toBatch(item.substr(0, dash))};
+        const int last{toBatch(bounds.substr(0, colon))};
+        const int step{colon == std::string::npos ? 1 : toBatch(bounds.substr(colon + 1))};
+        if (step < 1 || last < first)
+        {
+            throw std::invalid_argument("Invalid sweep range " + item);
+        }
+        for (int b = first; b <= last; b += step)
+        {
+            sweep.push_back(b);
+        }
+    }
+    std::sort(sweep.begin(), sweep.end());
+    sweep.erase(std::unique(sweep.begin(), sweep.end()), sweep.end());
+    if (!sweep.empty() && sweep.front() < 1)
+    {
+        throw std::invalid_argument("Sweep batch sizes must be positive");
+    }
+    checkEraseOption(arguments, "--sloP99", slo);
+    if (slo > 0 && sweep.empty())
+    {
+        throw std::invalid_argument("--sloP99 needs a --sweep of batch sizes to search");
+    }
 
     std::string list;
     checkEraseOption(arguments, "--shapes", list);
@@ -317,22 +407,31 @@ void InferenceOptions::parse(Arguments& arguments)
             batch = 0;
         }
     }
-
+    if (streams < 1)
+    {
+        throw std::invalid_argument("Number of streams " + std::to_string(streams) + " is not positive");
+    }
 }
 
 void ReportingOptions::parse(Arguments& arguments)
 {
     checkEraseOption(arguments, "--percentile", percentile);
     checkEraseOption(arguments, "--avgRuns", avgs);
+    checkEraseOption(arguments, "--slidingWindow", window);
     checkEraseOption(arguments, "--verbose", verbose);
     checkEraseOption(arguments, "--dumpOutput", output);
     checkEraseOption(arguments, "--dumpProfile", profile);
     checkEraseOption(arguments, "--exportTimes", exportTimes);
     checkEraseOption(arguments, "--exportProfile", exportProfile);
+    checkEraseOption(arguments, "--exportSweep", exportSweep);
     if (percentile < 0 || percentile > 100)
     {
         throw std::invalid_argument(std::string("Percentile ") + std::to_string(percentile) + "is not in [0,100]");
     }
+    if (window < 0)
+    {
+        throw std::invalid_argument(std::string("Sliding window ") + std::to_string(window) + " is negative");
+    }
 }
 
 bool parseHelp(Arguments& arguments)
@@ -651,7 +750,9 @@ std::ostream& operator<<(std::ostream& os, const BuildOptions& options)
           "Calibration: "    << (options.int8 && options.calibration.empty() ? "Dynamic" : options.calibration.c_str()) << std::endl <<
           "Safe mode: "      << boolToEnabled(options.safe)                                                             << std::endl <<
           "Save engine: "    << (options.save ? options.engine : "")                                                    << std::endl <<
-          "Load engine: "    << (options.load ? options.engine : "")                                                    << std::endl;
+          "Load engine: "    << (options.load ? options.engine : "")                                                    << std::endl <<
+          "Engine cache: "   << (options.cacheDir.empty() ? ""
+                              : options.cacheDir + " (" + std::to_string(options.cacheSize) + " MB)")                   << std::endl;
 // clang-format on
 
     auto printIOFormats = [](std::ostream& os, const char* direction, const std::vector<IOFormat> formats)
@@ -717,7 +818,15 @@ std::ostream& operator<<(std::ostream& os, const InferenceOptions& options)
           "Spin-wait: "      << boolToEnabled(options.spin)                  << std::endl <<
           "Multithreading: " << boolToEnabled(options.threads)               << std::endl <<
           "CUDA Graph: "     << boolToEnabled(options.graph)                 << std::endl <<
-          "Skip inference: " << boolToEnabled(options.skip)                  << std::endl;
+          "Open loop: "      << (options.qps > 0 ? std::to_string(options.qps) + " qps, "
+                              + (options.poisson ? "poisson arrivals, seed " + std::to_string(options.seed) : "fixed arrivals")
+                              : "Disabled")                                  << std::endl <<
+          "Skip inference: " << boolToEnabled(options.skip)                  << std::endl <<
+          "Sweep: "          << (options.sweep.empty() ? std::string("Disabled")
+                              : std::to_string(options.sweep.size()) + " batch sizes, from "
+                              + std::to_string(options.sweep.front()) + " to " + std::to_string(options.sweep.back()))
+                                                                             << std::endl <<
+          "p99 target: "     << (options.slo > 0 ? std::to_string(options.slo) + " ms" : "Disabled") << std::endl;
 // clang-format on
     if (options.batch)
     {
@@ -733,12 +842,15 @@ std::ostream& operator<<(std::ostream& os, const ReportingOptions& options)
     os << "=== Reporting Options ==="                                       << std::endl <<
 
           "Verbose: "                     << boolToEnabled(options.verbose) << std::endl <<
-          "Averages: "                    << options.avgs << " inferences"  << std::endl <<
+          "Averages: "                    << (options.avgs > 0 ? std::to_string(options.avgs) + " inferences"
+                                                                   : std::string("disabled")) << std::endl <<
           "Percentile: "                  << options.percentile             << std::endl <<
+          "Sliding window: "              << options.window << "s"          << std::endl <<
           "Dump output: "                 << boolToEnabled(options.output)  << std::endl <<
           "Profile: "                     << boolToEnabled(options.profile) << std::endl <<
-          "Export timing to JSON file: "  << options.exportTimes            << std::endl <<
-          "Export profile to JSON file: " << options.exportProfile          << std::endl;
+          "Export timing to file: "       << options.exportTimes            << std::endl <<
+          "Export profile to JSON file: " << options.exportProfile          << std::endl <<
+          "Export sweep to file: "        << options.exportSweep            << std::endl;
 // clang-format on
 
     return os;
@@ -814,7 +926,11 @@ void BuildOptions::help(std::ostream& os)
           "  --calib=<file>              Read INT8 calibration cache file"                                                            << std::endl <<
           "  --safe                      Only test the functionality available in safety restricted flows"                            << std::endl <<
           "  --saveEngine=<file>         Save the serialized engine"                                                                  << std::endl <<
-          "  --loadEngine=<file>         Load a serialized engine"                                                                    << std::endl;
+          "  --loadEngine=<file>         Load a serialized engine"                                                                    << std::endl <<
+          "  --engineCache=<dir>         Reuse the engine built earlier for the same model, options, plugins, TensorRT version"       << std::endl <<
+          "                              and GPU from <dir>, or build it and add it to <dir>"                                         << std::endl <<
+          "  --engineCacheSize=N         Evict the least recently used engines once the cache exceeds N megabytes (default = "
+                                                                                                     << defaultEngineCacheSize << ")" << std::endl;
 // clang-format on
 }
 
@@ -849,8 +965,19 @@ void InferenceOptions::help(std::ostream& os)
           "  --streams=N                 Instantiate N engines to use concurrently (default = "         << defaultStreams << ")" << std::endl <<
           "  --useSpinWait               Actively synchronize on GPU events. This option may decrease synchronization time but "
                                                                                 "increase CPU usage and power (default = false)" << std::endl <<
-          "  --threads                   Enable multithreading to drive engines with independent threads (default = disabled)"   << std::endl <<
+          "  --threads                   Enable multithreading to drive engines with independent threads, otherwise one thread "
+                                                                                   "drives all the streams (default = disabled)" << std::endl <<
           "  --useCudaGraph              Use cuda graph to capture engine execution and then launch inference (default = false)" << std::endl <<
+          "  --qps=R                     Open loop: start R inferences per second, queued while all streams are busy, and "
+                             "measure latencies from their arrival; every stream gets its own thread (default = 0, closed loop)" << std::endl <<
+          "  --arrivals=A                Arrival process of the open loop: fixed or poisson (default = fixed)"                   << std::endl <<
+          "  --seed=N                    Seed of the poisson arrivals, to draw the same arrivals again (default = from the clock,"
+                                                                                                    " printed with the options)" << std::endl <<
+          "  --sweep=list                Measure each batch size of the list, reusing the engine. The list holds sizes N"        << std::endl <<
+          "                              and ranges A-B[:S] of the sizes from A to B by steps of S. For explicit batch"          << std::endl <<
+          "                              engines, the batch dimension of the --shapes inputs is set"                             << std::endl <<
+          "  --sloP99=T                  With --sweep, search for the largest batch size of the list with a p99 latency"         << std::endl <<
+          "                              of at most T ms, measuring log2 of the list length sizes"                               << std::endl <<
           "  --buildOnly                 Skip inference perf measurement (default = disabled)"                                   << std::endl;
 // clang-format on
 }
@@ -861,14 +988,19 @@ void ReportingOptions::help(std::ostream& os)
     os << "=== Reporting Options ==="                                                                    << std::endl <<
           "  --verbose                   Use verbose logging (default = false)"                          << std::endl <<
           "  --avgRuns=N                 Report performance measurements averaged over N consecutive "
-                                                       "iterations (default = " << defaultAvgRuns << ")" << std::endl <<
+                                         "iterations, 0 to disable (default = " << defaultAvgRuns << ")" << std::endl <<
           "  --percentile=P              Report performance for the P percentage (0<=P<=100, 0 "
                                         "representing max perf, and 100 representing min perf; (default"
                                                                       " = " << defaultPercentile << "%)" << std::endl <<
+          "  --slidingWindow=S           Every second, report the latency percentiles over the last S seconds "
+                                                                                  "(default = disabled)" << std::endl <<
           "  --dumpOutput                Print the output tensor(s) of the last inference iteration "
                                                                                   "(default = disabled)" << std::endl <<
           "  --dumpProfile               Print profile information per layer (default = disabled)"       << std::endl <<
-          "  --exportTimes=<file>        Write the timing results in a json file (default = disabled)"   << std::endl <<
+          "  --exportTimes=<file>        Write the timing of every inference in a json file, or csv if "
+                                                            "<file> ends with .csv (default = disabled)" << std::endl <<
+          "  --exportSweep=<file>        Write the results of --sweep in a json file, or csv if <file> ends with .csv "
+                                                                                  "(default = disabled)" << std::endl <<
           "  --exportProfile=<file>      Write the profile information per layer in a json file "
                                                                               "(default = disabled)"     << std::endl;
 // clang-format on
@@ -50,6 +50,7 @@
 #ifndef TRT_SAMPLE_OPTIONS_H
 #define TRT_SAMPLE_OPTIONS_H
 
+#include <cstdint>
 #include <utility>
 #include <stdexcept>
 #include <vector>
@@ -69,6 +70,7 @@ constexpr int defaultMaxBatch{1};
 constexpr int defaultWorkspace{16};
 constexpr int defaultMinTiming{1};
 constexpr int defaultAvgTiming{8};
+constexpr int defaultEngineCacheSize{4096};
 
 // System default params
 constexpr int defaultDevice{0};
@@ -144,6 +146,8 @@ struct BuildOptions: public Options
     bool load{false};
     std::string engine;
     std::string calibration;
+    std::string cacheDir;
+    int cacheSize{defaultEngineCacheSize}; // MB
     std::unordered_map<std::string, ShapeRange> shapes;
     std::vector<IOFormat> inputFormats;
     std::vector<IOFormat> outputFormats;
@@ -174,9 +178,14 @@ struct InferenceOptions: public Options
     int sleep{defaultSleep};
     int streams{defaultStreams};
     bool spin{false};
-    bool threads{true};
+    bool threads{false};
     bool graph{false};
     bool skip{false};
+    float qps{0};
+    bool poisson{false};
+    uint64_t seed{0}; // Parsing sets the seed from the clock if --seed is not given
+    std::vector<int> sweep;
+    float slo{0};
     std::unordered_map<std::string, nvinfer1::Dims> shapes;
 
     void parse(Arguments& arguments) override;
@@ -189,10 +198,12 @@ struct ReportingOptions: public Options
     bool verbose{false};
     int avgs{defaultAvgRuns};
     float percentile{defaultPercentile};
+    int window{0};
     bool output{false};
     bool profile{false};
     std::string exportTimes{};
     std::string exportProfile{};
+    std::string exportSweep{};
 
     void parse(Arguments& arguments) override;
 
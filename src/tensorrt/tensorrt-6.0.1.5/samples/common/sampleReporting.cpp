@@ -0,0 +1,326 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+
+#include "sampleReporting.h"
+
+namespace sample
+{
+
+namespace
+{
+
+//!
+//! \brief Inferences and samples per second over the span of the traces
+//!
+void printThroughput(std::ostream& os, int count, double first, double last, int batch)
+{
+    const double seconds = (last - first) / 1000.;
+    const double qps = seconds > 0 ? count / seconds : 0.;
+    os << count << " inferences in " << seconds << " s, " << qps << " inferences/s";
+    if (batch > 0)
+    {
+        os << " (" << qps * batch << " samples/s)";
+    }
+    os << std::endl;
+}
+
+} // namespace
+
+PerformanceReport::PerformanceReport(int nbStreams, int batch, const ReportingOptions& reporting, std::ostream& os)
+    : mOs(os)
+    , mBatch(batch)
+    , mPercentile(reporting.percentile)
+    , mWindowSize(std::max(reporting.avgs, 0))
+    , mStreams(nbStreams)
+{
+    if (reporting.window > 0)
+    {
+        mSlidingLength = 1000. * reporting.window;
+        mSliding.reset(new samplesCommon::SlidingLatencyHistogram(mSlidingLength, reporting.window));
+    }
+}
+
+PerformanceReport::~PerformanceReport()
+{
+    printAverages();
+}
+
+void PerformanceReport::addTrace(const InferenceTrace& trace)
+{
+    StreamStats& stream = mStreams[trace.stream];
+    stream.first = stream.count ? std::min(stream.first, trace.hostStart) : trace.hostStart;
+    stream.last = std::max(stream.last, trace.hostEnd);
+    stream.latency += trace.latency();
+    ++stream.count;
+
+    mGpu.record(trace.gpuTime);
+    mHost.record(trace.latency());
+    mQueue.record(trace.queueTime());
+
+    if (mSliding)
+    {
+        if (mNextSliding == 0)
+        {
+            mNextSliding = trace.hostEnd + 1000.;
+        }
+        if (trace.hostEnd >= mNextSliding)
+        {
+            const std::string name
+                = "Host latency over the last " + std::to_string(static_cast<int>(mSlidingLength / 1000)) + " s";
+            printPercentiles(name, mSliding->getWindow(trace.hostEnd));
+            mNextSliding += 1000. * std::floor((trace.hostEnd - mNextSliding) / 1000. + 1.);
+        }
+        mSliding->record(trace.hostEnd, trace.latency());
+    }
+
+    if (mWindowSize == 0)
+    {
+        return;
+    }
+    mWindowGpu += trace.gpuTime;
+    mWindowGpuMax = std::max(mWindowGpuMax, trace.gpuTime);
+    mWindowHost += trace.latency();
+    if (++mWindowCount < mWindowSize)
+    {
+        return;
+    }
+    const float n = static_cast<float>(mWindowSize);
+    WindowAverage average;
+    average.gpu = mWindowGpu / n;
+    average.host = mWindowHost / n;
+    average.gpuMax = mWindowGpuMax;
+    mAverages.push_back(average);
+    mWindowGpu = 0;
+    mWindowGpuMax = 0;
+    mWindowHost = 0;
+    mWindowCount = 0;
+    if (trace.hostEnd >= mNextAverages)
+    {
+        printAverages();
+        mNextAverages = trace.hostEnd + 1000.;
+    }
+}
+
+void PerformanceReport::printAverages()
+{
+    for (const auto& average : mAverages)
+    {
+        mOs << "Average over " << mWindowSize << " runs is " << average.gpu << " ms (host walltime is " << average.host
+            << " ms, max is " << average.gpuMax << " ms)." << std::endl;
+    }
+    mAverages.clear();
+}
+
+void PerformanceReport::setOpenLoop(const InferenceSchedule& schedule, const OpenLoopStats& stats)
+{
+    mOpenLoop = true;
+    mSchedule = schedule;
+    mLoad = stats;
+}
+
+void PerformanceReport::printPercentiles(
+    const std::string& name, const samplesCommon::LatencyHistogram& histogram) const
+{
+    mOs << name << ": " << histogram.getCount() << " runs, mean " << histogram.getMean() << " ms, median "
+        << histogram.getPercentile(50) << " ms, p90 " << histogram.getPercentile(90) << " ms, p99 "
+        << histogram.getPercentile(99) << " ms, p99.9 " << histogram.getPercentile(99.9F) << " ms, max "
+        << histogram.getMax() << " ms" << std::endl;
+}
+
+double PerformanceReport::getThroughput() const
+{
+    int total{0};
+    double first{std::numeric_limits<double>::max()};
+    double last{0};
+    for (const auto& stream : mStreams)
+    {
+        if (stream.count)
+        {
+            total += stream.count;
+            first = std::min(first, stream.first);
+            last = std::max(last, stream.last);
+        }
+    }
+    return total && last > first ? total * 1000. / (last - first) : 0.;
+}
+
+void PerformanceReport::print()
+{
+    printAverages();
+    int total{0};
+    double first{std::numeric_limits<double>::max()};
+    double last{0};
+    for (size_t s = 0; s < mStreams.size(); ++s)
+    {
+        const StreamStats& stream = mStreams[s];
+        mOs << "Stream " << s << ": ";
+        if (stream.count == 0)
+        {
+            mOs << "no inference recorded" << std::endl;
+            continue;
+        }
+        mOs << "mean latency " << stream.latency / stream.count << " ms, ";
+        printThroughput(mOs, stream.count, stream.first, stream.last, mBatch);
+        total += stream.count;
+        first = std::min(first, stream.first);
+        last = std::max(last, stream.last);
+    }
+    if (total == 0)
+    {
+        mOs << "No inference recorded" << std::endl;
+        return;
+    }
+    printPercentiles("GPU compute", mGpu);
+    printPercentiles(mOpenLoop ? "Host latency from arrival" : "Host latency", mHost);
+    if (mOpenLoop)
+    {
+        printPercentiles("Queueing delay", mQueue);
+        const double seconds = mSchedule.duration / 1000.;
+        mOs << "Offered load: " << mLoad.arrivals / seconds << " inferences/s (" << mSchedule.qps << " targeted, "
+            << (mSchedule.poisson ? "poisson" : "fixed") << " arrivals), achieved: " << total / seconds
+            << " inferences/s, " << mLoad.unserved << " inferences left in the queue" << std::endl;
+    }
+    mOs << static_cast<int>(mPercentile) << "% percentile time is " << mGpu.getPercentile(mPercentile)
+        << " ms (host walltime is " << mHost.getPercentile(mPercentile) << " ms)" << std::endl;
+    mOs << "Total on " << mStreams.size() << " stream" << (mStreams.size() > 1 ? "s" : "") << ": ";
+    printThroughput(mOs, total, first, last, mBatch);
+}
+
+bool TraceExporter::open(const std::string& fileName, std::ostream& err)
+{
+    mFile.open(fileName);
+    if (!mFile)
+    {
+        err << "Cannot open " << fileName << " to export times" << std::endl;
+        return false;
+    }
+    const std::string csv{".csv"};
+    mCsv = fileName.size() >= csv.size() && fileName.compare(fileName.size() - csv.size(), csv.size(), csv) == 0;
+    // Fixed point keeps sub-microsecond resolution on the start and end times of long runs
+    mFile << std::fixed << std::setprecision(4);
+    mFile << (mCsv ? "stream,arrivalMs,startMs,endMs,queueMs,enqueueMs,latencyMs,gpuMs\n" : "[");
+    mFirst = true;
+    mDone = false;
+    mWriter = std::thread(&TraceExporter::writeLoop, this);
+    return true;
+}
+
+void TraceExporter::push(const InferenceTrace& trace)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPending.push_back(trace);
+    if (mPending.size() == kFLUSH_SIZE)
+    {
+        mWakeUp.notify_one();
+    }
+}
+
+bool TraceExporter::close()
+{
+    if (!mWriter.joinable())
+    {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDone = true;
+    }
+    mWakeUp.notify_one();
+    mWriter.join();
+    mFile << (mCsv ? "" : "\n]\n");
+    mFile.close();
+    return !mFile.fail();
+}
+
+void TraceExporter::writeLoop()
+{
+    std::vector<InferenceTrace> batch;
+    bool done{false};
+    while (!done)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            // Wake up periodically anyway, so that a slow run still reaches the file
+            mWakeUp.wait_for(
+                lock, std::chrono::seconds(1), [this] { return mDone || mPending.size() >= kFLUSH_SIZE; });
+            batch.swap(mPending);
+            done = mDone;
+        }
+        write(batch);
+        batch.clear();
+    }
+}
+
+void TraceExporter::write(const std::vector<InferenceTrace>& traces)
+{
+    for (const auto& t : traces)
+    {
+        if (mCsv)
+        {
+            mFile << t.stream << "," << t.arrival << "," << t.hostStart << "," << t.hostEnd << "," << t.queueTime()
+                  << "," << t.enqueueTime << "," << t.latency() << "," << t.gpuTime << "\n";
+        }
+        else
+        {
+            mFile << (mFirst ? "\n" : ",\n") << "  { \"stream\" : " << t.stream << ", \"arrivalMs\" : " << t.arrival
+                  << ", \"startMs\" : " << t.hostStart << ", \"endMs\" : " << t.hostEnd
+                  << ", \"queueMs\" : " << t.queueTime() << ", \"enqueueMs\" : " << t.enqueueTime
+                  << ", \"latencyMs\" : " << t.latency() << ", \"gpuMs\" : " << t.gpuTime << " }";
+            mFirst = false;
+        }
+    }
+    mFile.flush();
+}
+
+} // namespace sample
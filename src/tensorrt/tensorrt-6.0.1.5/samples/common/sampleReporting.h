@@ -0,0 +1,198 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_REPORTING_H
+#define TRT_SAMPLE_REPORTING_H
+
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latencyHistogram.h"
+#include "sampleInference.h"
+#include "sampleOptions.h"
+
+namespace sample
+{
+
+//!
+//! \brief Latency and throughput report built from the traces as they arrive
+//!
+//! \details The average latencies of every reporting.avgs traces are kept as they are added and printed at most
+//!          once a second, as printing each of them from the measured loop costs time at high rates. If
+//!          reporting.window is set, the host latency percentiles over the last window seconds are printed every
+//!          second as well. print() then gives the percentiles over the whole run and the throughput of each stream
+//!          and of the run. Latencies go to fixed size histograms, so memory does not depend on the length of the run.
+//!
+class PerformanceReport
+{
+public:
+    //!
+    //! \param batch Samples per inference, or 0 if unknown, in which case only inferences per second are reported
+    //!
+    PerformanceReport(int nbStreams, int batch, const ReportingOptions& reporting, std::ostream& os);
+
+    ~PerformanceReport();
+
+    void addTrace(const InferenceTrace& trace);
+
+    //!
+    //! \brief Report the run as open loop, adding the queueing delays and the offered load to the report
+    //!
+    void setOpenLoop(const InferenceSchedule& schedule, const OpenLoopStats& stats);
+
+    void print();
+
+    const samplesCommon::LatencyHistogram& getGpuTimes() const { return mGpu; }
+
+    const samplesCommon::LatencyHistogram& getLatencies() const { return mHost; }
+
+    //!
+    //! \brief Inferences per second of all streams together, over the span of the traces
+    //!
+    double getThroughput() const;
+
+private:
+    struct WindowAverage
+    {
+        float gpu{0};    //!< Mean GPU time, in ms
+        float host{0};   //!< Mean host latency, in ms
+        float gpuMax{0}; //!< Longest GPU time, in ms
+    };
+
+    struct StreamStats
+    {
+        int count{0};
+        double first{0};   //!< Earliest launch, in ms
+        double last{0};    //!< Latest completion, in ms
+        double latency{0}; //!< Sum of the latencies, in ms
+    };
+
+    void printPercentiles(const std::string& name, const samplesCommon::LatencyHistogram& histogram) const;
+
+    void printAverages();
+
+    std::ostream& mOs;
+    int mBatch{0};
+    float mPercentile{0};
+    int mWindowSize{0};
+    int mWindowCount{0};
+    float mWindowHost{0};                 //!< Sum of the host latencies of the current window, in ms
+    float mWindowGpu{0};                  //!< Sum of the GPU times of the current window, in ms
+    float mWindowGpuMax{0};               //!< Longest GPU time of the current window, in ms
+    std::vector<WindowAverage> mAverages; //!< Averages of the windows not printed yet
+    double mNextAverages{0};              //!< Completion time after which the averages are printed, in ms
+    samplesCommon::LatencyHistogram mGpu;
+    samplesCommon::LatencyHistogram mHost;
+    samplesCommon::LatencyHistogram mQueue;
+    bool mOpenLoop{false};
+    InferenceSchedule mSchedule;
+    OpenLoopStats mLoad;
+    std::unique_ptr<samplesCommon::SlidingLatencyHistogram> mSliding;
+    double mSlidingLength{0};
+    double mNextSliding{0};
+    std::vector<StreamStats> mStreams;
+};
+
+//!
+//! \brief Writes traces to a JSON or CSV file from a background thread
+//!
+//! \details push() only appends to an in-memory batch, which the writer thread swaps out and formats, so that file
+//!          IO never stalls the threads running inference and memory stays bounded on long runs.
+//!
+class TraceExporter
+{
+public:
+    TraceExporter() = default;
+
+    TraceExporter(const TraceExporter&) = delete;
+
+    TraceExporter& operator=(const TraceExporter&) = delete;
+
+    ~TraceExporter() { close(); }
+
+    //!
+    //! \brief Create the file and start the writer, CSV if the name ends with .csv and JSON otherwise
+    //!
+    bool open(const std::string& fileName, std::ostream& err);
+
+    void push(const InferenceTrace& trace);
+
+    //!
+    //! \brief Write the pending traces and close the file
+    //!
+    //! \return False if writing failed
+    //!
+    bool close();
+
+private:
+    void writeLoop();
+
+    void write(const std::vector<InferenceTrace>& traces);
+
+    static constexpr size_t kFLUSH_SIZE{4096}; //!< Traces batched before waking the writer up
+
+    std::ofstream mFile;
+    bool mCsv{false};
+    bool mFirst{true};
+    bool mDone{false};
+    std::vector<InferenceTrace> mPending;
+    std::mutex mMutex;
+    std::condition_variable mWakeUp;
+    std::thread mWriter;
+};
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_REPORTING_H
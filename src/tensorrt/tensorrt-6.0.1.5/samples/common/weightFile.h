@@ -0,0 +1,760 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef WEIGHT_FILE_H
+#define WEIGHT_FILE_H
+
+#include "NvInfer.h"
+#include "atomicFile.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <utility>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Layout of a weight container file.
+//!
+//! \details A weight container holds named weight blobs that can be used in place from a mapping of the file:
+//!
+//!          WeightFileHeader
+//!          N x WeightIndexEntry   sorted by name
+//!          names                  not terminated, referenced by the index
+//!          N x blob               each starting on a kWEIGHT_ALIGNMENT boundary
+//!
+//!          All values are little endian. Loading a container only validates the index, the weights of a network
+//!          are read from the page cache when the builder first touches them.
+//!
+constexpr char kWEIGHT_MAGIC[8] = {'T', 'R', 'T', 'W', 'G', 'H', 'T', '\0'};
+constexpr uint32_t kWEIGHT_VERSION{1};
+constexpr uint64_t kWEIGHT_ALIGNMENT{64};
+
+struct WeightFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t nbBlobs;
+    uint64_t indexOffset;
+    uint64_t namesOffset;
+};
+
+struct WeightIndexEntry
+{
+    uint64_t nameOffset; //!< Offset of the name from the start of the file
+    uint64_t dataOffset; //!< Offset of the blob from the start of the file
+    int64_t count;       //!< Number of elements of the blob
+    uint32_t nameLength;
+    int32_t dataType; //!< nvinfer1::DataType
+    int32_t nbDims;
+    int32_t dims[nvinfer1::Dims::MAX_DIMS];
+    int32_t reserved;
+};
+
+//!
+//! \brief Layout of the sidecar index of a wts v2 file.
+//!
+//! \details WeightIndexHeader
+//!          N x WeightIndexEntry   nameOffset is from the start of the index, dataOffset from the start of the wts file
+//!          names
+//!
+//!          The index is still valid if the size and modification time of the wts file, in nanoseconds where the
+//!          file system has them, are those it was written for, and if the text around the blobs, which holds their
+//!          names, types and shapes, still hashes to headerHash. The hash only reads the few bytes before every blob,
+//!          and catches edits that keep the size within the resolution of the modification time.
+//!
+constexpr char kWEIGHT_INDEX_MAGIC[8] = {'T', 'R', 'T', 'W', 'I', 'D', 'X', '\0'};
+constexpr uint32_t kWEIGHT_INDEX_VERSION{2};
+
+struct WeightIndexHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t nbBlobs;
+    uint64_t sourceSize;
+    int64_t sourceTime; //!< Modification time of the wts file, in nanoseconds
+    uint64_t headerHash; //!< FNV-1a hash of the wts file outside of the blob values
+};
+
+inline uint64_t alignWeight(uint64_t offset)
+{
+    return (offset + kWEIGHT_ALIGNMENT - 1) / kWEIGHT_ALIGNMENT * kWEIGHT_ALIGNMENT;
+}
+
+inline size_t getWeightTypeSize(nvinfer1::DataType type)
+{
+    switch (type)
+    {
+    case nvinfer1::DataType::kFLOAT:
+    case nvinfer1::DataType::kINT32: return 4;
+    case nvinfer1::DataType::kHALF: return 2;
+    case nvinfer1::DataType::kINT8: return 1;
+    }
+    return 0;
+}
+
+//!
+//! \brief Weights of a blob together with the shape it was saved with
+//!
+struct WeightBlob
+{
+    nvinfer1::Weights weights;
+    nvinfer1::Dims shape;
+};
+
+//!
+//! \brief  The WeightFile class gives access to the blobs of a weight container or of a text weight file.
+//!
+//! \details Containers are mapped and their weights point into the mapping. The .wts files written by dumpTFWts.py,
+//!          with hex values (wts v1) or with the shape and raw bytes of each blob (wts v2), are parsed into buffers
+//!          owned by the object, or mapped through a sidecar index for wts v2 files opened with openIndexed().
+//!          Either way, the weights stay valid as long as the object.
+//!
+class WeightFile
+{
+public:
+    //!
+    //! \return true if fileName is a valid container or weight file, otherwise err holds the reason.
+    //!
+    bool open(const std::string& fileName, std::string& err)
+    {
+        mBlobs.clear();
+        mBuffers.clear();
+        if (!mFile.open(fileName, MappedFile::Advice::kRANDOM))
+        {
+            err = "Cannot map " + fileName;
+            return false;
+        }
+        const bool ok = isContainer() ? openContainer(fileName, err) : parseText(fileName, err);
+        if (!isContainer())
+        {
+            // The blobs were copied, the text is not needed anymore.
+            mFile = MappedFile();
+        }
+        return ok;
+    }
+
+    //!
+    //! \brief Open a weight file, mapping the blobs of a wts v2 file in place through its sidecar index.
+    //!
+    //! \details The index, fileName + ".idx", gives the type, shape and offset of every blob, so that only the
+    //!          requested blobs are touched. It is written the first time the file is opened this way, and again when
+    //!          the file changes. Blobs that are not aligned for their type within the file are copied. Containers and
+    //!          wts v1 files are opened as by open().
+    //!
+    //! \param names The blobs to load, or empty for every blob. Missing blobs are an error.
+    //!
+    bool openIndexed(const std::string& fileName, const std::vector<std::string>& names, std::string& err)
+    {
+        mBlobs.clear();
+        mBuffers.clear();
+        if (!mFile.open(fileName, MappedFile::Advice::kRANDOM))
+        {
+            err = "Cannot map " + fileName;
+            return false;
+        }
+        std::vector<std::pair<std::string, WeightIndexEntry>> entries;
+        const std::string indexName = fileName + ".idx";
+        const bool indexed = !isContainer() && readIndex(fileName, indexName, entries);
+        if (!indexed && (isContainer() || !scanText(entries)))
+        {
+            return open(fileName, err);
+        }
+        if (!indexed)
+        {
+            // Without a writable directory, the file is scanned every time it is opened.
+            writeIndex(fileName, indexName, entries);
+        }
+
+        std::map<std::string, const WeightIndexEntry*> byName;
+        for (const auto& e : entries)
+        {
+            byName[e.first] = &e.second;
+        }
+        std::vector<std::string> wanted = names;
+        if (wanted.empty())
+        {
+            for (const auto& e : entries)
+            {
+                wanted.push_back(e.first);
+            }
+        }
+        for (const auto& name : wanted)
+        {
+            const auto it = byName.find(name);
+            if (it == byName.end())
+            {
+                err = fileName + " has no blob " + name;
+                return false;
+            }
+            const WeightIndexEntry& entry = *it->second;
+            WeightBlob blob{};
+            blob.weights.type = static_cast<nvinfer1::DataType>(entry.dataType);
+            blob.weights.count = entry.count;
+            blob.shape.nbDims = entry.nbDims;
+            std::copy_n(entry.dims, entry.nbDims, blob.shape.d);
+            const size_t typeSize = getWeightTypeSize(blob.weights.type);
+            const uint8_t* values = mFile.data() + entry.dataOffset;
+            if (entry.dataOffset % typeSize)
+            {
+                mBuffers.emplace_back(values, values + entry.count * typeSize);
+                values = mBuffers.back().data();
+            }
+            blob.weights.values = values;
+            mBlobs[name] = blob;
+        }
+        return true;
+    }
+
+    //!
+    //! \brief Returns true if the weights point into a mapped container or wts v2 file
+    //!
+    bool isMapped() const { return mFile.data() != nullptr; }
+
+    const std::map<std::string, WeightBlob>& getBlobs() const { return mBlobs; }
+
+    //!
+    //! \brief Returns the weights of name, or empty weights if the file has no such blob
+    //!
+    nvinfer1::Weights getWeights(const std::string& name) const
+    {
+        const auto it = mBlobs.find(name);
+        return it == mBlobs.end() ? nvinfer1::Weights{nvinfer1::DataType::kFLOAT, nullptr, 0} : it->second.weights;
+    }
+
+    std::map<std::string, nvinfer1::Weights> getWeightMap() const
+    {
+        std::map<std::string, nvinfer1::Weights> weights;
+        for (const auto& b : mBlobs)
+        {
+            weights.emplace(b.first, b.second.weights);
+        }
+        return weights;
+    }
+
+private:
+    bool isContainer() const
+    {
+        return fits(0, sizeof(kWEIGHT_MAGIC)) && !std::memcmp(mFile.data(), kWEIGHT_MAGIC, sizeof(kWEIGHT_MAGIC));
+    }
+
+    bool fits(uint64_t offset, uint64_t size) const
+    {
+        return offset <= mFile.size() && size <= mFile.size() - offset;
+    }
+
+    bool openContainer(const std::string& fileName, std::string& err)
+    {
+        WeightFileHeader header;
+        if (!fits(0, sizeof(header)))
+        {
+            err = fileName + " is truncated";
+            return false;
+        }
+        std::memcpy(&header, mFile.data(), sizeof(header));
+        if (header.version != kWEIGHT_VERSION)
+        {
+            err = fileName + " is not a version " + std::to_string(kWEIGHT_VERSION) + " weight container";
+            return false;
+        }
+        if (!fits(header.indexOffset, sizeof(WeightIndexEntry) * static_cast<uint64_t>(header.nbBlobs)))
+        {
+            err = fileName + " has a truncated index";
+            return false;
+        }
+        for (uint32_t i = 0; i < header.nbBlobs; ++i)
+        {
+            WeightIndexEntry entry;
+            std::memcpy(&entry, mFile.data() + header.indexOffset + i * sizeof(entry), sizeof(entry));
+            const auto type = static_cast<nvinfer1::DataType>(entry.dataType);
+            if (entry.dataType < 0 || !getWeightTypeSize(type) || entry.count < 0 || entry.nbDims < 0
+                || entry.nbDims > nvinfer1::Dims::MAX_DIMS || entry.dataOffset % kWEIGHT_ALIGNMENT
+                || !fits(entry.nameOffset, entry.nameLength)
+                || !fits(entry.dataOffset, static_cast<uint64_t>(entry.count) * getWeightTypeSize(type)))
+            {
+                err = fileName + " has an invalid index entry " + std::to_string(i);
+                return false;
+            }
+            WeightBlob blob{};
+            blob.weights = nvinfer1::Weights{type, mFile.data() + entry.dataOffset, entry.count};
+            blob.shape.nbDims = entry.nbDims;
+            std::copy_n(entry.dims, entry.nbDims, blob.shape.d);
+            mBlobs.emplace(
+                std::string(reinterpret_cast<const char*>(mFile.data()) + entry.nameOffset, entry.nameLength), blob);
+        }
+        return true;
+    }
+
+    //!
+    //! \brief Parse a wts v1 or v2 file, telling the two apart per blob by the shape that only v2 has
+    //!
+    bool parseText(const std::string& fileName, std::string& err)
+    {
+        const char* p = reinterpret_cast<const char*>(mFile.data());
+        const char* end = p + mFile.size();
+        int64_t nbBlobs{0};
+        if (!readInteger(p, end, 10, nbBlobs) || nbBlobs <= 0)
+        {
+            err = fileName + " is neither a weight container nor a weight file";
+            return false;
+        }
+        while (nbBlobs--)
+        {
+            std::string name;
+            WeightBlob blob{};
+            bool v2{false};
+            if (!readBlobHeader(p, end, name, blob, v2))
+            {
+                err = fileName + " has an invalid blob header";
+                return false;
+            }
+            const size_t typeSize = getWeightTypeSize(blob.weights.type);
+            mBuffers.emplace_back(blob.weights.count * typeSize);
+            uint8_t* values = mBuffers.back().data();
+            if (v2)
+            {
+                const uint8_t* data = skipBlob(p, end, blob);
+                if (!data)
+                {
+                    err = fileName + " is truncated in " + name;
+                    return false;
+                }
+                std::memcpy(values, data, blob.weights.count * typeSize);
+            }
+            else
+            {
+                for (int64_t i = 0; i < blob.weights.count; ++i)
+                {
+                    int64_t bits{0};
+                    if (!readInteger(p, end, 16, bits))
+                    {
+                        err = fileName + " has an invalid value in " + name;
+                        return false;
+                    }
+                    if (typeSize == 4)
+                    {
+                        const uint32_t v = static_cast<uint32_t>(bits);
+                        std::memcpy(values + 4 * i, &v, 4);
+                    }
+                    else if (typeSize == 2)
+                    {
+                        const uint16_t v = static_cast<uint16_t>(bits);
+                        std::memcpy(values + 2 * i, &v, 2);
+                    }
+                    else
+                    {
+                        values[i] = static_cast<uint8_t>(bits);
+                    }
+                }
+            }
+            blob.weights.values = values;
+            mBlobs[name] = blob;
+        }
+        return true;
+    }
+
+    //!
+    //! \brief Read the name, type and shape or size of a blob of a wts file
+    //!
+    static bool readBlobHeader(const char*& p, const char* end, std::string& name, WeightBlob& blob, bool& v2)
+    {
+        int64_t type{-1};
+        if (!readToken(p, end, name) || !readInteger(p, end, 10, type) || type < 0
+            || !getWeightTypeSize(static_cast<nvinfer1::DataType>(type)))
+        {
+            return false;
+        }
+        blob.weights.type = static_cast<nvinfer1::DataType>(type);
+
+        skipSpaces(p, end);
+        v2 = p < end && *p == '(';
+        if (!v2)
+        {
+            if (!readInteger(p, end, 10, blob.weights.count))
+            {
+                return false;
+            }
+            blob.shape.nbDims = 1;
+            blob.shape.d[0] = static_cast<int>(blob.weights.count);
+            return true;
+        }
+        if (!readShape(p, end, blob.shape))
+        {
+            return false;
+        }
+        blob.weights.count = 1;
+        for (int d = 0; d < blob.shape.nbDims; ++d)
+        {
+            blob.weights.count *= blob.shape.d[d];
+        }
+        return true;
+    }
+
+    //!
+    //! \brief Skip the raw values of a wts v2 blob, after its header
+    //!
+    //! \return The values, or nullptr if the file is truncated
+    //!
+    static const uint8_t* skipBlob(const char*& p, const char* end, const WeightBlob& blob)
+    {
+        // A single space separates the shape from the raw values, which end with a newline.
+        const uint64_t size = blob.weights.count * getWeightTypeSize(blob.weights.type);
+        if (end - p < 1 || static_cast<uint64_t>(end - p - 1) < size)
+        {
+            return nullptr;
+        }
+        const uint8_t* values = reinterpret_cast<const uint8_t*>(p + 1);
+        p += 1 + size;
+        return values;
+    }
+
+    //!
+    //! \brief Index the blobs of a mapped wts v2 file without reading their values
+    //!
+    //! \return false if the file is not a valid wts v2 file
+    //!
+    bool scanText(std::vector<std::pair<std::string, WeightIndexEntry>>& entries) const
+    {
+        const char* begin = reinterpret_cast<const char*>(mFile.data());
+        const char* p = begin;
+        const char* end = p + mFile.size();
+        int64_t nbBlobs{0};
+        if (!readInteger(p, end, 10, nbBlobs) || nbBlobs <= 0)
+        {
+            return false;
+        }
+        entries.clear();
+        while (nbBlobs--)
+        {
+            std::string name;
+            WeightBlob blob{};
+            bool v2{false};
+            if (!readBlobHeader(p, end, name, blob, v2) || !v2)
+            {
+                return false;
+            }
+            const uint8_t* values = skipBlob(p, end, blob);
+            if (!values)
+            {
+                return false;
+            }
+            WeightIndexEntry entry{};
+            entry.nameLength = static_cast<uint32_t>(name.size());
+            entry.dataOffset = values - mFile.data();
+            entry.count = blob.weights.count;
+            entry.dataType = static_cast<int32_t>(blob.weights.type);
+            entry.nbDims = blob.shape.nbDims;
+            std::copy_n(blob.shape.d, blob.shape.nbDims, entry.dims);
+            entries.emplace_back(name, entry);
+        }
+        return true;
+    }
+
+    static bool getSourceInfo(const std::string& fileName, uint64_t& size, int64_t& time)
+    {
+        struct stat info;
+        if (stat(fileName.c_str(), &info))
+        {
+            return false;
+        }
+        size = static_cast<uint64_t>(info.st_size);
+        time = static_cast<int64_t>(info.st_mtime) * 1000000000;
+#if defined(__linux__)
+        time += info.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+        time += info.st_mtimespec.tv_nsec;
+#endif
+        return true;
+    }
+
+    //!
+    //! \brief Hash the text of the mapped wts v2 file between the values of its blobs, given in file order
+    //!
+    //! \return false if the blobs are not in file order or do not fit in the file
+    //!
+    bool hashHeaders(const std::vector<std::pair<std::string, WeightIndexEntry>>& entries, uint64_t& hash) const
+    {
+        hash = 0xcbf29ce484222325ULL;
+        uint64_t begin{0};
+        for (size_t i = 0; i <= entries.size(); ++i)
+        {
+            const uint64_t end = i < entries.size() ? entries[i].second.dataOffset : mFile.size();
+            if (end < begin || end > mFile.size())
+            {
+                return false;
+            }
+            for (uint64_t j = begin; j < end; ++j)
+            {
+                hash = (hash ^ mFile.data()[j]) * 0x100000001b3ULL;
+            }
+            if (i < entries.size())
+            {
+                const WeightIndexEntry& entry = entries[i].second;
+                const auto type = static_cast<nvinfer1::DataType>(entry.dataType);
+                begin = end + static_cast<uint64_t>(entry.count) * getWeightTypeSize(type);
+            }
+        }
+        return true;
+    }
+
+    //!
+    //! \brief Read the sidecar index of the mapped wts v2 file, checking that it matches the file
+    //!
+    bool readIndex(const std::string& fileName, const std::string& indexName,
+        std::vector<std::pair<std::string, WeightIndexEntry>>& entries) const
+    {
+        MappedFile index;
+        WeightIndexHeader header;
+        uint64_t size{0};
+        int64_t time{0};
+        if (!index.open(indexName, MappedFile::Advice::kSEQUENTIAL) || index.size() < sizeof(header)
+            || !getSourceInfo(fileName, size, time))
+        {
+            return false;
+        }
+        std::memcpy(&header, index.data(), sizeof(header));
+        if (std::memcmp(header.magic, kWEIGHT_INDEX_MAGIC, sizeof(kWEIGHT_INDEX_MAGIC))
+            || header.version != kWEIGHT_INDEX_VERSION || header.sourceSize != size || header.sourceTime != time
+            || size != mFile.size()
+            || (index.size() - sizeof(header)) / sizeof(WeightIndexEntry) < header.nbBlobs)
+        {
+            return false;
+        }
+        entries.clear();
+        for (uint32_t i = 0; i < header.nbBlobs; ++i)
+        {
+            WeightIndexEntry entry;
+            std::memcpy(&entry, index.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+            const auto type = static_cast<nvinfer1::DataType>(entry.dataType);
+            if (entry.dataType < 0 || !getWeightTypeSize(type) || entry.count < 0 || entry.nbDims < 0
+                || entry.nbDims > nvinfer1::Dims::MAX_DIMS || entry.nameOffset > index.size()
+                || entry.nameLength > index.size() - entry.nameOffset
+                || !fits(entry.dataOffset, static_cast<uint64_t>(entry.count) * getWeightTypeSize(type)))
+            {
+                return false;
+            }
+            entries.emplace_back(
+                std::string(reinterpret_cast<const char*>(index.data()) + entry.nameOffset, entry.nameLength), entry);
+        }
+        uint64_t hash{0};
+        return hashHeaders(entries, hash) && hash == header.headerHash;
+    }
+
+    bool writeIndex(const std::string& fileName, const std::string& indexName,
+        std::vector<std::pair<std::string, WeightIndexEntry>>& entries) const
+    {
+        WeightIndexHeader header{};
+        std::memcpy(header.magic, kWEIGHT_INDEX_MAGIC, sizeof(kWEIGHT_INDEX_MAGIC));
+        header.version = kWEIGHT_INDEX_VERSION;
+        header.nbBlobs = static_cast<uint32_t>(entries.size());
+        if (!getSourceInfo(fileName, header.sourceSize, header.sourceTime) || !hashHeaders(entries, header.headerHash))
+        {
+            return false;
+        }
+
+        std::string names;
+        uint64_t nameOffset = sizeof(header) + sizeof(WeightIndexEntry) * entries.size();
+        for (auto& e : entries)
+        {
+            e.second.nameOffset = nameOffset + names.size();
+            names += e.first;
+        }
+        std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& e : entries)
+        {
+            out.append(reinterpret_cast<const char*>(&e.second), sizeof(e.second));
+        }
+        return writeFileAtomically(indexName, out + names);
+    }
+
+    static void skipSpaces(const char*& p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        {
+            ++p;
+        }
+    }
+
+    static bool readToken(const char*& p, const char* end, std::string& token)
+    {
+        skipSpaces(p, end);
+        const char* begin = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+        {
+            ++p;
+        }
+        token.assign(begin, p);
+        return p != begin;
+    }
+
+    //!
+    //! \brief Read a non-negative integer, without relying on the text being terminated
+    //!
+    static bool readInteger(const char*& p, const char* end, int base, int64_t& value)
+    {
+        skipSpaces(p, end);
+        const char* begin = p;
+        value = 0;
+        for (; p < end && p - begin < 16; ++p)
+        {
+            int digit{0};
+            if (*p >= '0' && *p <= '9')
+            {
+                digit = *p - '0';
+            }
+            else if (base == 16 && *p >= 'a' && *p <= 'f')
+            {
+                digit = *p - 'a' + 10;
+            }
+            else if (base == 16 && *p >= 'A' && *p <= 'F')
+            {
+                digit = *p - 'A' + 10;
+            }
+            else
+            {
+                break;
+            }
+            value = value * base + digit;
+        }
+        return p != begin && (p == end || !std::isalnum(static_cast<unsigned char>(*p)));
+    }
+
+    //!
+    //! \brief Read a shape written by Python, such as (784, 256) or (10,)
+    //!
+    static bool readShape(const char*& p, const char* end, nvinfer1::Dims& shape)
+    {
+        ++p;
+        shape.nbDims = 0;
+        for (;;)
+        {
+            skipSpaces(p, end);
+            if (p < end && *p == ')')
+            {
+                ++p;
+                return true;
+            }
+            int64_t d{0};
+            if (shape.nbDims == nvinfer1::Dims::MAX_DIMS || !readInteger(p, end, 10, d))
+            {
+                return false;
+            }
+            shape.d[shape.nbDims++] = static_cast<int>(d);
+            skipSpaces(p, end);
+            if (p < end && *p == ',')
+            {
+                ++p;
+            }
+        }
+    }
+
+    MappedFile mFile;
+    std::map<std::string, WeightBlob> mBlobs;
+    std::vector<std::vector<uint8_t>> mBuffers; //!< Values parsed from a text weight file
+};
+
+//!
+//! \brief Writer of weight containers.
+//!
+//! \details The blobs are copied when they are added, so the source of the weights, even a WeightFile mapping the
+//!          output file, can go away before write() is called.
+//!
+class WeightFileWriter
+{
+public:
+    void add(const std::string& name, const nvinfer1::Weights& weights, const nvinfer1::Dims& shape)
+    {
+        Blob& blob = mBlobs[name];
+        blob.type = weights.type;
+        blob.count = weights.count;
+        blob.shape = shape;
+        const uint8_t* values = static_cast<const uint8_t*>(weights.values);
+        blob.values.assign(values, values + weights.count * getWeightTypeSize(weights.type));
+    }
+
+    //!
+    //! \brief Write the container, replacing fileName atomically
+    //!
+    bool write(const std::string& fileName, std::string& err) const
+    {
+        WeightFileHeader header{};
+        std::memcpy(header.magic, kWEIGHT_MAGIC, sizeof(kWEIGHT_MAGIC));
+        header.version = kWEIGHT_VERSION;
+        header.nbBlobs = static_cast<uint32_t>(mBlobs.size());
+        header.indexOffset = alignWeight(sizeof(header));
+        header.namesOffset = header.indexOffset + sizeof(WeightIndexEntry) * mBlobs.size();
+
+        std::vector<WeightIndexEntry> index;
+        uint64_t nameOffset = header.namesOffset;
+        for (const auto& b : mBlobs)
+        {
+            WeightIndexEntry entry{};
+            entry.nameOffset = nameOffset;
+            entry.nameLength = static_cast<uint32_t>(b.first.size());
+            entry.dataType = static_cast<int32_t>(b.second.type);
+            entry.count = b.second.count;
+            entry.nbDims = b.second.shape.nbDims;
+            std::copy_n(b.second.shape.d, b.second.shape.nbDims, entry.dims);
+            nameOffset += b.first.size();
+            index.push_back(entry);
+        }
+        uint64_t dataOffset = alignWeight(nameOffset);
+        for (auto& entry : index)
+        {
+            const auto type = static_cast<nvinfer1::DataType>(entry.dataType);
+            entry.dataOffset = dataOffset;
+            dataOffset = alignWeight(dataOffset + entry.count * getWeightTypeSize(type));
+        }
+
+        std::string out(dataOffset, '\0');
+        std::memcpy(&out[0], &header, sizeof(header));
+        std::memcpy(&out[header.indexOffset], index.data(), sizeof(WeightIndexEntry) * index.size());
+        size_t i = 0;
+        for (const auto& b : mBlobs)
+        {
+            std::memcpy(&out[index[i].nameOffset], b.first.data(), b.first.size());
+            std::memcpy(&out[index[i].dataOffset], b.second.values.data(), b.second.values.size());
+            ++i;
+        }
+        if (!writeFileAtomically(fileName, out))
+        {
+            err = "Cannot write " + fileName;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Blob
+    {
+        nvinfer1::DataType type;
+        int64_t count;
+        nvinfer1::Dims shape;
+        std::vector<uint8_t> values;
+    };
+
+    std::map<std::string, Blob> mBlobs;
+};
+
+} // namespace samplesCommon
+
+#endif // WEIGHT_FILE_H
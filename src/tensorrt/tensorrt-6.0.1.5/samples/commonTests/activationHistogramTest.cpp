@@ -0,0 +1,227 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "activationHistogram.h"
+#include "commonTests.h"
+
+using samplesCommon::ActivationHistogram;
+
+namespace
+{
+
+using Histograms = std::map<std::string, ActivationHistogram>;
+using TensorFiles = std::map<std::string, std::vector<std::vector<float>>>;
+
+//!
+//! \brief Collect the histograms of the shard-th of nbShards slices of the files, in chunks like trtcalib
+//!
+Histograms collectShard(const TensorFiles& tensors, int shard, int nbShards, size_t chunk)
+{
+    Histograms histograms;
+    for (const auto& t : tensors)
+    {
+        ActivationHistogram& h = histograms.emplace(t.first, ActivationHistogram()).first->second;
+        const auto slice = samplesCommon::getShardSlice(t.second.size(), shard, nbShards);
+        for (size_t f = slice.first; f < slice.second; ++f)
+        {
+            const std::vector<float>& values = t.second[f];
+            for (size_t begin = 0; begin < values.size(); begin += chunk)
+            {
+                h.add(values.data() + begin, std::min(chunk, values.size() - begin));
+            }
+        }
+    }
+    return histograms;
+}
+
+bool sameHistograms(const Histograms& a, const Histograms& b)
+{
+    TEST_CHECK(a.size() == b.size());
+    for (const auto& h : a)
+    {
+        const auto other = b.find(h.first);
+        TEST_CHECK(other != b.end());
+        const ActivationHistogram& x = h.second;
+        const ActivationHistogram& y = other->second;
+        TEST_CHECK(x.getCounts() == y.getCounts());
+        TEST_CHECK(x.getRangeExponent() == y.getRangeExponent());
+        TEST_CHECK(x.getCount() == y.getCount() && x.getNbNonFinite() == y.getNbNonFinite());
+        TEST_CHECK(x.empty() == y.empty());
+        TEST_CHECK(x.getMaxRange() == y.getMaxRange());
+        TEST_CHECK(x.getPercentileRange(99.99) == y.getPercentileRange(99.99));
+        TEST_CHECK(x.getEntropyRange() == y.getEntropyRange());
+    }
+    return true;
+}
+
+bool checkActivationHistogramShards(const std::string& dir)
+{
+    // Tensors of different scales, one whose range grows from file to file, one with zeros and non-finite values,
+    // one with fewer files than shards and one without files, as for an output only dumped for some batches.
+    std::mt19937 rng(0);
+    TensorFiles tensors;
+    for (int f = 0; f < 7; ++f)
+    {
+        std::exponential_distribution<float> values(std::ldexp(1.F, 4 - 2 * f));
+        std::vector<float> file(1000 + 500 * f);
+        for (auto& v : file)
+        {
+            v = rng() & 1 ? values(rng) : -values(rng);
+        }
+        tensors["conv"].push_back(file);
+    }
+    for (int f = 0; f < 3; ++f)
+    {
+        std::normal_distribution<float> values(0.F, 0.01F);
+        std::vector<float> file(4096, 0.F);
+        std::generate(file.begin() + 1024 * f, file.end(), [&]() { return values(rng); });
+        file[f] = f == 1 ? std::numeric_limits<float>::infinity() : std::numeric_limits<float>::quiet_NaN();
+        tensors["relu"].push_back(file);
+    }
+    tensors["logits"].push_back(std::vector<float>(100, 3.F));
+    tensors["unused"];
+
+    const Histograms reference = collectShard(tensors, 0, 1, 1 << 20);
+    TEST_CHECK(!reference.at("conv").empty() && reference.at("conv").getRangeExponent() > 0);
+    TEST_CHECK(reference.at("relu").getNbNonFinite() == 3);
+    TEST_CHECK(reference.at("unused").empty() && reference.at("unused").getCount() == 0);
+
+    std::ostringstream err;
+    for (const int nbShards : {1, 2, 5})
+    {
+        std::vector<std::string> files;
+        for (int shard = 0; shard < nbShards; ++shard)
+        {
+            files.push_back(dir + "/shard" + std::to_string(shard) + "of" + std::to_string(nbShards) + ".hist");
+            TEST_CHECK(samplesCommon::writeHistograms(files.back(), collectShard(tensors, shard, nbShards, 333), err));
+        }
+        // Merged in order, in reverse and shuffled, the shards give the histograms of a single run
+        for (int order = 0; order < 3; ++order)
+        {
+            if (order == 1)
+            {
+                std::reverse(files.begin(), files.end());
+            }
+            else if (order == 2)
+            {
+                std::shuffle(files.begin(), files.end(), rng);
+            }
+            Histograms merged;
+            for (const auto& file : files)
+            {
+                TEST_CHECK(samplesCommon::readHistograms(file, merged, err));
+            }
+            TEST_CHECK(sameHistograms(merged, reference));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool testActivationHistogramZeros()
+{
+    // Small values, as after a ReLU with a small scale, then a chunk of zeros as from padding
+    std::mt19937 rng(0);
+    std::exponential_distribution<float> small(1000.F);
+    std::vector<float> values(1 << 20);
+    for (auto& v : values)
+    {
+        v = small(rng);
+    }
+    const std::vector<float> zeros(1 << 16, 0.F);
+
+    // The zeros in the same chunk as the values, which always gave the range of the values
+    std::vector<float> mixed(values);
+    mixed.insert(mixed.end(), zeros.begin(), zeros.end());
+    ActivationHistogram reference;
+    reference.add(mixed.data(), mixed.size());
+    TEST_CHECK(reference.getRangeExponent() < -4);
+
+    ActivationHistogram padded;
+    padded.add(values.data(), values.size());
+    padded.add(zeros.data(), zeros.size());
+    ActivationHistogram zerosFirst;
+    zerosFirst.add(zeros.data(), zeros.size());
+    zerosFirst.add(values.data(), values.size());
+    // The histogram of a shard of zeros merges without widening the range either
+    ActivationHistogram zeroShard;
+    zeroShard.add(zeros.data(), zeros.size());
+    ActivationHistogram merged;
+    merged.add(values.data(), values.size());
+    TEST_CHECK(merged.merge(zeroShard));
+
+    for (const ActivationHistogram* h : {&padded, &zerosFirst, &merged})
+    {
+        TEST_CHECK(h->getRangeExponent() == reference.getRangeExponent());
+        TEST_CHECK(h->getMaxRange() == reference.getMaxRange());
+        TEST_CHECK(h->getEntropyRange() == reference.getEntropyRange());
+        TEST_CHECK(h->getPercentileRange(99.99) == reference.getPercentileRange(99.99));
+    }
+
+    return true;
+}
+
+bool testActivationHistogramShards()
+{
+    const std::string dir = makeTestDirectory();
+    TEST_CHECK(!dir.empty());
+    const bool passed = checkActivationHistogramShards(dir);
+    removeTestDirectory(dir);
+    return passed;
+}
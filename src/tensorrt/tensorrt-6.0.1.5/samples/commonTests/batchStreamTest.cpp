@@ -0,0 +1,201 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "BatchStream.h"
+#include "commonTests.h"
+
+namespace
+{
+
+//!
+//! \brief Stream of one value batches holding their position in the data set, counted like BatchStream counts them
+//!
+class CountingBatchStream : public IBatchStream
+{
+public:
+    CountingBatchStream(int maxBatches, int nbBatches)
+        : mMaxBatches(maxBatches)
+        , mNbBatches(nbBatches)
+    {
+    }
+
+    void reset(int firstBatch) override
+    {
+        mBatchCount = 0;
+        mPosition = firstBatch;
+    }
+
+    bool next() override
+    {
+        if (mBatchCount == mMaxBatches || mPosition >= mNbBatches)
+        {
+            return false;
+        }
+        mBatch = mLabel = static_cast<float>(mPosition++);
+        ++mBatchCount;
+        return true;
+    }
+
+    void skip(int skipCount) override
+    {
+        mPosition += skipCount;
+    }
+
+    float* getBatch() override
+    {
+        return &mBatch;
+    }
+
+    float* getLabels() override
+    {
+        return &mLabel;
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchCount;
+    }
+
+    int getBatchSize() const override
+    {
+        return 1;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return nvinfer1::Dims4{1, 1, 1, 1};
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return nvinfer1::Dims3{1, 1, 1};
+    }
+
+private:
+    int mMaxBatches{0};
+    int mNbBatches{0};
+    int mBatchCount{0};
+    int mPosition{0};
+    float mBatch{0};
+    float mLabel{0};
+};
+
+//!
+//! \brief Skip skipCount batches, or with a negative count reset to batch -skipCount, after every batch of steps
+//!
+struct Step
+{
+    int batches;
+    int skipCount;
+};
+
+//!
+//! \brief Batches returned by stream through steps and until it has none left, with the count read after each one
+//!
+std::vector<std::pair<float, int>> run(IBatchStream& stream, const std::vector<Step>& steps)
+{
+    std::vector<std::pair<float, int>> batches;
+    auto read = [&](int count) {
+        for (int i = 0; i != count && stream.next(); ++i)
+        {
+            batches.emplace_back(stream.getBatch()[0], stream.getBatchesRead());
+            batches.emplace_back(stream.getLabels()[0], stream.getBatchesRead());
+        }
+    };
+    for (const auto& step : steps)
+    {
+        read(step.batches);
+        // Let the prefetching thread fill its ring, so that skip() has prefetched batches to drop.
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (step.skipCount < 0)
+        {
+            stream.reset(-step.skipCount);
+        }
+        else
+        {
+            stream.skip(step.skipCount);
+        }
+        batches.emplace_back(-1.F, stream.getBatchesRead());
+    }
+    read(-1);
+    return batches;
+}
+
+} // namespace
+
+bool testPrefetchBatchStreamSkip()
+{
+    const std::vector<std::vector<Step>> scripts{
+        {},
+        {{0, 2}},
+        {{1, 1}},
+        {{2, 1}, {1, 1}},
+        {{1, 3}, {2, 2}},
+        {{1, 1}, {1, 0}, {2, 10}},
+        {{3, 1}, {1, -2}, {2, 1}},
+    };
+    for (const int depth : {1, 2, 4})
+    {
+        // Ending at maxBatches, and at the end of the data set before it
+        for (const int maxBatches : {8, 20})
+        {
+            for (const auto& steps : scripts)
+            {
+                CountingBatchStream reference(maxBatches, 12);
+                PrefetchBatchStream<CountingBatchStream> prefetched(CountingBatchStream(maxBatches, 12), depth);
+                TEST_CHECK(run(reference, steps) == run(prefetched, steps));
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "buffers.h"
+#include "commonTests.h"
+
+using namespace samplesCommon;
+
+namespace
+{
+
+//!
+//! \brief Engine with the bindings of a recurrent step, answering only the queries of BufferManager
+//!
+//! \details Two inputs, data and hiddenIn, and two outputs, hiddenOut and prob, all linear. The state has the same
+//!          size and type in and out, so it can be swapped on the device like in sampleCharRNN.
+//!
+class FakeEngine : public nvinfer1::ICudaEngine
+{
+public:
+    int getNbBindings() const noexcept override { return kNB_BINDINGS; }
+    int getBindingIndex(const char* name) const noexcept override
+    {
+        const auto it = std::find_if(std::begin(kBINDINGS), std::end(kBINDINGS),
+            [name](const Binding& b) { return std::strcmp(b.name, name) == 0; });
+        return it == std::end(kBINDINGS) ? -1 : static_cast<int>(it - std::begin(kBINDINGS));
+    }
+    const char* getBindingName(int bindingIndex) const noexcept override { return kBINDINGS[bindingIndex].name; }
+    bool bindingIsInput(int bindingIndex) const noexcept override { return kBINDINGS[bindingIndex].isInput; }
+    nvinfer1::Dims getBindingDimensions(int bindingIndex) const noexcept override
+    {
+        nvinfer1::Dims dims{};
+        dims.nbDims = 1;
+        dims.d[0] = kBINDINGS[bindingIndex].volume;
+        return dims;
+    }
+    nvinfer1::DataType getBindingDataType(int bindingIndex) const noexcept override
+    {
+        return kBINDINGS[bindingIndex].type;
+    }
+    int getMaxBatchSize() const noexcept override { return kBATCH_SIZE; }
+    int getNbLayers() const noexcept override { return 0; }
+    std::size_t getWorkspaceSize() const noexcept override { return 0; }
+    nvinfer1::IHostMemory* serialize() const noexcept override { return nullptr; }
+    nvinfer1::IExecutionContext* createExecutionContext() noexcept override { return nullptr; }
+    void destroy() noexcept override { delete this; }
+    nvinfer1::TensorLocation getLocation(int) const noexcept override { return nvinfer1::TensorLocation::kDEVICE; }
+    nvinfer1::IExecutionContext* createExecutionContextWithoutDeviceMemory() noexcept override { return nullptr; }
+    size_t getDeviceMemorySize() const noexcept override { return 0; }
+    bool isRefittable() const noexcept override { return false; }
+    int getBindingBytesPerComponent(int bindingIndex) const noexcept override
+    {
+        return static_cast<int>(getElementSize(kBINDINGS[bindingIndex].type));
+    }
+    int getBindingComponentsPerElement(int) const noexcept override { return 1; }
+    nvinfer1::TensorFormat getBindingFormat(int) const noexcept override { return nvinfer1::TensorFormat::kLINEAR; }
+    const char* getBindingFormatDesc(int) const noexcept override { return "linear"; }
+    int getBindingVectorizedDim(int) const noexcept override { return -1; }
+    const char* getName() const noexcept override { return "fake"; }
+    int getNbOptimizationProfiles() const noexcept override { return 1; }
+    nvinfer1::Dims getProfileDimensions(int bindingIndex, int, nvinfer1::OptProfileSelector) const noexcept override
+    {
+        return getBindingDimensions(bindingIndex);
+    }
+    const int32_t* getProfileShapeValues(int, int, nvinfer1::OptProfileSelector) const noexcept override
+    {
+        return nullptr;
+    }
+    bool isShapeBinding(int) const noexcept override { return false; }
+    bool isExecutionBinding(int) const noexcept override { return true; }
+    nvinfer1::EngineCapability getEngineCapability() const noexcept override
+    {
+        return nvinfer1::EngineCapability::kDEFAULT;
+    }
+    void setErrorRecorder(nvinfer1::IErrorRecorder*) noexcept override {}
+    nvinfer1::IErrorRecorder* getErrorRecorder() const noexcept override { return nullptr; }
+    bool hasImplicitBatchDimension() const noexcept override { return true; }
+
+    static const int kBATCH_SIZE = 2;
+
+private:
+    struct Binding
+    {
+        const char* name;
+        bool isInput;
+        int volume;
+        nvinfer1::DataType type;
+    };
+
+    static const int kNB_BINDINGS = 4;
+    static const Binding kBINDINGS[kNB_BINDINGS];
+};
+
+const int FakeEngine::kBATCH_SIZE;
+
+const FakeEngine::Binding FakeEngine::kBINDINGS[FakeEngine::kNB_BINDINGS] = {
+    {"data", true, 4, nvinfer1::DataType::kFLOAT},
+    {"hiddenIn", true, 8, nvinfer1::DataType::kFLOAT},
+    {"hiddenOut", false, 8, nvinfer1::DataType::kFLOAT},
+    {"prob", false, 2, nvinfer1::DataType::kINT32},
+};
+
+//!
+//! \brief Fill the nbBytes / sizeof(float) floats at ptr with value
+//!
+void fill(void* ptr, size_t nbBytes, float value)
+{
+    std::fill_n(static_cast<float*>(ptr), nbBytes / sizeof(float), value);
+}
+
+//!
+//! \brief Whether the nbBytes / sizeof(float) floats at ptr are all value
+//!
+bool allOf(const void* ptr, size_t nbBytes, float value)
+{
+    const float* f = static_cast<const float*>(ptr);
+    return std::all_of(f, f + nbBytes / sizeof(float), [value](float x) { return x == value; });
+}
+
+} // namespace
+
+bool testBufferManagerBindings()
+{
+    std::shared_ptr<nvinfer1::ICudaEngine> engine(new FakeEngine, [](nvinfer1::ICudaEngine* e) { e->destroy(); });
+    BufferManager buffers(engine, FakeEngine::kBATCH_SIZE);
+    const size_t dataBytes = buffers.size("data");
+    const size_t hiddenBytes = buffers.size("hiddenIn");
+    TEST_CHECK(dataBytes == FakeEngine::kBATCH_SIZE * 4 * sizeof(float));
+    TEST_CHECK(hiddenBytes == FakeEngine::kBATCH_SIZE * 8 * sizeof(float));
+    TEST_CHECK(buffers.size("prob") == FakeEngine::kBATCH_SIZE * 2 * sizeof(int32_t));
+    TEST_CHECK(buffers.size("missing") == BufferManager::kINVALID_SIZE_VALUE);
+
+    void* const managedHost = buffers.getHostBuffer("data");
+    void* const managedDevice = buffers.getDeviceBuffer("data");
+    TEST_CHECK(managedHost && managedDevice && managedHost != managedDevice);
+    TEST_CHECK(buffers.getDeviceBindings()[0] == managedDevice);
+
+    // Unknown names, short buffers and other types are rejected and change nothing.
+    std::vector<float> hostData(dataBytes / sizeof(float) + 1);
+    TEST_CHECK(!buffers.setHostBuffer("missing", hostData.data(), dataBytes, nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(!buffers.setDeviceBuffer("missing", nullptr, 0, nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(!buffers.setCopyEnabled("missing", false));
+    TEST_CHECK(!buffers.setHostBuffer("data", hostData.data(), dataBytes - 1, nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(!buffers.setHostBuffer("data", hostData.data(), dataBytes, nvinfer1::DataType::kINT32));
+    TEST_CHECK(!buffers.setDeviceBuffer("prob", buffers.getDeviceBuffer("hiddenOut"), hiddenBytes,
+        nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(buffers.getHostBuffer("data") == managedHost);
+    TEST_CHECK(buffers.getDeviceBindings()[3] == buffers.getDeviceBuffer("prob"));
+
+    // A caller-owned buffer, larger than needed, is used by the copies, and nullptr restores the managed one.
+    TEST_CHECK(buffers.setHostBuffer("data", hostData.data(), hostData.size() * sizeof(float),
+        nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(buffers.getHostBuffer("data") == hostData.data());
+    fill(hostData.data(), dataBytes, 1.0F);
+    fill(buffers.getHostBuffer("hiddenIn"), hiddenBytes, 2.0F);
+    int copies = getCudaShimCopies();
+    buffers.copyInputToDevice();
+    TEST_CHECK(getCudaShimCopies() - copies == 2);
+    TEST_CHECK(allOf(managedDevice, dataBytes, 1.0F));
+    TEST_CHECK(allOf(buffers.getDeviceBuffer("hiddenIn"), hiddenBytes, 2.0F));
+    TEST_CHECK(buffers.setHostBuffer("data", nullptr, 0, nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(buffers.getHostBuffer("data") == managedHost);
+
+    // Disabled bindings are not copied, in either direction.
+    fill(buffers.getDeviceBuffer("hiddenOut"), hiddenBytes, 3.0F);
+    fill(buffers.getHostBuffer("hiddenOut"), hiddenBytes, 0.0F);
+    TEST_CHECK(buffers.setCopyEnabled("hiddenIn", false));
+    TEST_CHECK(buffers.setCopyEnabled("hiddenOut", false));
+    fill(buffers.getHostBuffer("hiddenIn"), hiddenBytes, 4.0F);
+    copies = getCudaShimCopies();
+    buffers.copyInputToDeviceAsync();
+    buffers.copyOutputToHostAsync();
+    TEST_CHECK(getCudaShimCopies() - copies == 2);
+    TEST_CHECK(allOf(buffers.getDeviceBuffer("hiddenIn"), hiddenBytes, 2.0F));
+    TEST_CHECK(allOf(buffers.getHostBuffer("hiddenOut"), hiddenBytes, 0.0F));
+    TEST_CHECK(buffers.setCopyEnabled("hiddenOut", true));
+    buffers.copyOutputToHost();
+    TEST_CHECK(allOf(buffers.getHostBuffer("hiddenOut"), hiddenBytes, 3.0F));
+
+    // Neither are bindings whose host and device pointers are the same, as for mapped memory.
+    TEST_CHECK(buffers.setHostBuffer("data", managedDevice, dataBytes, nvinfer1::DataType::kFLOAT));
+    copies = getCudaShimCopies();
+    buffers.copyInputToDevice();
+    TEST_CHECK(getCudaShimCopies() == copies);
+    TEST_CHECK(buffers.setHostBuffer("data", nullptr, 0, nvinfer1::DataType::kFLOAT));
+
+    // Swapping the state on the device, like sampleCharRNN between steps, swaps the bindings and the copies follow.
+    void* const hiddenIn = buffers.getDeviceBuffer("hiddenIn");
+    void* const hiddenOut = buffers.getDeviceBuffer("hiddenOut");
+    TEST_CHECK(buffers.setDeviceBuffer("hiddenIn", hiddenOut, hiddenBytes, nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(buffers.setDeviceBuffer("hiddenOut", hiddenIn, hiddenBytes, nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(buffers.getDeviceBindings()[1] == hiddenOut && buffers.getDeviceBindings()[2] == hiddenIn);
+    TEST_CHECK(buffers.getDeviceBuffer("hiddenIn") == hiddenOut);
+    buffers.copyOutputToHost();
+    TEST_CHECK(allOf(buffers.getHostBuffer("hiddenOut"), hiddenBytes, 2.0F));
+    TEST_CHECK(buffers.setDeviceBuffer("hiddenIn", nullptr, 0, nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(buffers.setDeviceBuffer("hiddenOut", nullptr, 0, nvinfer1::DataType::kFLOAT));
+    TEST_CHECK(buffers.getDeviceBindings()[1] == hiddenIn && buffers.getDeviceBindings()[2] == hiddenOut);
+    return true;
+}
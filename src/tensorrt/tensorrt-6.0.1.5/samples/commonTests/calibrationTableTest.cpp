@@ -0,0 +1,95 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "calibrationTable.h"
+#include "commonTests.h"
+
+using samplesCommon::CalibrationTable;
+
+bool testCalibrationTableRanges()
+{
+    // Ranges spread over several binades, many of which are an ulp off once divided by 127 and multiplied back
+    CalibrationTable table;
+    uint32_t state{1};
+    for (int i = 0; i < 10000; ++i)
+    {
+        state = state * 1664525U + 1013904223U;
+        const uint32_t bits = 0x3C000000U + (state >> 6);
+        float range;
+        std::memcpy(&range, &bits, sizeof(range));
+        table.setDynamicRange("tensor:" + std::to_string(i), range);
+        TEST_CHECK(table.getDynamicRange("tensor:" + std::to_string(i)) == range);
+    }
+
+    std::ostringstream err;
+    const std::string ranges = table.serializeDynamicRanges();
+    CalibrationTable read;
+    TEST_CHECK(read.parseDynamicRanges(ranges.data(), ranges.size(), err));
+    TEST_CHECK(read.size() == table.size());
+    TEST_CHECK(read.serializeDynamicRanges() == ranges);
+
+    // Short decimal ranges, as written by hand, come back with the same digits
+    const std::string decimal{"conv1:1.5\ndata:127\nprob:0.1\nscale:4.04721\n"};
+    TEST_CHECK(read.parseDynamicRanges(decimal.data(), decimal.size(), err));
+    TEST_CHECK(read.serializeDynamicRanges() == decimal);
+
+    // Ranges survive merges, and scales set directly are written as 127 times the scale
+    CalibrationTable merged;
+    merged.setScale("data", 1.F);
+    merged.merge(read, CalibrationTable::MergePolicy::kMAX);
+    TEST_CHECK(merged.serializeDynamicRanges() == decimal);
+    merged.setScale("data", 2.F);
+    TEST_CHECK(merged.getDynamicRange("data") == 254.F);
+    return true;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! \file commonTests.cpp
+//! \brief Tests of the infrastructure shared by the samples that runs without a GPU.
+//!
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include "commonTests.h"
+
+const std::string gSampleName = "TensorRT.common_tests";
+
+std::string makeTestDirectory()
+{
+    const char* tmp = std::getenv("TMPDIR");
+    std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/common_tests.XXXXXX";
+    return mkdtemp(&pattern[0]) ? pattern : std::string();
+}
+
+void removeTestDirectory(const std::string& directory)
+{
+    if (DIR* dir = opendir(directory.c_str()))
+    {
+        while (const dirent* entry = readdir(dir))
+        {
+            const std::string name = entry->d_name;
+            if (name != "." && name != "..")
+            {
+                std::remove((directory + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(directory.c_str());
+}
+
+bool writeTestFile(const std::string& fileName, const std::string& contents)
+{
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file << contents;
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char** argv)
+{
+    auto sampleTest = gLogger.defineTest(gSampleName, argc, argv);
+    gLogger.reportTestStart(sampleTest);
+
+    const std::vector<std::pair<std::string, bool (*)()>> tests{
+        {"open loop inference", testOpenLoopInference},
+        {"open loop poisson arrivals", testOpenLoopPoissonArrivals},
+        {"activation histogram of zeros", testActivationHistogramZeros},
+        {"activation histogram shards", testActivationHistogramShards},
+        {"memory arena", testMemoryArena},
+        {"buffer growth", testBufferGrowth},
+        {"buffer manager bindings", testBufferManagerBindings},
+        {"engine cache key", testEngineCacheKey},
+        {"engine cache", testEngineCache},
+        {"weight index", testWeightIndex},
+        {"packed dataset header", testPackedDatasetHeader},
+        {"prefetch batch stream skip", testPrefetchBatchStreamSkip},
+        {"calibration table ranges", testCalibrationTableRanges},
+    };
+    bool passed{true};
+    for (const auto& test : tests)
+    {
+        const bool ok = test.second();
+        gLogInfo << (ok ? "PASSED " : "FAILED ") << test.first << std::endl;
+        passed = passed && ok;
+    }
+
+    return passed ? gLogger.reportPass(sampleTest) : gLogger.reportFail(sampleTest);
+}
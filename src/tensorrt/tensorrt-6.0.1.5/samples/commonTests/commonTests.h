@@ -0,0 +1,157 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef COMMON_TESTS_H
+#define COMMON_TESTS_H
+
+#include "logger.h"
+
+#include <string>
+
+//!
+//! \brief Return false from the enclosing test, logging the failed condition, unless it holds
+//!
+#define TEST_CHECK(condition)                                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            gLogError << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl;                    \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+//!
+//! \brief Create an empty directory for the files of a test, in TMPDIR or /tmp
+//!
+//! \return The path of the directory, empty if it could not be created
+//!
+std::string makeTestDirectory();
+
+//!
+//! \brief Remove a directory created by makeTestDirectory and the files in it
+//!
+void removeTestDirectory(const std::string& directory);
+
+//!
+//! \brief Replace the contents of fileName
+//!
+bool writeTestFile(const std::string& fileName, const std::string& contents);
+
+//!
+//! \brief Open loop scheduling against CPU stand-ins with a known service time
+//!
+bool testOpenLoopInference();
+
+//!
+//! \brief Seeded Poisson arrivals of the open loop scheduler have the requested rate and are reproducible with --seed
+//!
+bool testOpenLoopPoissonArrivals();
+
+//!
+//! \brief Chunks of zeros added to the histogram of a small valued tensor leave its ranges as they are
+//!
+bool testActivationHistogramZeros();
+
+//!
+//! \brief Histograms collected as 1, 2 or 5 shards and merged in any order are those of a single run
+//!
+bool testActivationHistogramShards();
+
+//!
+//! \brief Size classes, reuse, statistics and cache limits of MemoryArena, and release of its cache with its users
+//!
+bool testMemoryArena();
+
+//!
+//! \brief Capacities chosen by the growth policies of GenericBuffer
+//!
+bool testBufferGrowth();
+
+//!
+//! \brief Caller-owned buffers, disabled copies and swapped bindings of BufferManager, over a fake engine
+//!
+bool testBufferManagerBindings();
+
+//!
+//! \brief Number of copies made so far by the host memory stand-ins of the CUDA runtime in cudaShim.cpp
+//!
+int getCudaShimCopies();
+
+//!
+//! \brief Engine cache keys are stable and change with every model file, option, plugin and platform they cover
+//!
+bool testEngineCacheKey();
+
+//!
+//! \brief LRU eviction, reload after reopening, and recovery from a damaged index or engine of the engine cache
+//!
+bool testEngineCache();
+
+//!
+//! \brief The sidecar index of wts v2 files is written, reused, and rebuilt when the file changes or is damaged
+//!
+bool testWeightIndex();
+
+//!
+//! \brief Packed datasets read back what PackedDatasetWriter wrote, and headers with overflowing sizes are rejected
+//!
+bool testPackedDatasetHeader();
+
+//!
+//! \brief PrefetchBatchStream returns the batches and counts of the wrapped stream through skip() and reset()
+//!
+bool testPrefetchBatchStreamSkip();
+
+//!
+//! \brief Dynamic ranges set or read by CalibrationTable are written back unchanged
+//!
+bool testCalibrationTableRanges();
+
+#endif // COMMON_TESTS_H
@@ -0,0 +1,159 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! \file cudaShim.cpp
+//! \brief Host memory stand-ins for the memory functions of the CUDA runtime used by BufferManager.
+//!
+//! \details Defined in the test binary, they take precedence over the ones of the shared libcudart, so the buffers
+//!          can be tested without a GPU. "Device" memory is malloc'd, and the device side of every copy has to lie in
+//!          such an allocation, which catches host and device pointers mixed up by the caller.
+//!
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#include <cuda_runtime_api.h>
+
+#include "commonTests.h"
+
+namespace
+{
+
+std::mutex gShimMutex;
+std::map<const char*, size_t> gDeviceAllocations; //!< Size of each "device" allocation by its address
+int gShimCopies{0};
+
+//!
+//! \brief Whether [ptr, ptr + size) lies in one "device" allocation, the caller holding gShimMutex
+//!
+bool isDeviceRange(const void* ptr, size_t size)
+{
+    const char* begin = static_cast<const char*>(ptr);
+    auto next = gDeviceAllocations.upper_bound(begin);
+    if (next == gDeviceAllocations.begin())
+    {
+        return false;
+    }
+    --next;
+    return begin + size <= next->first + next->second;
+}
+
+cudaError_t copy(void* dst, const void* src, size_t count, cudaMemcpyKind kind)
+{
+    std::lock_guard<std::mutex> lock(gShimMutex);
+    const bool deviceDst = kind == cudaMemcpyHostToDevice || kind == cudaMemcpyDeviceToDevice;
+    const bool deviceSrc = kind == cudaMemcpyDeviceToHost || kind == cudaMemcpyDeviceToDevice;
+    if ((deviceDst && !isDeviceRange(dst, count)) || (deviceSrc && !isDeviceRange(src, count)))
+    {
+        return cudaErrorInvalidValue;
+    }
+    std::memmove(dst, src, count);
+    ++gShimCopies;
+    return cudaSuccess;
+}
+
+} // namespace
+
+int getCudaShimCopies()
+{
+    std::lock_guard<std::mutex> lock(gShimMutex);
+    return gShimCopies;
+}
+
+cudaError_t CUDARTAPI cudaMalloc(void** devPtr, size_t size)
+{
+    *devPtr = std::malloc(size ? size : 1);
+    if (!*devPtr)
+    {
+        return cudaErrorMemoryAllocation;
+    }
+    std::lock_guard<std::mutex> lock(gShimMutex);
+    gDeviceAllocations[static_cast<const char*>(*devPtr)] = size;
+    return cudaSuccess;
+}
+
+cudaError_t CUDARTAPI cudaFree(void* devPtr)
+{
+    if (devPtr)
+    {
+        std::lock_guard<std::mutex> lock(gShimMutex);
+        if (!gDeviceAllocations.erase(static_cast<const char*>(devPtr)))
+        {
+            return cudaErrorInvalidValue;
+        }
+    }
+    std::free(devPtr);
+    return cudaSuccess;
+}
+
+cudaError_t CUDARTAPI cudaHostAlloc(void** pHost, size_t size, unsigned int /*flags*/)
+{
+    *pHost = std::malloc(size ? size : 1);
+    return *pHost ? cudaSuccess : cudaErrorMemoryAllocation;
+}
+
+cudaError_t CUDARTAPI cudaFreeHost(void* ptr)
+{
+    std::free(ptr);
+    return cudaSuccess;
+}
+
+cudaError_t CUDARTAPI cudaMemcpy(void* dst, const void* src, size_t count, cudaMemcpyKind kind)
+{
+    return copy(dst, src, count, kind);
+}
+
+cudaError_t CUDARTAPI cudaMemcpyAsync(
+    void* dst, const void* src, size_t count, cudaMemcpyKind kind, cudaStream_t /*stream*/)
+{
+    return copy(dst, src, count, kind);
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "commonTests.h"
+#include "engineCache.h"
+
+using namespace sample;
+
+namespace
+{
+
+struct KeyOptions
+{
+    ModelOptions model;
+    BuildOptions build;
+    SystemOptions sys;
+    std::string platform{"6.0.1.5 sm_75"};
+};
+
+bool computeKey(const KeyOptions& options, std::string& key)
+{
+    std::ostringstream err;
+    return computeEngineKey(options.model, options.build, options.sys, options.platform, key, err);
+}
+
+//!
+//! \brief A key of 32 hex digits for the i-th engine of a test
+//!
+std::string testKey(int64_t i)
+{
+    return ContentHasher().add(i).digest();
+}
+
+bool checkEngineCacheKey(const std::string& dir)
+{
+    for (const std::string name : {"model.onnx", "moved.onnx", "other.onnx", "deploy.prototxt", "plugin.so",
+             "plugin2.so", "calibration", "calibration2"})
+    {
+        const bool isModel = name == "model.onnx" || name == "moved.onnx";
+        TEST_CHECK(writeTestFile(dir + "/" + name, isModel ? "model" : "contents of " + name));
+    }
+
+    KeyOptions base;
+    base.model.baseModel.format = ModelFormat::kONNX;
+    base.model.baseModel.model = dir + "/model.onnx";
+    base.sys.plugins.push_back(dir + "/plugin.so");
+    std::string baseKey;
+    TEST_CHECK(computeKey(base, baseKey));
+    TEST_CHECK(baseKey.size() == 32);
+
+    // Stable across calls and moves of the model, and independent of the options that do not change the engine
+    std::vector<std::function<void(KeyOptions&)>> same{
+        [](KeyOptions&) {},
+        [&](KeyOptions& o) { o.model.baseModel.model = dir + "/moved.onnx"; },
+        [&](KeyOptions& o) { o.build.calibration = dir + "/missing"; },
+        [](KeyOptions& o) { o.build.save = true; },
+        [](KeyOptions& o) { o.build.load = true; },
+        [](KeyOptions& o) { o.build.engine = "model.engine"; },
+        [](KeyOptions& o) { o.build.cacheDir = "cache"; },
+        [](KeyOptions& o) { o.build.cacheSize = 1; },
+        [](KeyOptions& o) { o.sys.device = 1; },
+    };
+    for (const auto& change : same)
+    {
+        KeyOptions options(base);
+        change(options);
+        std::string key;
+        TEST_CHECK(computeKey(options, key));
+        TEST_CHECK(key == baseKey);
+    }
+
+    // Each of these gives a key of its own
+    const nvinfer1::Dims3 dims(1, 2, 3);
+    const IOFormat half{nvinfer1::DataType::kHALF, 1U << static_cast<int>(nvinfer1::TensorFormat::kCHW2)};
+    std::vector<std::function<void(KeyOptions&)>> changes{
+        [](KeyOptions& o) { o.model.baseModel.format = ModelFormat::kCAFFE; },
+        [&](KeyOptions& o) { o.model.baseModel.model = dir + "/other.onnx"; },
+        [&](KeyOptions& o) { o.model.prototxt = dir + "/deploy.prototxt"; },
+        [](KeyOptions& o) { o.model.outputs.push_back("prob"); },
+        [&](KeyOptions& o) { o.model.uffInputs.inputs.emplace_back("input", dims); },
+        [](KeyOptions& o) { o.model.uffInputs.NHWC = true; },
+        [](KeyOptions& o) { ++o.build.maxBatch; },
+        [](KeyOptions& o) { ++o.build.workspace; },
+        [](KeyOptions& o) { ++o.build.minTiming; },
+        [](KeyOptions& o) { ++o.build.avgTiming; },
+        [](KeyOptions& o) { o.build.fp16 = true; },
+        [](KeyOptions& o) { o.build.int8 = true; },
+        [](KeyOptions& o) { o.build.safe = true; },
+        [&](KeyOptions& o) { o.build.calibration = dir + "/calibration"; },
+        [&](KeyOptions& o) { o.build.calibration = dir + "/calibration2"; },
+        [&](KeyOptions& o) { o.build.shapes["input"] = ShapeRange{{dims, dims, dims}}; },
+        [&](KeyOptions& o) { o.build.inputFormats.push_back(half); },
+        [&](KeyOptions& o) { o.build.outputFormats.push_back(half); },
+        [](KeyOptions& o) { o.sys.DLACore = 0; },
+        [](KeyOptions& o) { o.sys.fallback = true; },
+        [&](KeyOptions& o) { o.sys.plugins = {dir + "/plugin2.so"}; },
+        [&](KeyOptions& o) { o.sys.plugins.push_back(dir + "/plugin2.so"); },
+        [](KeyOptions& o) { o.sys.plugins.clear(); },
+        [](KeyOptions& o) { o.platform = "6.0.1.5 sm_70"; },
+        [](KeyOptions& o) { o.platform = "7.0.0.11 sm_75"; },
+    };
+    std::set<std::string> keys{baseKey};
+    for (const auto& change : changes)
+    {
+        KeyOptions options(base);
+        change(options);
+        std::string key;
+        TEST_CHECK(computeKey(options, key));
+        TEST_CHECK(keys.insert(key).second);
+    }
+
+    // Files are keyed by contents, so changing the model in place changes the key, and missing ones are errors
+    TEST_CHECK(writeTestFile(dir + "/model.onnx", "model, retrained"));
+    std::string key;
+    TEST_CHECK(computeKey(base, key));
+    TEST_CHECK(!keys.count(key));
+    KeyOptions missing(base);
+    missing.model.baseModel.model = dir + "/missing.onnx";
+    TEST_CHECK(!computeKey(missing, key));
+    missing = base;
+    missing.sys.plugins.push_back(dir + "/missing.so");
+    TEST_CHECK(!computeKey(missing, key));
+    return true;
+}
+
+//!
+//! \brief Whether the cache holds the engine key with these contents
+//!
+bool holds(EngineCache& cache, const std::string& key, const std::string& contents)
+{
+    samplesCommon::MappedFile engine;
+    return cache.load(key, engine) && engine.size() == contents.size()
+        && std::string(reinterpret_cast<const char*>(engine.data()), engine.size()) == contents;
+}
+
+bool checkEngineCache(const std::string& dir)
+{
+    const std::string a(40, 'a');
+    const std::string b(40, 'b');
+    const std::string c(40, 'c');
+    std::ostringstream err;
+    {
+        EngineCache cache(dir, 100);
+        TEST_CHECK(cache.size() == 0);
+        TEST_CHECK(!holds(cache, testKey(0), a));
+        TEST_CHECK(cache.store(testKey(0), a.data(), a.size(), err));
+        TEST_CHECK(cache.store(testKey(1), b.data(), b.size(), err));
+        TEST_CHECK(cache.size() == 80);
+
+        // Loading the first engine makes the second one the least recently used, evicted to store the third
+        TEST_CHECK(holds(cache, testKey(0), a));
+        TEST_CHECK(cache.store(testKey(2), c.data(), c.size(), err));
+        TEST_CHECK(cache.size() == 80);
+        TEST_CHECK(!holds(cache, testKey(1), b));
+        TEST_CHECK(holds(cache, testKey(2), c));
+    }
+
+    // A new instance reads the engines and their order of use back from the index
+    {
+        EngineCache cache(dir, 100);
+        TEST_CHECK(cache.size() == 80);
+        TEST_CHECK(cache.store(testKey(1), b.data(), b.size(), err));
+        TEST_CHECK(!holds(cache, testKey(0), a));
+        TEST_CHECK(holds(cache, testKey(2), c));
+        TEST_CHECK(holds(cache, testKey(1), b));
+    }
+
+    // An index that does not parse is rebuilt from the engines in the directory, which are checked when next loaded
+    const std::vector<std::string> damagedIndexes{"", "garbage\n", "engine-cache 1\n",
+        "engine-cache 2\nnot an entry\n", "engine-cache 2\n" + testKey(1) + " 40 1 - extra\n"};
+    for (const auto& index : damagedIndexes)
+    {
+        TEST_CHECK(writeTestFile(dir + "/index", index));
+        EngineCache cache(dir, 100);
+        TEST_CHECK(cache.size() == 80);
+        TEST_CHECK(holds(cache, testKey(1), b));
+        TEST_CHECK(holds(cache, testKey(2), c));
+    }
+    std::remove((dir + "/index").c_str());
+    {
+        EngineCache cache(dir, 100);
+        TEST_CHECK(cache.size() == 80);
+
+        // Recovered engines are the least recently used until loaded again
+        TEST_CHECK(holds(cache, testKey(2), c));
+        TEST_CHECK(cache.store(testKey(0), a.data(), a.size(), err));
+        TEST_CHECK(!holds(cache, testKey(1), b));
+        TEST_CHECK(cache.size() == 80);
+    }
+
+    // An engine that differs from its index entry is dropped, so that it is rebuilt rather than deserialized
+    {
+        EngineCache cache(dir, 100);
+        const std::string x(40, 'x');
+        TEST_CHECK(writeTestFile(dir + "/" + testKey(0) + ".engine", x));
+        TEST_CHECK(!holds(cache, testKey(0), x));
+        TEST_CHECK(cache.size() == 40);
+        TEST_CHECK(writeTestFile(dir + "/" + testKey(2) + ".engine", c.substr(0, 20)));
+        TEST_CHECK(!holds(cache, testKey(2), c.substr(0, 20)));
+        TEST_CHECK(cache.size() == 0);
+
+        TEST_CHECK(cache.store(testKey(0), a.data(), a.size(), err));
+        TEST_CHECK(holds(cache, testKey(0), a));
+    }
+    return true;
+}
+
+} // namespace
+
+bool testEngineCacheKey()
+{
+    const std::string dir = makeTestDirectory();
+    TEST_CHECK(!dir.empty());
+    const bool passed = checkEngineCacheKey(dir);
+    removeTestDirectory(dir);
+    return passed;
+}
+
+bool testEngineCache()
+{
+    const std::string dir = makeTestDirectory();
+    TEST_CHECK(!dir.empty());
+    const bool passed = checkEngineCache(dir);
+    removeTestDirectory(dir);
+    return passed;
+}
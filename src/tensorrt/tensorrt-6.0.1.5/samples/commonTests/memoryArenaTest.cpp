@@ -0,0 +1,225 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <cstdlib>
+
+#include "buffers.h"
+#include "commonTests.h"
+#include "memoryArena.h"
+
+using namespace samplesCommon;
+
+namespace
+{
+
+//!
+//! \brief malloc backend counting its calls, failing the next failures allocations
+//!
+struct CountingHostMemory
+{
+    static int allocations;
+    static int releases;
+    static int failures;
+
+    static bool allocate(void** ptr, size_t size)
+    {
+        if (failures > 0)
+        {
+            --failures;
+            return false;
+        }
+        ++allocations;
+        *ptr = std::malloc(size);
+        return *ptr != nullptr;
+    }
+
+    static void release(void* ptr)
+    {
+        ++releases;
+        std::free(ptr);
+    }
+};
+
+int CountingHostMemory::allocations{0};
+int CountingHostMemory::releases{0};
+int CountingHostMemory::failures{0};
+
+using Arena = MemoryArena<CountingHostMemory>;
+
+} // namespace
+
+bool testMemoryArena()
+{
+    // Four classes per power of two: no class wastes more than a quarter of its block.
+    TEST_CHECK(Arena::sizeClass(1) == Arena::kMIN_BLOCK);
+    TEST_CHECK(Arena::sizeClass(256) == 256);
+    TEST_CHECK(Arena::sizeClass(257) == 320);
+    TEST_CHECK(Arena::sizeClass(1000) == 1024);
+    TEST_CHECK(Arena::sizeClass(1025) == 1280);
+    for (size_t size = Arena::kMIN_BLOCK; size < (size_t(1) << 20); size += 97)
+    {
+        const size_t bytes = Arena::sizeClass(size);
+        TEST_CHECK(bytes >= size && 4 * bytes <= 5 * size + 4 * Arena::kMIN_BLOCK);
+        TEST_CHECK(Arena::sizeClass(bytes) == bytes);
+    }
+
+    const int allocations = CountingHostMemory::allocations;
+    const int releases = CountingHostMemory::releases;
+    {
+        Arena arena(4096);
+        void* a{nullptr};
+        void* b{nullptr};
+        TEST_CHECK(arena.allocate(&a, 1000));
+        TEST_CHECK(arena.allocate(&b, 2000));
+        ArenaStats stats = arena.getStats();
+        TEST_CHECK(stats.requests == 2 && stats.reused == 0 && stats.backendAllocs == 2);
+        TEST_CHECK(stats.bytesInUse == 1024 + 2048 && stats.peakBytesInUse == 1024 + 2048);
+
+        // A freed block serves the next request of its class only.
+        arena.release(a);
+        void* c{nullptr};
+        TEST_CHECK(arena.allocate(&c, 900));
+        TEST_CHECK(c == a);
+        void* d{nullptr};
+        TEST_CHECK(arena.allocate(&d, 1100));
+        TEST_CHECK(d != a);
+        stats = arena.getStats();
+        TEST_CHECK(stats.requests == 4 && stats.reused == 1 && stats.backendAllocs == 3);
+        TEST_CHECK(stats.bytesInUse == 1024 + 2048 + 1280 && stats.peakBytesInUse == stats.bytesInUse);
+        TEST_CHECK(CountingHostMemory::allocations - allocations == 3);
+
+        // The cache holds 4096 bytes: 2048 + 1024 fit, the 1280 of d would not and go back to the backend.
+        arena.release(b);
+        arena.release(c);
+        arena.release(d);
+        arena.release(nullptr);
+        stats = arena.getStats();
+        TEST_CHECK(stats.bytesInUse == 0 && stats.peakBytesInUse == 1024 + 2048 + 1280);
+        TEST_CHECK(stats.bytesCached == 1024 + 2048);
+        TEST_CHECK(stats.backendFrees == 1);
+        TEST_CHECK(CountingHostMemory::releases - releases == 1);
+
+        // A failed backend allocation gives the cache back before retrying.
+        CountingHostMemory::failures = 1;
+        void* e{nullptr};
+        TEST_CHECK(arena.allocate(&e, 8192));
+        stats = arena.getStats();
+        TEST_CHECK(stats.bytesCached == 0 && stats.backendFrees == 3);
+        TEST_CHECK(CountingHostMemory::releases - releases == 3);
+
+        // Lowering the limit under the cached bytes releases them.
+        arena.release(e);
+        TEST_CHECK(arena.getStats().bytesCached == 0);
+        arena.setCacheLimit(16384);
+        TEST_CHECK(arena.allocate(&e, 8192));
+        arena.release(e);
+        TEST_CHECK(arena.getStats().bytesCached == 8192);
+        arena.setCacheLimit(4096);
+        TEST_CHECK(arena.getCacheLimit() == 4096);
+        TEST_CHECK(arena.getStats().bytesCached == 0);
+    }
+    TEST_CHECK(CountingHostMemory::allocations - allocations == CountingHostMemory::releases - releases);
+
+    // The cache of the process wide arena lives as long as its users.
+    Arena& shared = getArena<CountingHostMemory>();
+    TEST_CHECK(shared.getCacheLimit() == Arena::kDEFAULT_CACHE_LIMIT);
+    {
+        ArenaUser<CountingHostMemory> first;
+        {
+            ArenaUser<CountingHostMemory> second;
+            ArenaUser<CountingHostMemory> copy(second);
+            void* block{nullptr};
+            TEST_CHECK(shared.allocate(&block, 4096));
+            shared.release(block);
+        }
+        TEST_CHECK(shared.getStats().bytesCached == 4096);
+    }
+    TEST_CHECK(shared.getStats().bytesCached == 0);
+
+    return true;
+}
+
+bool testBufferGrowth()
+{
+    using GeometricBuffer
+        = GenericBuffer<ArenaAllocator<CountingHostMemory>, ArenaFree<CountingHostMemory>, GeometricGrowth>;
+    using ExactBuffer = GenericBuffer<ArenaAllocator<CountingHostMemory>, ArenaFree<CountingHostMemory>, ExactGrowth>;
+
+    ArenaUser<CountingHostMemory> user;
+    const size_t requests = getArena<CountingHostMemory>().getStats().requests;
+    {
+        // Doubling the capacity: growing by one element at a time reallocates O(log n) times.
+        GeometricBuffer geometric(nvinfer1::DataType::kFLOAT);
+        geometric.resize(10);
+        TEST_CHECK(geometric.size() == 10 && geometric.capacity() == 10);
+        geometric.resize(11);
+        TEST_CHECK(geometric.capacity() == 20);
+        geometric.resize(5);
+        TEST_CHECK(geometric.size() == 5 && geometric.capacity() == 20);
+        geometric.resize(100);
+        TEST_CHECK(geometric.capacity() == 100 && geometric.nbBytes() == 400);
+        for (size_t n = 101; n <= 1000; ++n)
+        {
+            geometric.resize(n);
+        }
+        TEST_CHECK(geometric.capacity() == 1600);
+        TEST_CHECK(getArena<CountingHostMemory>().getStats().requests - requests == 7);
+
+        ExactBuffer exact(nvinfer1::DataType::kHALF);
+        for (size_t n = 1; n <= 8; ++n)
+        {
+            exact.resize(n);
+            TEST_CHECK(exact.capacity() == n);
+        }
+        TEST_CHECK(exact.nbBytes() == 16);
+    }
+    TEST_CHECK(getArena<CountingHostMemory>().getStats().bytesInUse == 0);
+
+    return true;
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "commonTests.h"
+#include "sampleInference.h"
+
+using namespace sample;
+
+namespace
+{
+
+//!
+//! \brief Simulated clock, moving to the earliest wake up time whenever every attached thread is asleep
+//!
+//! \details Runs take no wall time and their timings are exact, whatever the load of the host.
+//!
+class VirtualClock : public IInferenceClock
+{
+public:
+    double now() override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mNow;
+    }
+
+    void sleepUntil(double time) override
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (time <= mNow)
+        {
+            return;
+        }
+        mWakeUps.insert(time);
+        advance();
+        mAdvanced.wait(lock, [this, time] { return mNow >= time; });
+    }
+
+    void attach() override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mAttached;
+    }
+
+    void detach() override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        --mAttached;
+        advance();
+    }
+
+private:
+    //! Wake the earliest sleepers if nobody else can make progress, the caller holds the lock
+    void advance()
+    {
+        if (mWakeUps.empty() || static_cast<int>(mWakeUps.size()) < mAttached)
+        {
+            return;
+        }
+        mNow = *mWakeUps.begin();
+        mWakeUps.erase(mWakeUps.begin(), mWakeUps.upper_bound(mNow));
+        mAdvanced.notify_all();
+    }
+
+    std::mutex mMutex;
+    std::condition_variable mAdvanced;
+    double mNow{0};
+    int mAttached{0};
+    std::multiset<double> mWakeUps; //!< Times the sleeping threads wait for
+};
+
+struct OpenLoopRun
+{
+    OpenLoopStats stats;
+    std::vector<InferenceTrace> traces;
+};
+
+bool runCpuOpenLoop(int nbExecutors, float serviceTime, const InferenceSchedule& schedule, OpenLoopRun& run)
+{
+    VirtualClock clock;
+    std::vector<std::unique_ptr<CpuStreamExecutor>> executors;
+    std::vector<IStreamExecutor*> streams;
+    for (int e = 0; e < nbExecutors; ++e)
+    {
+        executors.emplace_back(new CpuStreamExecutor(serviceTime, clock));
+        streams.push_back(executors.back().get());
+    }
+    const auto onTrace = [&run](const InferenceTrace& trace) { run.traces.push_back(trace); };
+    if (!runOpenLoopInference(streams, schedule, onTrace, run.stats, gLogError, &clock))
+    {
+        return false;
+    }
+    // Traces complete out of order across executors, sort them by arrival
+    std::sort(run.traces.begin(), run.traces.end(),
+        [](const InferenceTrace& a, const InferenceTrace& b) { return a.arrival < b.arrival; });
+    return true;
+}
+
+bool runCpuOpenLoop(int nbExecutors, float serviceTime, float qps, float duration, OpenLoopRun& run)
+{
+    InferenceSchedule schedule;
+    schedule.duration = duration;
+    schedule.qps = qps;
+    return runCpuOpenLoop(nbExecutors, serviceTime, schedule, run);
+}
+
+float maxQueueTime(const std::vector<InferenceTrace>& traces)
+{
+    float queueTime{0};
+    for (const auto& trace : traces)
+    {
+        queueTime = std::max(queueTime, trace.queueTime());
+    }
+    return queueTime;
+}
+
+} // namespace
+
+bool testOpenLoopInference()
+{
+    // 100 qps served in 2 ms: every arrival is served on time.
+    OpenLoopRun idle;
+    TEST_CHECK(runCpuOpenLoop(1, 2.F, 100.F, 500.F, idle));
+    TEST_CHECK(idle.stats.arrivals == 50);
+    TEST_CHECK(idle.stats.unserved == 0);
+    TEST_CHECK(idle.traces.size() == 50);
+    TEST_CHECK(maxQueueTime(idle.traces) == 0.F);
+    for (const auto& trace : idle.traces)
+    {
+        TEST_CHECK(trace.gpuTime == 2.F);
+        TEST_CHECK(trace.latency() == 2.F);
+    }
+
+    // 200 qps served in 10 ms by one executor: the launches at 0, 10, ..., 490 ms serve the first 50 arrivals, the
+    // other 50 are left, and the queue grows by 5 ms per inference.
+    OpenLoopRun overloaded;
+    TEST_CHECK(runCpuOpenLoop(1, 10.F, 200.F, 500.F, overloaded));
+    TEST_CHECK(overloaded.stats.arrivals == 100);
+    TEST_CHECK(overloaded.stats.unserved == 50);
+    TEST_CHECK(overloaded.traces.size() == 50);
+    for (size_t i = 0; i < overloaded.traces.size(); ++i)
+    {
+        TEST_CHECK(overloaded.traces[i].queueTime() == 5.F * i);
+    }
+    TEST_CHECK(maxQueueTime(overloaded.traces) == 245.F);
+
+    // The same load on three executors has spare capacity again.
+    OpenLoopRun scaled;
+    TEST_CHECK(runCpuOpenLoop(3, 10.F, 200.F, 500.F, scaled));
+    TEST_CHECK(scaled.stats.arrivals == 100);
+    TEST_CHECK(scaled.stats.unserved == 0);
+    TEST_CHECK(maxQueueTime(scaled.traces) == 0.F);
+
+    return true;
+}
+
+bool testOpenLoopPoissonArrivals()
+{
+    // 1000 qps for 10 s: about 10000 arrivals, 1 ms apart on average, with a standard deviation of 100 on the count.
+    InferenceSchedule schedule;
+    schedule.duration = 10000.F;
+    schedule.qps = 1000.F;
+    schedule.poisson = true;
+    schedule.seed = 42;
+
+    OpenLoopRun run;
+    TEST_CHECK(runCpuOpenLoop(4, 0.5F, schedule, run));
+    TEST_CHECK(run.stats.unserved + static_cast<int64_t>(run.traces.size()) == run.stats.arrivals);
+    TEST_CHECK(run.stats.arrivals > 9600 && run.stats.arrivals < 10400);
+    TEST_CHECK(run.traces.size() > 1);
+    const double meanGap = (run.traces.back().arrival - run.traces.front().arrival) / (run.traces.size() - 1);
+    TEST_CHECK(meanGap > 0.96 && meanGap < 1.04);
+
+    // Gaps of a Poisson process are exponential: their standard deviation is their mean, unlike fixed arrivals.
+    double squares{0};
+    for (size_t i = 1; i < run.traces.size(); ++i)
+    {
+        const double gap = run.traces[i].arrival - run.traces[i - 1].arrival;
+        squares += (gap - meanGap) * (gap - meanGap);
+    }
+    const double deviation = std::sqrt(squares / (run.traces.size() - 1));
+    TEST_CHECK(deviation > 0.9 && deviation < 1.1);
+
+    // The seed fixes the arrivals.
+    OpenLoopRun again;
+    TEST_CHECK(runCpuOpenLoop(4, 0.5F, schedule, again));
+    TEST_CHECK(again.stats.arrivals == run.stats.arrivals);
+    TEST_CHECK(again.traces.size() == run.traces.size());
+    for (size_t i = 0; i < run.traces.size(); ++i)
+    {
+        TEST_CHECK(again.traces[i].arrival == run.traces[i].arrival);
+    }
+    schedule.seed = 43;
+    OpenLoopRun reseeded;
+    TEST_CHECK(runCpuOpenLoop(4, 0.5F, schedule, reseeded));
+    TEST_CHECK(reseeded.stats.arrivals != run.stats.arrivals || reseeded.traces[1].arrival != run.traces[1].arrival);
+
+    // --seed reaches the schedule, and without it the seed comes from the clock
+    Arguments arguments{{"--qps", "1000"}, {"--arrivals", "poisson"}, {"--seed", "42"}};
+    InferenceOptions options;
+    options.parse(arguments);
+    TEST_CHECK(InferenceSchedule::fromOptions(options).seed == 42);
+    arguments = {{"--qps", "1000"}, {"--arrivals", "poisson"}};
+    options.parse(arguments);
+    TEST_CHECK(InferenceSchedule::fromOptions(options).seed != 42);
+
+    return true;
+}
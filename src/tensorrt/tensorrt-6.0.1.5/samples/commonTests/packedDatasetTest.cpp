@@ -0,0 +1,138 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "commonTests.h"
+#include "packedDataset.h"
+
+using samplesCommon::PackedDataset;
+using samplesCommon::PackedDatasetHeader;
+
+namespace
+{
+
+std::string readTestFile(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+//!
+//! \brief Write a copy of the dataset in valid with its header changed by change
+//!
+template <typename Change>
+bool writeChanged(const std::string& valid, const std::string& fileName, Change change)
+{
+    std::string contents = readTestFile(valid);
+    PackedDatasetHeader header;
+    std::memcpy(&header, &contents[0], sizeof(header));
+    change(header);
+    std::memcpy(&contents[0], &header, sizeof(header));
+    return writeTestFile(fileName, contents);
+}
+
+bool checkPackedDatasetHeader(const std::string& dir)
+{
+    const std::string valid = dir + "/valid.pack";
+    const int32_t dims[3] = {2, 2, 2};
+    const std::vector<float> labels{1.F, 2.F, 3.F};
+    samplesCommon::PackedDatasetWriter writer;
+    TEST_CHECK(writer.open(valid, samplesCommon::PackedDataType::kUINT8, dims, 3, {0.5F, 0.25F}, {1.F, -1.F}, labels));
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        const std::vector<uint8_t> sample(8, i);
+        TEST_CHECK(writer.addSample(sample.data()));
+    }
+    TEST_CHECK(writer.close());
+
+    std::string err;
+    {
+        PackedDataset dataset;
+        TEST_CHECK(dataset.open(valid, err));
+        TEST_CHECK(dataset.getNbSamples() == 3);
+        TEST_CHECK(dataset.getSample(2)[7] == 2);
+        TEST_CHECK(dataset.getLabel(1) == 2.F);
+        TEST_CHECK(dataset.getScale(1) == 0.25F && dataset.getBias(1) == -1.F);
+    }
+
+    // Counts and shapes whose sizes would wrap around 64 bits are rejected before anything is read through them
+    const std::string changed = dir + "/changed.pack";
+    TEST_CHECK(writeChanged(valid, changed, [](PackedDatasetHeader& h) { h.nbSamples = uint64_t{1} << 61; }));
+    PackedDataset dataset;
+    TEST_CHECK(!dataset.open(changed, err) && err.find("more samples") != std::string::npos);
+    TEST_CHECK(writeChanged(valid, changed, [](PackedDatasetHeader& h) { h.nbSamples = uint64_t{1} << 62; }));
+    TEST_CHECK(!dataset.open(changed, err) && err.find("more samples") != std::string::npos);
+    TEST_CHECK(writeChanged(valid, changed, [&](PackedDatasetHeader& h) {
+        h.hasLabels = 1;
+        h.labelsOffset = readTestFile(valid).size() - sizeof(float);
+    }));
+    TEST_CHECK(!dataset.open(changed, err) && err.find("more samples") != std::string::npos);
+    TEST_CHECK(writeChanged(valid, changed, [](PackedDatasetHeader& h) {
+        h.dims[0] = h.dims[1] = h.dims[2] = INT32_MAX;
+    }));
+    TEST_CHECK(!dataset.open(changed, err) && err.find("shape") != std::string::npos);
+    return true;
+}
+
+} // namespace
+
+bool testPackedDatasetHeader()
+{
+    const std::string dir = makeTestDirectory();
+    TEST_CHECK(!dir.empty());
+    const bool passed = checkPackedDatasetHeader(dir);
+    removeTestDirectory(dir);
+    return passed;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "commonTests.h"
+#include "weightFile.h"
+
+using samplesCommon::WeightFile;
+
+namespace
+{
+
+//!
+//! \brief A wts v2 blob of floats, as written by dumpTFWts.py
+//!
+std::string wtsBlob(const std::string& name, const std::string& shape, const std::vector<float>& values)
+{
+    const std::string bytes(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+    return name + " 0 " + shape + " " + bytes + "\n";
+}
+
+bool getInode(const std::string& fileName, ino_t& inode)
+{
+    struct stat info;
+    if (stat(fileName.c_str(), &info))
+    {
+        return false;
+    }
+    inode = info.st_ino;
+    return true;
+}
+
+//!
+//! \brief Set the modification time of fileName, to hide a change from the size and time check of the index
+//!
+bool setTime(const std::string& fileName, time_t seconds)
+{
+    struct timeval times[2]{};
+    times[0].tv_sec = seconds;
+    times[1].tv_sec = seconds;
+    return utimes(fileName.c_str(), times) == 0;
+}
+
+//!
+//! \brief Whether file has the blob name, of the given first dimension and first value
+//!
+bool hasBlob(const WeightFile& file, const std::string& name, int firstDim, float first)
+{
+    const auto it = file.getBlobs().find(name);
+    TEST_CHECK(it != file.getBlobs().end());
+    TEST_CHECK(it->second.shape.nbDims > 0 && it->second.shape.d[0] == firstDim);
+    TEST_CHECK(static_cast<const float*>(it->second.weights.values)[0] == first);
+    return true;
+}
+
+bool checkWeightIndex(const std::string& dir)
+{
+    const std::string wts = dir + "/weights.wts";
+    const std::string idx = wts + ".idx";
+    const std::vector<float> fc(6, 1.F);
+    const std::vector<float> bias(3, 2.F);
+    TEST_CHECK(writeTestFile(wts, "2\n" + wtsBlob("fc", "(2, 3)", fc) + wtsBlob("bias", "(3,)", bias)));
+    TEST_CHECK(setTime(wts, 1000000));
+
+    // The first open scans the file and writes the index
+    std::string err;
+    ino_t written{0};
+    {
+        WeightFile file;
+        TEST_CHECK(file.openIndexed(wts, {}, err));
+        TEST_CHECK(file.isMapped() && file.getBlobs().size() == 2);
+        TEST_CHECK(hasBlob(file, "fc", 2, 1.F) && hasBlob(file, "bias", 3, 2.F));
+        TEST_CHECK(getInode(idx, written));
+    }
+
+    // The next ones map the blobs through the index, which is atomically replaced whenever it is rewritten
+    ino_t inode{0};
+    {
+        WeightFile file;
+        TEST_CHECK(file.openIndexed(wts, {"bias"}, err));
+        TEST_CHECK(file.getBlobs().size() == 1 && hasBlob(file, "bias", 3, 2.F));
+        TEST_CHECK(getInode(idx, inode) && inode == written);
+    }
+
+    // Values changed in place keep the index, and are read from the file
+    const std::vector<float> fc5(6, 5.F);
+    TEST_CHECK(writeTestFile(wts, "2\n" + wtsBlob("fc", "(2, 3)", fc5) + wtsBlob("bias", "(3,)", bias)));
+    TEST_CHECK(setTime(wts, 1000000));
+    {
+        WeightFile file;
+        TEST_CHECK(file.openIndexed(wts, {}, err));
+        TEST_CHECK(hasBlob(file, "fc", 2, 5.F));
+        TEST_CHECK(getInode(idx, inode) && inode == written);
+    }
+
+    // A new shape of the same size and time is caught by the hash of the blob headers
+    TEST_CHECK(writeTestFile(wts, "2\n" + wtsBlob("fc", "(3, 2)", fc) + wtsBlob("bias", "(3,)", bias)));
+    TEST_CHECK(setTime(wts, 1000000));
+    {
+        WeightFile file;
+        TEST_CHECK(file.openIndexed(wts, {}, err));
+        TEST_CHECK(hasBlob(file, "fc", 3, 1.F) && hasBlob(file, "bias", 3, 2.F));
+        TEST_CHECK(getInode(idx, inode) && inode != written);
+        written = inode;
+    }
+
+    // So is a renamed blob, and a new modification time or size rebuilds the index without looking further
+    TEST_CHECK(writeTestFile(wts, "2\n" + wtsBlob("fc", "(3, 2)", fc) + wtsBlob("bia2", "(3,)", bias)));
+    TEST_CHECK(setTime(wts, 1000000));
+    {
+        WeightFile file;
+        TEST_CHECK(file.openIndexed(wts, {"bia2"}, err));
+        TEST_CHECK(!file.openIndexed(wts, {"bias"}, err));
+        TEST_CHECK(getInode(idx, inode) && inode != written);
+        written = inode;
+    }
+    TEST_CHECK(setTime(wts, 1000001));
+    {
+        WeightFile file;
+        TEST_CHECK(file.openIndexed(wts, {"bia2"}, err));
+        TEST_CHECK(getInode(idx, inode) && inode != written);
+        written = inode;
+    }
+    TEST_CHECK(writeTestFile(wts, "3\n" + wtsBlob("fc", "(6,)", fc) + wtsBlob("bias", "(3,)", bias)
+        + wtsBlob("scale", "(1,)", {4.F})));
+    TEST_CHECK(setTime(wts, 1000001));
+    {
+        WeightFile file;
+        TEST_CHECK(file.openIndexed(wts, {}, err));
+        TEST_CHECK(file.getBlobs().size() == 3 && hasBlob(file, "scale", 1, 4.F));
+        TEST_CHECK(getInode(idx, inode) && inode != written);
+    }
+
+    // A damaged index is rebuilt too
+    TEST_CHECK(writeTestFile(idx, "TRTWIDX"));
+    {
+        WeightFile file;
+        TEST_CHECK(file.openIndexed(wts, {"scale"}, err));
+        TEST_CHECK(hasBlob(file, "scale", 1, 4.F));
+        struct stat info;
+        TEST_CHECK(stat(idx.c_str(), &info) == 0);
+        TEST_CHECK(static_cast<size_t>(info.st_size) > sizeof(samplesCommon::WeightIndexHeader));
+    }
+    return true;
+}
+
+} // namespace
+
+bool testWeightIndex()
+{
+    const std::string dir = makeTestDirectory();
+    TEST_CHECK(!dir.empty());
+    const bool passed = checkWeightIndex(dir);
+    removeTestDirectory(dir);
+    return passed;
+}
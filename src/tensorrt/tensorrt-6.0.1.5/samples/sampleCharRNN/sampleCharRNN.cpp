@@ -71,12 +71,12 @@
 #include <vector>
 
 #include "NvInfer.h"
-#include "NvUtils.h"
 #include "argsParser.h"
 #include "buffers.h"
 #include "common.h"
 #include "cuda_runtime_api.h"
 #include "logger.h"
+#include "weightFile.h"
 
 const std::string gSampleName = "TensorRT.sample_char_rnn";
 
@@ -186,9 +186,9 @@ public:
 
 private:
     //!
-    //! \brief Load requested weights from a formatted file into a map.
+    //! \brief Map the requested weights of a formatted file into mWeightMap.
     //!
-    std::map<std::string, nvinfer1::Weights> loadWeights(const std::string file);
+    bool loadWeights(const std::string& file);
 
     //!
     //! \brief Converts RNN weights from TensorFlow's format to TensorRT's format.
@@ -223,10 +223,12 @@ private:
                   SampleUniquePtr<nvinfer1::IExecutionContext>& context, cudaStream_t& stream);
 
     //!
-    //! \brief Copies Ct/Ht output from the RNN to the Ct-1/Ht-1 input buffers for next time step
+    //! \brief Makes the Ct/Ht output from the RNN the Ct-1/Ht-1 input for next time step
     //!
     void copyRNNOutputsToInputs(samplesCommon::BufferManager& buffers);
 
+    samplesCommon::WeightFile mWeightFile; //!< The mapped weight file, which mWeightMap points into
+    std::vector<std::vector<float>> mConvertedWeights; //!< Weights converted to TensorRT's layout
     std::map<std::string, nvinfer1::Weights> mWeightMap;
     SampleCharRNNParams mParams;
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine{nullptr}; //!< The TensorRT engine used to run the network
@@ -262,7 +264,10 @@ bool SampleCharRNN::build()
         return false;
     }
 
-    mWeightMap = SampleCharRNN::loadWeights(mParams.weightFileName);
+    if (!SampleCharRNN::loadWeights(mParams.weightFileName))
+    {
+        return false;
+    }
 
     builder->setMaxBatchSize(mParams.batchSize);
     config->setMaxWorkspaceSize(32_MiB);
@@ -279,80 +284,38 @@ bool SampleCharRNN::build()
 }
 
 //!
-//! \brief Load requested weights from a formatted file into a map.
+//! \brief Map the requested weights of a formatted file into mWeightMap.
 //!
 //! \param file Path to weights file. File has to be the formatted dump from
 //!        the dumpTFWts.py script. Otherwise, this function will not work as
 //!        intended.
 //!
-//! \return A map containing the extracted weights.
+//! \return true if every requested weight was found.
 //!
 //! \note  Weight V2 files are in a very simple space delimited format.
 //!        <number of buffers>
 //!        for each buffer: [name] [type] [shape] <data as binary blob>\n
 //!        Note: type is the integer value of the DataType enum in NvInfer.h.
 //!
-std::map<std::string, nvinfer1::Weights> SampleCharRNN::loadWeights(const std::string file)
+//!        The offset, type and shape of every buffer are kept in the index file.idx, written the first time the file
+//!        is loaded, so that only the requested buffers are read. They are mapped rather than copied.
+//!
+bool SampleCharRNN::loadWeights(const std::string& file)
 {
-    std::map<std::string, nvinfer1::Weights> weightMap;
-
-    std::ifstream input(file, std::ios_base::binary);
-    assert(input.is_open() && "Unable to load weight file.");
-
-    int32_t count;
-    input >> count;
-    assert(count > 0 && "Invalid weight map file.");
-
-    while (count--)
+    const std::vector<std::string> names(mParams.weightNames.names.begin(), mParams.weightNames.names.end());
+    std::string err;
+    if (!mWeightFile.openIndexed(file, names, err))
     {
-        if (mParams.weightNames.names.empty())
-        {
-            break;
-        }
-
-        nvinfer1::Weights wt{nvinfer1::DataType::kFLOAT, nullptr, 0};
-
-        // parse name and DataType
-        std::string name;
-        uint32_t type;
-        input >> name >> std::dec >> type;
-        wt.type = static_cast<nvinfer1::DataType>(type);
-
-        // extract shape
-        std::string temp, shape;
-        std::getline(std::getline(input, temp, '('), shape, ')');
-
-        // calculate count based on shape
-        wt.count = 1;
-        std::istringstream shapeStream(shape);
-        while (std::getline(shapeStream, temp, ','))
-            wt.count *= std::stoul(temp);
-        size_t numOfBytes = samplesCommon::getElementSize(wt.type) * wt.count;
-
-        // skip reading of weights if name is not in the set of names requested for extraction
-        if (mParams.weightNames.names.find(name) == mParams.weightNames.names.end())
-        {
-            input.seekg(input.tellg() + static_cast<std::streamoff>(2 + numOfBytes));
-            continue;
-        }
-        else
-        {
-            mParams.weightNames.names.erase(name);
-        }
-
-        // Read weight values
-        input.seekg(input.tellg() + static_cast<std::streamoff>(1)); // skip space char
-        char* wtVals = new char[numOfBytes];
-        input.read(wtVals, numOfBytes);
-        input.seekg(input.tellg() + static_cast<std::streamoff>(1)); // skip new-line char
-        wt.values = wtVals;
-
-        weightMap[name] = wt;
+        gLogError << err << std::endl;
+        return false;
+    }
+    for (const auto& name : names)
+    {
+        mWeightMap[name] = mWeightFile.getWeights(name);
     }
 
-    input.close();
     gLogInfo << "Done reading weights from file..." << std::endl;
-    return weightMap;
+    return true;
 }
 
 //!
@@ -360,7 +323,7 @@ std::map<std::string, nvinfer1::Weights> SampleCharRNN::loadWeights(const std::s
 //!
 //! \param input Weights that are stored in TensorFlow's format.
 //!
-//! \return Converted weights in TensorRT's format.
+//! \return Converted weights in TensorRT's format, owned by mConvertedWeights.
 //!
 //! \note TensorFlow weight parameters for BasicLSTMCell are formatted as:
 //!       Each [WR][icfo] is hiddenSize sequential elements.
@@ -376,14 +339,44 @@ std::map<std::string, nvinfer1::Weights> SampleCharRNN::loadWeights(const std::s
 //!       TensorRT expects the format to laid out in memory:
 //!       CellN: Wi, Wc, Wf, Wo, Ri, Rc, Rf, Ro
 //!
+//!       The gates are split and transposed in a single pass, by tiles, straight into the converted buffer.
+//!
 nvinfer1::Weights SampleCharRNN::convertRNNWeights(nvinfer1::Weights input)
 {
-    float* ptr = new float[input.count];
-    int dims[4]{2, mParams.hiddenSize, 4, mParams.hiddenSize};
-    int order[4]{0, 3, 1, 2};
-    utils::reshapeWeights(input, dims, order, ptr, 4);
-    utils::transposeSubBuffers(ptr, DataType::kFLOAT, 2, mParams.hiddenSize * mParams.hiddenSize, 4);
-    return nvinfer1::Weights{input.type, ptr, input.count};
+    const int hiddenSize = mParams.hiddenSize;
+    assert(input.type == nvinfer1::DataType::kFLOAT && input.count == 8LL * hiddenSize * hiddenSize);
+    constexpr int kTILE = 32;
+
+    const float* src = static_cast<const float*>(input.values);
+    mConvertedWeights.emplace_back(input.count);
+    float* dst = mConvertedWeights.back().data();
+    for (int matrix = 0; matrix < 2; ++matrix)
+    {
+        for (int gate = 0; gate < 4; ++gate)
+        {
+            // Gate (matrix, gate) is the hiddenSize x hiddenSize block of src at row matrix * hiddenSize and column
+            // gate * hiddenSize, whose row stride is 4 * hiddenSize. It is stored transposed.
+            const float* block = src + static_cast<size_t>(matrix) * hiddenSize * 4 * hiddenSize + gate * hiddenSize;
+            float* out = dst + static_cast<size_t>(matrix * 4 + gate) * hiddenSize * hiddenSize;
+            for (int k0 = 0; k0 < hiddenSize; k0 += kTILE)
+            {
+                for (int j0 = 0; j0 < hiddenSize; j0 += kTILE)
+                {
+                    const int kEnd = std::min(k0 + kTILE, hiddenSize);
+                    const int jEnd = std::min(j0 + kTILE, hiddenSize);
+                    for (int k = k0; k < kEnd; ++k)
+                    {
+                        const float* row = block + static_cast<size_t>(k) * 4 * hiddenSize;
+                        for (int j = j0; j < jEnd; ++j)
+                        {
+                            out[static_cast<size_t>(j) * hiddenSize + k] = row[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return nvinfer1::Weights{input.type, dst, input.count};
 }
 
 //!
@@ -391,7 +384,7 @@ nvinfer1::Weights SampleCharRNN::convertRNNWeights(nvinfer1::Weights input)
 //!
 //! \param input Biases that are stored in TensorFlow's format.
 //!
-//! \return Converted bias in TensorRT's format.
+//! \return Converted bias in TensorRT's format, owned by mConvertedWeights.
 //!
 //! \note TensorFlow bias parameters for BasicLSTMCell are formatted as:
 //!       CellN: Bi, Bc, Bf, Bo
@@ -403,12 +396,11 @@ nvinfer1::Weights SampleCharRNN::convertRNNWeights(nvinfer1::Weights input)
 //!       we double the size and set all of U to zero.
 nvinfer1::Weights SampleCharRNN::convertRNNBias(nvinfer1::Weights input)
 {
-    const int sizeOfElement = samplesCommon::getElementSize(input.type);
-    char* ptr = new char[sizeOfElement * input.count * 2];
-    const char* iptr = static_cast<const char*>(input.values);
-    std::copy(iptr, iptr + 4 * mParams.hiddenSize * sizeOfElement, ptr);
-    std::fill(ptr + sizeOfElement * input.count, ptr + sizeOfElement * input.count * 2, 0);
-    return nvinfer1::Weights{input.type, ptr, input.count * 2};
+    assert(input.type == nvinfer1::DataType::kFLOAT && input.count == 4LL * mParams.hiddenSize);
+    const float* iptr = static_cast<const float*>(input.values);
+    mConvertedWeights.emplace_back(input.count * 2, 0.0F);
+    std::copy(iptr, iptr + input.count, mConvertedWeights.back().begin());
+    return nvinfer1::Weights{input.type, mConvertedWeights.back().data(), input.count * 2};
 }
 
 //!
@@ -487,12 +479,6 @@ nvinfer1::IRNNv2Layer* SampleCharRNN::addRNNv2Layer(SampleUniquePtr<nvinfer1::IN
         biasOffset = biasOffset + mParams.hiddenSize;
     }
 
-    // Store the transformed weights in the weight map so the memory can be properly released later.
-    mWeightMap["rnnwL0"] = rnnwL0;
-    mWeightMap["rnnbL0"] = rnnbL0;
-    mWeightMap["rnnwL1"] = rnnwL1;
-    mWeightMap["rnnbL1"] = rnnbL1;
-
     return rnn;
 }
 
@@ -508,8 +494,23 @@ void SampleCharRNN::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builde
     // add RNNv2 layer and set its parameters
     auto rnn = SampleCharRNN::addRNNv2Layer(network);
 
-    // Transpose FC weights since TensorFlow's weights are transposed when compared to TensorRT
-    utils::transposeSubBuffers((void*) mWeightMap[mParams.weightNames.FCW_NAME].values, nvinfer1::DataType::kFLOAT, 1, mParams.hiddenSize, mParams.vocabSize);
+    // Transpose FC weights since TensorFlow's weights are transposed when compared to TensorRT. The mapped weights
+    // are read-only, so the transpose goes to a buffer of its own.
+    nvinfer1::Weights& fcw = mWeightMap[mParams.weightNames.FCW_NAME];
+    assert(fcw.type == nvinfer1::DataType::kFLOAT
+        && fcw.count == static_cast<int64_t>(mParams.hiddenSize) * mParams.vocabSize);
+    const float* fcwIn = static_cast<const float*>(fcw.values);
+    mConvertedWeights.emplace_back(fcw.count);
+    float* fcwOut = mConvertedWeights.back().data();
+    for (int h = 0; h < mParams.hiddenSize; ++h)
+    {
+        for (int v = 0; v < mParams.vocabSize; ++v)
+        {
+            fcwOut[static_cast<size_t>(v) * mParams.hiddenSize + h]
+                = fcwIn[static_cast<size_t>(h) * mParams.vocabSize + v];
+        }
+    }
+    fcw.values = fcwOut;
 
     // add Constant layers for fully connected weights
     auto fcwts = network->addConstant(nvinfer1::Dims2(mParams.vocabSize, mParams.hiddenSize), mWeightMap[mParams.weightNames.FCW_NAME]);
@@ -584,15 +585,22 @@ bool SampleCharRNN::infer()
     // Set sequence lengths to maximum
     std::fill_n(reinterpret_cast<int32_t*>(buffers.getHostBuffer(mParams.bindingNames.SEQ_LEN_IN_BLOB_NAME)), mParams.batchSize, mParams.seqSize);
 
+    // The recurrent state stays on the device, see copyRNNOutputsToInputs, so it is never copied to or from the host
+    for (const char* name : {mParams.bindingNames.HIDDEN_IN_BLOB_NAME, mParams.bindingNames.CELL_IN_BLOB_NAME,
+             mParams.bindingNames.HIDDEN_OUT_BLOB_NAME, mParams.bindingNames.CELL_OUT_BLOB_NAME})
+    {
+        buffers.setCopyEnabled(name, false);
+    }
+
     // Initialize hiddenIn and cellIn tensors to zero before seeding
-    void* hiddenIn = buffers.getHostBuffer(mParams.bindingNames.HIDDEN_IN_BLOB_NAME);
+    void* hiddenIn = buffers.getDeviceBuffer(mParams.bindingNames.HIDDEN_IN_BLOB_NAME);
     auto hiddenTensorSize = buffers.size(mParams.bindingNames.HIDDEN_IN_BLOB_NAME);
 
-    void* cellIn = buffers.getHostBuffer(mParams.bindingNames.CELL_IN_BLOB_NAME);
+    void* cellIn = buffers.getDeviceBuffer(mParams.bindingNames.CELL_IN_BLOB_NAME);
     auto cellTensorSize = buffers.size(mParams.bindingNames.CELL_IN_BLOB_NAME);
 
-    std::memset(hiddenIn, 0, hiddenTensorSize);
-    std::memset(cellIn, 0, cellTensorSize);
+    CHECK(cudaMemsetAsync(hiddenIn, 0, hiddenTensorSize, stream));
+    CHECK(cudaMemsetAsync(cellIn, 0, cellTensorSize, stream));
 
     // Seed the RNN with the input sentence.
     for (auto& a : inputSentence)
@@ -668,21 +676,31 @@ bool SampleCharRNN::stepOnce(samplesCommon::BufferManager& buffers, SampleUnique
 }
 
 //!
-//! \brief Copies Ct/Ht output from the RNN to the Ct-1/Ht-1 input buffers for next time step
+//! \brief Exchanges the device buffers bound to two tensors of the same size and type
 //!
-void SampleCharRNN::copyRNNOutputsToInputs(samplesCommon::BufferManager& buffers)
+static bool swapDeviceBuffers(samplesCommon::BufferManager& buffers, const char* first, const char* second)
 {
-    // Copy Ct/Ht to the Ct-1/Ht-1 slots.
-    void* hiddenIn = buffers.getHostBuffer(mParams.bindingNames.HIDDEN_IN_BLOB_NAME);
-    void* hiddenOut = buffers.getHostBuffer(mParams.bindingNames.HIDDEN_OUT_BLOB_NAME);
-    auto hiddenTensorSize = buffers.size(mParams.bindingNames.HIDDEN_IN_BLOB_NAME);
-
-    void* cellIn = buffers.getHostBuffer(mParams.bindingNames.CELL_IN_BLOB_NAME);
-    void* cellOut = buffers.getHostBuffer(mParams.bindingNames.CELL_OUT_BLOB_NAME);
-    auto cellTensorSize = buffers.size(mParams.bindingNames.CELL_IN_BLOB_NAME);
+    void* firstPtr = buffers.getDeviceBuffer(first);
+    void* secondPtr = buffers.getDeviceBuffer(second);
+    const size_t nbBytes = buffers.size(first);
+    return buffers.setDeviceBuffer(first, secondPtr, nbBytes, nvinfer1::DataType::kFLOAT)
+        && buffers.setDeviceBuffer(second, firstPtr, nbBytes, nvinfer1::DataType::kFLOAT);
+}
 
-    std::memcpy(hiddenIn, hiddenOut, hiddenTensorSize);
-    std::memcpy(cellIn, cellOut, cellTensorSize);
+//!
+//! \brief Makes the Ct/Ht output from the RNN the Ct-1/Ht-1 input for next time step
+//!
+//! \details The input and output state buffers are swapped on the device instead of being copied back to the host,
+//!          copied across and uploaded again.
+//!
+void SampleCharRNN::copyRNNOutputsToInputs(samplesCommon::BufferManager& buffers)
+{
+    bool swapped = swapDeviceBuffers(
+        buffers, mParams.bindingNames.HIDDEN_IN_BLOB_NAME, mParams.bindingNames.HIDDEN_OUT_BLOB_NAME);
+    swapped = swapped
+        && swapDeviceBuffers(buffers, mParams.bindingNames.CELL_IN_BLOB_NAME, mParams.bindingNames.CELL_OUT_BLOB_NAME);
+    assert(swapped && "hidden and cell state tensors must exist and match");
+    (void) swapped;
 }
 
 //!
@@ -691,10 +709,9 @@ void SampleCharRNN::copyRNNOutputsToInputs(samplesCommon::BufferManager& buffers
 bool SampleCharRNN::teardown()
 {
     // Clean up runtime resources
-    for (auto& mem : mWeightMap)
-    {
-        delete[] static_cast<const float*>(mem.second.values);
-    }
+    mWeightMap.clear();
+    mConvertedWeights.clear();
+    mWeightFile = samplesCommon::WeightFile();
 
     return true;
 }
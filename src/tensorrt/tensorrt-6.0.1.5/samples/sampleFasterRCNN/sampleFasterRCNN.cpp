@@ -58,6 +58,8 @@
 #include "argsParser.h"
 #include "buffers.h"
 #include "common.h"
+#include "imageFile.h"
+#include "imagePreprocess.h"
 #include "logger.h"
 
 #include "NvCaffeParser.h"
@@ -119,10 +121,8 @@ private:
 
     nvinfer1::Dims mInputDims; //!< The dimensions of the input to the network.
 
-    static const int kIMG_CHANNELS = 3;
-    static const int kIMG_H = 375;
-    static const int kIMG_W = 500;
-    std::vector<samplesCommon::PPM<kIMG_CHANNELS, kIMG_H, kIMG_W>> mPPMs; //!< PPMs of test images
+    std::vector<samplesCommon::ImageInfo> mImages; //!< Test images
+    std::vector<uint8_t> mImageData;               //!< Pixels of the test images, one after the other
 
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine; //!< The TensorRT engine used to run the network
 
@@ -143,6 +143,14 @@ private:
     //!
     bool verifyOutput(const samplesCommon::BufferManager& buffers);
 
+    //!
+    //! \brief Returns the pixels of the i-th test image
+    //!
+    uint8_t* getImageData(int i)
+    {
+        return mImageData.data() + i * mImages[i].size();
+    }
+
     //!
     //! \brief Performs inverse bounding box transform and clipping
     //!
@@ -304,32 +312,43 @@ bool SampleFasterRCNN::processInput(const samplesCommon::BufferManager& buffers)
 
     // Available images
     const std::vector<std::string> imageList = {"000456.ppm", "000542.ppm", "001150.ppm", "001763.ppm", "004545.ppm"};
-    mPPMs.resize(batchSize);
-    assert(mPPMs.size() <= imageList.size());
+    assert(batchSize <= static_cast<int>(imageList.size()));
+    std::vector<std::string> fileNames;
+    for (int i = 0; i < batchSize; ++i)
+    {
+        fileNames.push_back(locateFile(imageList[i], mParams.dataDirs));
+    }
+    mImageData.resize(batchSize * inputC * inputH * inputW);
+    std::string err;
+    if (!samplesCommon::readImageBatch(fileNames, inputC, inputH, inputW, mImageData.data(), mImages, err))
+    {
+        gLogError << err << std::endl;
+        return false;
+    }
 
     // Fill im_info buffer
     float* hostImInfoBuffer = static_cast<float*>(buffers.getHostBuffer("im_info"));
     for (int i = 0; i < batchSize; ++i)
     {
-        readPPMFile(locateFile(imageList[i], mParams.dataDirs), mPPMs[i]);
-        hostImInfoBuffer[i * 3] = float(mPPMs[i].h);     // Number of rows
-        hostImInfoBuffer[i * 3 + 1] = float(mPPMs[i].w); // Number of columns
-        hostImInfoBuffer[i * 3 + 2] = 1;                 // Image scale
+        hostImInfoBuffer[i * 3] = float(mImages[i].h);     // Number of rows
+        hostImInfoBuffer[i * 3 + 1] = float(mImages[i].w); // Number of columns
+        hostImInfoBuffer[i * 3 + 2] = 1;                   // Image scale
     }
 
     // Fill data buffer
     float* hostDataBuffer = static_cast<float*>(buffers.getHostBuffer("data"));
+    samplesCommon::ImagePreprocessParams params;
+    params.channels = inputC;
+    // The color image to input should be in BGR order
+    params.swapRB();
     // Pixel mean used by the Faster R-CNN's author
-    const float pixelMean[3]{102.9801f, 115.9465f, 122.7717f}; // Also in BGR order
-    for (int i = 0, volImg = inputC * inputH * inputW; i < batchSize; ++i)
+    params.setMeanScale({102.9801f, 115.9465f, 122.7717f}, 1.0f); // Also in BGR order
+    std::vector<const uint8_t*> images;
+    for (int i = 0; i < batchSize; ++i)
     {
-        for (int c = 0; c < inputC; ++c)
-        {
-            // The color image to input should be in BGR order
-            for (unsigned j = 0, volChl = inputH * inputW; j < volChl; ++j)
-                hostDataBuffer[i * volImg + c * volChl + j] = float(mPPMs[i].buffer[j * inputC + 2 - c]) - pixelMean[c];
-        }
+        images.push_back(getImageData(i));
     }
+    samplesCommon::preprocessHWCBatch(images, inputH, inputW, 0, hostDataBuffer, params);
 
     return true;
 }
@@ -403,13 +422,13 @@ bool SampleFasterRCNN::verifyOutput(const samplesCommon::BufferManager& buffers)
                 const int idx = indices[k];
                 const std::string storeName
                     = classes[c] + "-" + std::to_string(scores[idx * outputClsSize + c]) + ".ppm";
-                gLogInfo << "Detected " << classes[c] << " in " << mPPMs[i].fileName << " with confidence "
+                gLogInfo << "Detected " << classes[c] << " in " << mImages[i].fileName << " with confidence "
                          << scores[idx * outputClsSize + c] * 100.0f << "% "
                          << " (Result stored in " << storeName << ")." << std::endl;
 
                 const samplesCommon::BBox b{bbox[idx * outputBBoxSize + c * 4], bbox[idx * outputBBoxSize + c * 4 + 1],
                     bbox[idx * outputBBoxSize + c * 4 + 2], bbox[idx * outputBBoxSize + c * 4 + 3]};
-                writePPMFileWithBBox(storeName, mPPMs[i], b);
+                samplesCommon::writePPMFileWithBBox(storeName, mImages[i], getImageData(i), b);
             }
         }
         pass &= numDetections >= 1;
@@ -235,7 +235,7 @@ bool SampleINT8::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builder,
     if (dataType == DataType::kINT8)
     {
         MNISTBatchStream calibrationStream(mParams.calBatchSize, mParams.nbCalBatches, "train-images-idx3-ubyte",
-            "train-labels-idx1-ubyte", mParams.dataDirs);
+            "train-labels-idx1-ubyte", mParams.dataDirs, true);
         calibrator.reset(new Int8EntropyCalibrator2<MNISTBatchStream>(
             calibrationStream, 0, mParams.networkName.c_str(), mParams.inputTensorNames[0].c_str()));
         config->setInt8Calibrator(calibrator.get());
@@ -280,8 +280,8 @@ bool SampleINT8::infer(std::pair<float, float>& score, int firstScoreBatch, int
         return false;
     }
 
-    MNISTBatchStream batchStream(
-        mParams.batchSize, nbScoreBatches, "train-images-idx3-ubyte", "train-labels-idx1-ubyte", mParams.dataDirs);
+    MNISTBatchStream batchStream(mParams.batchSize, nbScoreBatches, "train-images-idx3-ubyte",
+        "train-labels-idx1-ubyte", mParams.dataDirs, true);
     batchStream.skip(firstScoreBatch);
 
     Dims outputDims = context->getEngine().getBindingDimensions(
@@ -58,6 +58,7 @@
 #include "logger.h"
 #include "common.h"
 #include "buffers.h"
+#include "calibrationTable.h"
 #include "argsParser.h"
 
 #include "NvInfer.h"
@@ -219,28 +220,20 @@ void SampleINT8API::getInputOutputNames()
 }
 
 //!
-//! \brief Populate per tensor dyanamic range values
+//! \brief Populate per tensor dyanamic range values, from a dynamic range file or an INT8 calibration cache
 //!
 bool SampleINT8API::readPerTensorDynamicRangeValues()
 {
-    std::ifstream iDynamicRangeStream(mParams.dynamicRangeFileName);
-    if (!iDynamicRangeStream)
+    samplesCommon::CalibrationTable table;
+    if (!table.read(mParams.dynamicRangeFileName, gLogError))
     {
-        gLogError << "Could not find per tensor scales file: " << mParams.dynamicRangeFileName << std::endl;
+        gLogError << "Could not read per tensor scales file: " << mParams.dynamicRangeFileName << std::endl;
         return false;
     }
 
-    std::string line;
-    char delim = ':';
-    while (std::getline(iDynamicRangeStream, line))
+    for (const auto& entry : table.getScales())
     {
-        std::istringstream iline(line);
-        std::string token;
-        std::getline(iline, token, delim);
-        std::string tensorName = token;
-        std::getline(iline, token, delim);
-        float dynamicRange = std::stof(token);
-        mPerTensorDynamicRangeMap[tensorName] = dynamicRange;
+        mPerTensorDynamicRangeMap[entry.first] = table.getDynamicRange(entry.first);
     }
     return true;
 }
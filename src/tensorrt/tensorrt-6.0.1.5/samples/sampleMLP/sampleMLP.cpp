@@ -59,6 +59,7 @@
 #include "buffers.h"
 #include "common.h"
 #include "logger.h"
+#include "weightFile.h"
 
 #include "NvCaffeParser.h"
 #include "NvInfer.h"
@@ -119,8 +120,12 @@ private:
 
     int mNumber{0}; //!< The number to classify
 
+    samplesCommon::WeightFile mWeightFile; //!< Owns the weights, or maps them if the file is a weight container
+
     std::map<std::string, std::pair<nvinfer1::Dims, nvinfer1::Weights>> mWeightMap; //!< The weight name to weight value map
 
+    std::vector<std::vector<uint32_t>> mTransposedWeights; //!< Transposed copies, the loaded weights may be read-only
+
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine; //!< The TensorRT engine used to run the network
 
     //!
@@ -144,11 +149,6 @@ private:
     //!
     std::map<std::string, std::pair<nvinfer1::Dims, nvinfer1::Weights>> loadWeights(const std::string& file);
 
-    //!
-    //! \brief Loads shape from weights file
-    //!
-    nvinfer1::Dims loadShape(std::ifstream& input);
-
     //!
     //! \brief Transpose weights
     //!
@@ -177,6 +177,10 @@ private:
 bool SampleMLP::build()
 {
     mWeightMap = loadWeights(locateFile(mParams.weightsFile, mParams.dataDirs));
+    if (mWeightMap.empty())
+    {
+        return false;
+    }
 
     auto builder = SampleUniquePtr<nvinfer1::IBuilder>(nvinfer1::createInferBuilder(gLogger.getTRTLogger()));
     if (!builder)
@@ -378,14 +382,10 @@ bool SampleMLP::verifyOutput(const samplesCommon::BufferManager& buffers)
 //!
 bool SampleMLP::teardown()
 {
-    // Release weights host memory
-    for (auto& mem : mWeightMap)
-    {
-        auto weight = mem.second.second;
-        {
-            delete[] static_cast<const float*>(weight.values);
-        }
-    }
+    // Release weights host memory, or unmap the weight container
+    mWeightMap.clear();
+    mTransposedWeights.clear();
+    mWeightFile = samplesCommon::WeightFile();
 
     return true;
 }
@@ -393,107 +393,27 @@ bool SampleMLP::teardown()
 //!
 //! \brief Loads weights from weights file
 //!
-//! \details Our weight files are in a very simple space delimited format.
+//! \details The weights file is either a weight container written by trtwts, whose weights point into a mapping of
+//!          the file, or one of our weight files in a very simple space delimited format.
 //!          type is the integer value of the DataType enum in NvInfer.h.
 //!          <number of buffers>
-//!          for each buffer: [name] [type] [size] <data x size in hex>
+//!          for each buffer: [name] [type] [shape] <data as binary blob>
 //!
 std::map<std::string, std::pair<nvinfer1::Dims, nvinfer1::Weights>> SampleMLP::loadWeights(const std::string& file)
 {
     std::map<std::string, std::pair<nvinfer1::Dims, nvinfer1::Weights>> weightMap;
-    std::ifstream input(file, std::ios_base::binary);
-    assert(input.is_open() && "Unable to load weight file.");
-    int32_t count;
-    input >> count;
-    assert(count > 0 && "Invalid weight map file.");
-    while (count--)
+    std::string err;
+    if (!mWeightFile.open(file, err))
     {
-        std::pair<nvinfer1::Dims, nvinfer1::Weights> wt{};
-        std::int32_t type;
-        std::string name;
-        input >> name >> std::dec >> type;
-        wt.first = loadShape(input);
-        wt.second.type = static_cast<nvinfer1::DataType>(type);
-        wt.second.count = std::accumulate(wt.first.d, wt.first.d + wt.first.nbDims, 1, std::multiplies<int32_t>());
-        assert(wt.second.type == nvinfer1::DataType::kFLOAT);
-
-        float* value = new float[wt.second.count];
-        input.read(reinterpret_cast<char*>(value), wt.second.count * sizeof(float));
-        assert(input.peek() == '\n');
-        // Consume the newline at the end of the data blob.
-        input.get();
-        wt.second.values = value;
-        weightMap[name] = wt;
+        gLogError << err << std::endl;
+        return weightMap;
     }
-    return weightMap;
-}
-
-//!
-//! \brief Loads shape from weights file
-//!
-nvinfer1::Dims SampleMLP::loadShape(std::ifstream& input)
-{
-    // Initial format is "(A, B, C,...,Y [,])"
-    nvinfer1::Dims shape{};
-    std::string shapeStr;
-
-    // Convert to "(A,B,C,...,Y[,])"
-    do
-    {
-        std::string tmp;
-        input >> tmp;
-        shapeStr += tmp;
-    } while (*shapeStr.rbegin() != ')');
-    assert(input.peek() == ' ');
-
-    // Consume the space between the shape and the data buffer.
-    input.get();
-
-    // Convert to "A,B,C,...,Y[,]"
-    assert(*shapeStr.begin() == '(');
-    shapeStr.erase(0, 1); //
-    assert(*shapeStr.rbegin() == ')');
-    shapeStr.pop_back();
-
-    // Convert to "A,B,C,...,Y"
-    if (*shapeStr.rbegin() == ',')
-    {
-        shapeStr.pop_back(); // Remove the excess ',' character
-    }
-
-    std::vector<std::string> shapeDim;
-    std::size_t begin = 0, size = shapeStr.size();
-    while (begin != std::string::npos)
+    for (const auto& blob : mWeightFile.getBlobs())
     {
-        std::size_t found = shapeStr.find_first_of(",", begin);
-        // Handle case of two or more delimiters in a row.
-        if (found != begin)
-        {
-            shapeDim.push_back(shapeStr.substr(begin, found - begin));
-        }
-        begin = found + 1;
-        // Handle case of no more tokens.
-        if (found == std::string::npos)
-        {
-            break;
-        }
-        // Handle case of delimiter being last or first token.
-        if (begin >= size)
-        {
-            break;
-        }
+        assert(blob.second.weights.type == nvinfer1::DataType::kFLOAT);
+        weightMap[blob.first] = std::make_pair(blob.second.shape, blob.second.weights);
     }
-
-    // Convert to {A, B, C,...,Y}
-    assert(shapeDim.size() <= shape.MAX_DIMS);
-    assert(shapeDim.size() > 0);
-    assert(shape.nbDims == 0);
-    std::for_each(shapeDim.begin(),
-                  shapeDim.end(),
-                  [&](std::string& val) {
-                      shape.d[shape.nbDims++] = std::stoi(val);
-                  });
-    return shape;
+    return weightMap;
 }
 
 //!
@@ -514,10 +434,8 @@ void SampleMLP::transposeWeights(nvinfer1::Weights& wts, int hiddenSize)
         }
     }
 
-    for (int k = 0; k < wts.count; ++k)
-    {
-        *((uint32_t*) wts.values + k) = trans_wts[k];
-    }
+    mTransposedWeights.push_back(std::move(trans_wts));
+    wts.values = mTransposedWeights.back().data();
 }
 
 //!
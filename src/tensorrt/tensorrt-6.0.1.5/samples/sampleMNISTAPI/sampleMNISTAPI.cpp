@@ -59,6 +59,7 @@
 #include "buffers.h"
 #include "common.h"
 #include "logger.h"
+#include "weightFile.h"
 
 #include "NvCaffeParser.h"
 #include "NvInfer.h"
@@ -120,6 +121,8 @@ private:
 
     int mNumber{0}; //!< The number to classify
 
+    samplesCommon::WeightFile mWeightFile; //!< Owns the weights, or maps them if the file is a weight container
+
     std::map<std::string, nvinfer1::Weights> mWeightMap; //!< The weight name to weight value map
 
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine; //!< The TensorRT engine used to run the network
@@ -157,6 +160,10 @@ private:
 bool SampleMNISTAPI::build()
 {
     mWeightMap = loadWeights(locateFile(mParams.weightsFile, mParams.dataDirs));
+    if (mWeightMap.empty())
+    {
+        return false;
+    }
 
     auto builder = SampleUniquePtr<nvinfer1::IBuilder>(nvinfer1::createInferBuilder(gLogger.getTRTLogger()));
     if (!builder)
@@ -402,19 +409,9 @@ bool SampleMNISTAPI::verifyOutput(const samplesCommon::BufferManager& buffers)
 //!
 bool SampleMNISTAPI::teardown()
 {
-    // Release weights host memory
-    for (auto& mem : mWeightMap)
-    {
-        auto weight = mem.second;
-        if (weight.type == DataType::kFLOAT)
-        {
-            delete[] static_cast<const uint32_t*>(weight.values);
-        }
-        else
-        {
-            delete[] static_cast<const uint16_t*>(weight.values);
-        }
-    }
+    // Release weights host memory, or unmap the weight container
+    mWeightMap.clear();
+    mWeightFile = samplesCommon::WeightFile();
 
     return true;
 }
@@ -422,59 +419,21 @@ bool SampleMNISTAPI::teardown()
 //!
 //! \brief Loads weights from weights file
 //!
-//! \details TensorRT weight files have a simple space delimited format
+//! \details The weights file is either a weight container written by trtwts, whose weights point into a mapping of
+//!          the file, or a TensorRT weight file in the simple space delimited format
 //!          [type] [size] <data x size in hex>
 //!
 std::map<std::string, nvinfer1::Weights> SampleMNISTAPI::loadWeights(const std::string& file)
 {
     gLogInfo << "Loading weights: " << file << std::endl;
 
-    // Open weights file
-    std::ifstream input(file, std::ios::binary);
-    assert(input.is_open() && "Unable to load weight file.");
-
-    // Read number of weight blobs
-    int32_t count;
-    input >> count;
-    assert(count > 0 && "Invalid weight map file.");
-
-    std::map<std::string, nvinfer1::Weights> weightMap;
-    while (count--)
+    std::string err;
+    if (!mWeightFile.open(file, err))
     {
-        nvinfer1::Weights wt{DataType::kFLOAT, nullptr, 0};
-        int type;
-        uint32_t size;
-
-        // Read name and type of blob
-        std::string name;
-        input >> name >> std::dec >> type >> size;
-        wt.type = static_cast<DataType>(type);
-
-        // Load blob
-        if (wt.type == DataType::kFLOAT)
-        {
-            uint32_t* val = new uint32_t[size];
-            for (uint32_t x = 0; x < size; ++x)
-            {
-                input >> std::hex >> val[x];
-            }
-            wt.values = val;
-        }
-        else if (wt.type == DataType::kHALF)
-        {
-            uint16_t* val = new uint16_t[size];
-            for (uint32_t x = 0; x < size; ++x)
-            {
-                input >> std::hex >> val[x];
-            }
-            wt.values = val;
-        }
-
-        wt.count = size;
-        weightMap[name] = wt;
+        gLogError << err << std::endl;
+        return {};
     }
-
-    return weightMap;
+    return mWeightFile.getWeightMap();
 }
 
 //!
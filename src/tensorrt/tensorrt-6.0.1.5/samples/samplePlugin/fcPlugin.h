@@ -17,6 +17,7 @@
 #include "NvInfer.h"
 #include "fp16.h"
 #include "common.h"
+#include "halfConvert.h"
 
 class FCPlugin : public nvinfer1::IPluginExt
 {
@@ -222,23 +223,28 @@ private:
         return deviceData;
     }
 
+    // Convert the weights to mDataType in bulk, rounding to nearest even like fp16::__float2half.
+    void convertWeights(void* buffer, const nvinfer1::Weights& weights)
+    {
+        if (mDataType == nvinfer1::DataType::kFLOAT)
+        {
+            half_float::convert_n(static_cast<const half_float::half*>(weights.values), static_cast<float*>(buffer),
+                weights.count);
+        }
+        else
+        {
+            half_float::convert_n(static_cast<const float*>(weights.values), static_cast<half_float::half*>(buffer),
+                weights.count);
+        }
+    }
+
     void convertAndCopyToDevice(void*& deviceWeights, const nvinfer1::Weights& weights)
     {
         if (weights.type != mDataType) // Weights are converted in host memory first, if the type does not match
         {
             size_t size = weights.count * (mDataType == nvinfer1::DataType::kFLOAT ? sizeof(float) : sizeof(__half));
             void* buffer = malloc(size);
-            for (int64_t v = 0; v < weights.count; ++v)
-            {
-                if (mDataType == nvinfer1::DataType::kFLOAT)
-                {
-                    static_cast<float*>(buffer)[v] = fp16::__half2float(static_cast<const __half*>(weights.values)[v]);
-                }
-                else
-                {
-                    static_cast<__half*>(buffer)[v] = fp16::__float2half(static_cast<const float*>(weights.values)[v]);
-                }
-            }
+            convertWeights(buffer, weights);
             deviceWeights = copyToDevice(buffer, size);
             free(buffer);
         }
@@ -252,17 +258,7 @@ private:
     {
         if (weights.type != mDataType)
         {
-            for (int64_t v = 0; v < weights.count; ++v)
-            {
-                if (mDataType == nvinfer1::DataType::kFLOAT)
-                {
-                    reinterpret_cast<float*>(buffer)[v] = fp16::__half2float(static_cast<const __half*>(weights.values)[v]);
-                }
-                else
-                {
-                    reinterpret_cast<__half*>(buffer)[v] = fp16::__float2half(static_cast<const float*>(weights.values)[v]);
-                }
-            }
+            convertWeights(buffer, weights);
         }
         else
         {
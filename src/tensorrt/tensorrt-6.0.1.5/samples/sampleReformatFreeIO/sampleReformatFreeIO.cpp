@@ -61,6 +61,7 @@
 #include "common.h"
 #include "half.h"
 #include "logger.h"
+#include "quantize.h"
 
 #include "NvCaffeParser.h"
 #include "NvInfer.h"
@@ -581,19 +582,26 @@ void convertGoldenData(SampleBuffer & goldenInput, SampleBuffer & dstInput)
 
     for (int i = 0; i < goldenInput.desc.getElememtSize(); i++)
     {
-        if (std::is_same<T, int8_t>::value)
-        {
-            tmp[i] = static_cast<T>(golden[i] - 128);
-        }
-        else
-        {
-            tmp[i] = static_cast<T>(golden[i]);
-        }
+        tmp[i] = static_cast<T>(golden[i]);
     }
 
     reformat<T>(tmpBuf, dstInput);
 }
 
+//!
+//! \brief Shifts the [0, 255] golden pixels to int8 with the quantization kernels.
+//!
+template <>
+void convertGoldenData<int8_t>(SampleBuffer & goldenInput, SampleBuffer & dstInput)
+{
+    SampleBuffer tmpBuf(goldenInput.dims, sizeof(int8_t), goldenInput.format);
+
+    samplesCommon::quantizeInt8(reinterpret_cast<const float*>(goldenInput.buffer),
+        reinterpret_cast<int8_t*>(tmpBuf.buffer), goldenInput.desc.getElememtSize(), 1.0F, -128);
+
+    reformat<int8_t>(tmpBuf, dstInput);
+}
+
 //!
 //! \brief Used to randomly initialize buffers
 //!
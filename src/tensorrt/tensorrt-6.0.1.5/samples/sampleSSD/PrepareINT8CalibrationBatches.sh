@@ -64,4 +64,25 @@ if ! type "convert" > /dev/null; then
     exit 1
 fi
 
-python batchPrepare.py --inDir $TEMP_DIR/VOCdevkit/VOC2007/JPEGImages/ --outDir $TEMP_DIR
+TRTPACK=${TRTPACK:-$(dirname $0)/../../bin/trtpack}
+if [ ! -x "$TRTPACK" ]; then
+    echo "Build trtpack with make in samples/trtpack, or set TRTPACK to its path, to proceed"
+    exit 1
+fi
+
+NUM_CALIBRATION_IMAGES=500
+OUT_DIR=$TEMP_DIR/batches
+IMAGE_DIR=$OUT_DIR/images
+rm -rf $IMAGE_DIR
+mkdir -p $IMAGE_DIR
+
+# Resize a random selection of images to the 300x300 input of the network.
+ls $TEMP_DIR/VOCdevkit/VOC2007/JPEGImages/*.jpg | shuf -n $NUM_CALIBRATION_IMAGES | while read IMAGE; do
+    NAME=$(basename $IMAGE .jpg)
+    convert $IMAGE -resize 300x300! $IMAGE_DIR/$NAME.ppm
+    echo $NAME.ppm >> $IMAGE_DIR/list.txt
+done
+
+# Switch to BGR and subtract the mean as the Caffe model expects, then pack every image in one file.
+$TRTPACK --list=list.txt --dir=$IMAGE_DIR/ --output=$OUT_DIR/calibration.pack --bgr --mean=104,117,123
+rm -rf $IMAGE_DIR
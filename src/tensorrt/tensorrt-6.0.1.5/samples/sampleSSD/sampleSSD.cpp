@@ -58,6 +58,8 @@
 #include "argsParser.h"
 #include "buffers.h"
 #include "common.h"
+#include "imageFile.h"
+#include "imagePreprocess.h"
 #include "logger.h"
 #include "BatchStream.h"
 #include "EntropyCalibrator.h"
@@ -83,7 +85,7 @@ struct SampleSSDParams : public samplesCommon::CaffeSampleParams
     int keepTopK;     //!< The maximum number of detection post-NMS
     int nbCalBatches;  //!< The number of batches for calibration
     float visualThreshold; //!< The minimum score threshold to consider a detection
-    std::string calibrationBatches; //!< The path to calibration batches
+    std::string calibrationBatches; //!< The path to the packed calibration dataset
 };
 
 //! \brief  The SampleSSD class implements the SSD sample
@@ -122,7 +124,8 @@ private:
 
     nvinfer1::Dims mInputDims; //!< The dimensions of the input to the network.
 
-    std::vector<samplesCommon::PPM<3, 300, 300>> mPPMs; //!< PPMs of test images
+    std::vector<samplesCommon::ImageInfo> mImages; //!< Test images
+    std::vector<uint8_t> mImageData;               //!< Pixels of the test images, one after the other
 
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine; //!< The TensorRT engine used to run the network
 
@@ -142,6 +145,14 @@ private:
     //! \brief Filters output detections and verify results
     //!
     bool verifyOutput(const samplesCommon::BufferManager& buffers);
+
+    //!
+    //! \brief Returns the pixels of the i-th test image
+    //!
+    uint8_t* getImageData(int i)
+    {
+        return mImageData.data() + i * mImages[i].size();
+    }
 };
 
 //!
@@ -227,8 +238,15 @@ bool SampleSSD::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builder,
     if (mParams.int8)
     {
         gLogInfo << "Using Entropy Calibrator 2" << std::endl;
-        BatchStream calibrationStream(mParams.batchSize, mParams.nbCalBatches, mParams.calibrationBatches, mParams.dataDirs);
-        calibrator.reset(new Int8EntropyCalibrator2<BatchStream>(calibrationStream, 0, "SSD", mParams.inputTensorNames[0].c_str()));
+        PackedBatchStream calibrationStream(
+            mParams.batchSize, mParams.nbCalBatches, mParams.calibrationBatches, mParams.dataDirs);
+        if (!calibrationStream.isValid())
+        {
+            gLogError << "Could not open the calibration batches: " << calibrationStream.getError() << std::endl;
+            return false;
+        }
+        calibrator.reset(new Int8EntropyCalibrator2<PackedBatchStream>(
+            calibrationStream, 0, "SSD", mParams.inputTensorNames[0].c_str()));
         config->setFlag(BuilderFlag::kINT8);
         config->setInt8Calibrator(calibrator.get());
     }
@@ -313,28 +331,33 @@ bool SampleSSD::processInput(const samplesCommon::BufferManager& buffers)
 
     // Available images
     std::vector<std::string> imageList = {"bus.ppm"};
-    mPPMs.resize(batchSize);
-    assert(mPPMs.size() <= imageList.size());
+    assert(batchSize <= static_cast<int>(imageList.size()));
+    std::vector<std::string> fileNames;
     for (int i = 0; i < batchSize; ++i)
     {
-        readPPMFile(locateFile(imageList[i], mParams.dataDirs), mPPMs[i]);
+        fileNames.push_back(locateFile(imageList[i], mParams.dataDirs));
+    }
+    mImageData.resize(batchSize * inputC * inputH * inputW);
+    std::string err;
+    if (!samplesCommon::readImageBatch(fileNames, inputC, inputH, inputW, mImageData.data(), mImages, err))
+    {
+        gLogError << err << std::endl;
+        return false;
     }
 
     // Fill data buffer
     float* hostDataBuffer = static_cast<float*>(buffers.getHostBuffer("data"));
-    float pixelMean[3]{104.0f, 117.0f, 123.0f}; // In BGR order
-    // Host memory for input buffer
-    for (int i = 0, volImg = inputC * inputH * inputW; i < mParams.batchSize; ++i)
+    samplesCommon::ImagePreprocessParams params;
+    params.channels = inputC;
+    // The color image to input should be in BGR order
+    params.swapRB();
+    params.setMeanScale({104.0f, 117.0f, 123.0f}, 1.0f); // In BGR order
+    std::vector<const uint8_t*> images;
+    for (int i = 0; i < batchSize; ++i)
     {
-        for (int c = 0; c < inputC; ++c)
-        {
-            // The color image to input should be in BGR order
-            for (unsigned j = 0, volChl = inputH * inputW; j < volChl; ++j)
-            {
-                hostDataBuffer[i * volImg + c * volChl + j] = float(mPPMs[i].buffer[j * inputC + 2 - c]) - pixelMean[c];
-            }
-        }
+        images.push_back(getImageData(i));
     }
+    samplesCommon::preprocessHWCBatch(images, inputH, inputW, 0, hostDataBuffer, params);
 
     return true;
 }
@@ -381,7 +404,7 @@ bool SampleSSD::verifyOutput(const samplesCommon::BufferManager& buffers)
                 correctDetection = true;
             }
 
-            gLogInfo << " Image name:" << mPPMs[p].fileName.c_str() << ", Label: " << classes[(int) det[1]].c_str() << ","
+            gLogInfo << " Image name:" << mImages[p].fileName.c_str() << ", Label: " << classes[(int) det[1]].c_str() << ","
                      << " confidence: " << det[2] * 100.f
                      << " xmin: " << det[3] * inputW
                      << " ymin: " << det[4] * inputH
@@ -389,7 +412,7 @@ bool SampleSSD::verifyOutput(const samplesCommon::BufferManager& buffers)
                      << " ymax: " << det[6] * inputH
                      << std::endl;
 
-            samplesCommon::writePPMFileWithBBox(storeName, mPPMs[p], {det[3] * inputW, det[4] * inputH, det[5] * inputW, det[6] * inputH});
+            samplesCommon::writePPMFileWithBBox(storeName, mImages[p], getImageData(p), {det[3] * inputW, det[4] * inputH, det[5] * inputW, det[6] * inputH});
         }
         pass &= numDetections >= 1;
         pass &= correctDetection;
@@ -429,7 +452,7 @@ SampleSSDParams initializeSampleParams(const samplesCommon::Args& args)
     params.keepTopK = 200; // Number of total bboxes to be kept per image after NMS step. It is same as detection_output_param.keep_top_k in prototxt file
     params.nbCalBatches = 500;
     params.visualThreshold = 0.6f;
-    params.calibrationBatches = "batches/batch_calibration";
+    params.calibrationBatches = "batches/calibration.pack";
 
     return params;
 }
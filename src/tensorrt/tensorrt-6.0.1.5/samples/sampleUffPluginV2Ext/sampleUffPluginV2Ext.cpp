@@ -62,7 +62,9 @@
 #include "argsParser.h"
 #include "common.h"
 #include "half.h"
+#include "halfConvert.h"
 #include "logger.h"
+#include "quantize.h"
 
 using namespace nvuffparser;
 using namespace nvinfer1;
@@ -81,37 +83,25 @@ void transform(const void* src, void* dst, int count)
 template <>
 void transform<DataType::kHALF, DataType::kFLOAT>(const void* src, void* dst, int count)
 {
-    auto srcPtr = static_cast<const half_float::half*>(src);
-    auto dstPtr = static_cast<float*>(dst);
-    std::transform(srcPtr, srcPtr + count, dstPtr, [](half_float::half in) { return static_cast<float>(in); });
+    half_float::convert_n(static_cast<const half_float::half*>(src), static_cast<float*>(dst), count);
 }
 
 template <>
 void transform<DataType::kINT8, DataType::kFLOAT>(const void* src, void* dst, int count)
 {
-    auto srcPtr = static_cast<const int8_t*>(src);
-    auto dstPtr = static_cast<float*>(dst);
-    std::transform(srcPtr, srcPtr + count, dstPtr, [](int8_t in) { return static_cast<float>(in); });
+    samplesCommon::dequantizeInt8(static_cast<const int8_t*>(src), static_cast<float*>(dst), count, 1.0F);
 }
 
 template <>
 void transform<DataType::kFLOAT, DataType::kHALF>(const void* src, void* dst, int count)
 {
-    auto srcPtr = static_cast<const float*>(src);
-    auto dstPtr = static_cast<half_float::half*>(dst);
-    std::transform(srcPtr, srcPtr + count, dstPtr, [](float in) { return static_cast<half_float::half>(in); });
+    half_float::convert_n(static_cast<const float*>(src), static_cast<half_float::half*>(dst), count);
 }
 
 template <>
 void transform<DataType::kFLOAT, DataType::kINT8>(const void* src, void* dst, int count)
 {
-    auto srcPtr = static_cast<const float*>(src);
-    auto dstPtr = static_cast<int8_t*>(dst);
-    std::transform(srcPtr, srcPtr + count, dstPtr, [](float x) {
-        x = std::max(x, float(INT8_MIN));
-        x = std::min(x, float(INT8_MAX));
-        return static_cast<int8_t>(x);
-    });
+    samplesCommon::quantizeInt8(static_cast<const float*>(src), static_cast<int8_t*>(dst), count, 1.0F);
 }
 
 static const int INPUT_H = 28;
@@ -631,14 +621,9 @@ private:
         std::unique_ptr<char> inputTmp{new char[inCount * elementSize(mDataType)]};
         CHECK(cudaMemcpy(inputTmp.get(), src, inCount * elementSize(mDataType), cudaMemcpyDeviceToHost));
         std::unique_ptr<float> inputFP32{new float[inCount]};
-        transform<DataType::kINT8, DataType::kFLOAT>(inputTmp.get(), inputFP32.get(), inCount);
-        // int8 scale
-        int hw = mInputDims.d[1] * mInputDims.d[2];
-        for (int j = 0; j < mInputDims.d[0]; ++j)
-        {
-            std::transform(inputFP32.get() + hw * j, inputFP32.get() + hw * (j + 1),  inputFP32.get() + hw * j,
-                [&](float in) -> float { return in * mInHostScale; });
-        }
+        // The whole tensor shares one scale, dequantize it in a single pass.
+        samplesCommon::dequantizeInt8(
+            reinterpret_cast<const int8_t*>(inputTmp.get()), inputFP32.get(), inCount, mInHostScale);
         CHECK(cudaMalloc(&dst, inCount * elementSize(DataType::kFLOAT)));
         CHECK(cudaMemcpy(dst, inputFP32.get(), inCount * elementSize(DataType::kFLOAT), cudaMemcpyHostToDevice));
     }
@@ -649,14 +634,8 @@ private:
         std::unique_ptr<float> outTmp{new float[outCount]};
         CHECK(cudaMemcpy(outTmp.get(), src, outCount * elementSize(DataType::kFLOAT), cudaMemcpyDeviceToHost));
         std::unique_ptr<char> outInt8{new char[outCount * elementSize(DataType::kINT8)]};
-        // int8 + scale
-        int hw = mOutputDims.d[1] * mOutputDims.d[2];
-        for (int j = 0; j < mInputDims.d[0]; ++j)
-        {
-            std::transform(outTmp.get() + hw * j, outTmp.get() + hw * (j + 1), outTmp.get() + hw * j,
-                [&](float in) -> float { return in / mOutHostScale; });
-        }
-        transform<DataType::kFLOAT, DataType::kINT8>(outTmp.get(), outInt8.get(), outCount);
+        // Scale, round and saturate in a single pass.
+        samplesCommon::quantizeInt8(outTmp.get(), reinterpret_cast<int8_t*>(outInt8.get()), outCount, mOutHostScale);
         CHECK(cudaMemcpy(dst, outInt8.get(), outCount, cudaMemcpyHostToDevice));
     }
 
@@ -60,6 +60,8 @@
 #include "argsParser.h"
 #include "buffers.h"
 #include "common.h"
+#include "imageFile.h"
+#include "imagePreprocess.h"
 #include "logger.h"
 
 #include "NvInfer.h"
@@ -124,7 +126,8 @@ private:
 
     nvinfer1::Dims mInputDims; //!< The dimensions of the input to the network.
 
-    std::vector<samplesCommon::PPM<3, 300, 300>> mPPMs; //!< PPMs of test images
+    std::vector<samplesCommon::ImageInfo> mImages; //!< Test images
+    std::vector<uint8_t> mImageData;               //!< Pixels of the test images, one after the other
 
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine; //!< The TensorRT engine used to run the network
 
@@ -144,6 +147,14 @@ private:
     //! \brief Filters output detections and verify results
     //!
     bool verifyOutput(const samplesCommon::BufferManager& buffers);
+
+    //!
+    //! \brief Returns the pixels of the i-th test image
+    //!
+    uint8_t* getImageData(int i)
+    {
+        return mImageData.data() + i * mImages[i].size();
+    }
 };
 
 //!
@@ -237,9 +248,10 @@ bool SampleUffSSD::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builder
         const int imageW = 300;
         nvinfer1::DimsNCHW imageDims{};
         imageDims = nvinfer1::DimsNCHW{mParams.calBatchSize, imageC, imageH, imageW};
-        BatchStream calibrationStream(mParams.nbCalBatches, imageDims, listFileName, mParams.dataDirs);
-        calibrator.reset(
-            new Int8EntropyCalibrator2<BatchStream>(calibrationStream, 0, "UffSSD", mParams.inputTensorNames[0].c_str()));
+        PrefetchBatchStream<BatchStream> calibrationStream(
+            BatchStream(mParams.nbCalBatches, imageDims, listFileName, mParams.dataDirs));
+        calibrator.reset(new Int8EntropyCalibrator2<PrefetchBatchStream<BatchStream>>(
+            calibrationStream, 0, "UffSSD", mParams.inputTensorNames[0].c_str()));
         config->setFlag(BuilderFlag::kINT8);
         config->setInt8Calibrator(calibrator.get());
     }
@@ -322,27 +334,32 @@ bool SampleUffSSD::processInput(const samplesCommon::BufferManager& buffers)
 
     // Available images
     std::vector<std::string> imageList = {"dog.ppm", "bus.ppm"};
-    mPPMs.resize(batchSize);
-    assert(mPPMs.size() <= imageList.size());
+    assert(batchSize <= static_cast<int>(imageList.size()));
+    std::vector<std::string> fileNames;
     for (int i = 0; i < batchSize; ++i)
     {
-        readPPMFile(locateFile(imageList[i], mParams.dataDirs), mPPMs[i]);
+        fileNames.push_back(locateFile(imageList[i], mParams.dataDirs));
+    }
+    mImageData.resize(batchSize * inputC * inputH * inputW);
+    std::string err;
+    if (!samplesCommon::readImageBatch(fileNames, inputC, inputH, inputW, mImageData.data(), mImages, err))
+    {
+        gLogError << err << std::endl;
+        return false;
     }
 
     float* hostDataBuffer = static_cast<float*>(buffers.getHostBuffer(mParams.inputTensorNames[0]));
-    // Host memory for input buffer
-    for (int i = 0, volImg = inputC * inputH * inputW; i < mParams.batchSize; ++i)
+    // Host memory for input buffer, scaled to [-1, 1]
+    samplesCommon::ImagePreprocessParams params;
+    params.channels = inputC;
+    params.scale.fill(2.0 / 255.0);
+    params.bias.fill(-1.0);
+    std::vector<const uint8_t*> images;
+    for (int i = 0; i < batchSize; ++i)
     {
-        for (int c = 0; c < inputC; ++c)
-        {
-            // The color image to input should be in BGR order
-            for (unsigned j = 0, volChl = inputH * inputW; j < volChl; ++j)
-            {
-                hostDataBuffer[i * volImg + c * volChl + j]
-                    = (2.0 / 255.0) * float(mPPMs[i].buffer[j * inputC + c]) - 1.0;
-            }
-        }
+        images.push_back(getImageData(i));
     }
+    samplesCommon::preprocessHWCBatch(images, inputH, inputW, 0, hostDataBuffer, params);
 
     return true;
 }
@@ -405,7 +422,7 @@ bool SampleUffSSD::verifyOutput(const samplesCommon::BufferManager& buffers)
             }
 
             gLogInfo << "Detected " << classes[detection].c_str() << " in the image " << int(det[0]) << " ("
-                     << mPPMs[p].fileName.c_str() << ")"
+                     << mImages[p].fileName.c_str() << ")"
                      << " with confidence " << det[2] * 100.f << " and coordinates (" << det[3] * inputW << ","
                      << det[4] * inputH << ")"
                      << ",(" << det[5] * inputW << "," << det[6] * inputH << ")." << std::endl;
@@ -413,7 +430,7 @@ bool SampleUffSSD::verifyOutput(const samplesCommon::BufferManager& buffers)
             gLogInfo << "Result stored in " << storeName.c_str() << "." << std::endl;
 
             samplesCommon::writePPMFileWithBBox(
-                storeName, mPPMs[p], {det[3] * inputW, det[4] * inputH, det[5] * inputW, det[6] * inputH});
+                storeName, mImages[p], getImageData(p), {det[3] * inputW, det[4] * inputH, det[5] * inputW, det[6] * inputH});
         }
         pass &= correctDetection;
         pass &= numDetections >= 1;
@@ -0,0 +1,538 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "activationHistogram.h"
+#include "calibrationTable.h"
+#include "halfConvert.h"
+#include "logger.h"
+#include "mappedFile.h"
+#include "parallelFor.h"
+#include "sampleOptions.h"
+
+using namespace sample;
+
+namespace
+{
+
+enum class RangeMethod
+{
+    kENTROPY,
+    kPERCENTILE,
+    kMAX
+};
+
+struct CalibOptions
+{
+    std::vector<std::string> activations; //!< name:file pairs
+    std::string listFile;
+    std::vector<std::string> loadHistograms;
+    std::string saveHistograms;
+    std::string output;
+    RangeMethod method{RangeMethod::kENTROPY};
+    float percentile{99.99F};
+    int bins{samplesCommon::kHISTOGRAM_BINS};
+    int threads{0};
+    int shard{0};
+    int nbShards{1};
+};
+
+//! Elements histogrammed per task, so that large files are split between the workers.
+constexpr size_t kCHUNK_ELEMENTS{1 << 20};
+
+void printHelp(std::ostream& out)
+{
+    out << "Usage: trtcalib --activations=<name:file> | --list=<file> | --loadHistograms=<file>" << std::endl
+        << "                --output=<file> | --saveHistograms=<file> [options]" << std::endl
+        << "  --activations=<name:file>  Values of tensor name, as raw little endian floats or a .npy array of"
+        << " float32 or" << std::endl
+        << "                             float16. Can be repeated, including for the same tensor" << std::endl
+        << "  --list=<file>              File with one name:file pair per line. Names may contain ':', file names"
+        << " may not" << std::endl
+        << "  --shard=<i/N>              Only read the i-th of N slices of the files of every tensor, from 0"
+        << std::endl
+        << "  --loadHistograms=<file>    Merge the histograms of a file written by --saveHistograms, can be repeated"
+        << std::endl
+        << "  --saveHistograms=<file>    Histogram file to write, which can be merged with other shards" << std::endl
+        << "  --output=<file>            Per tensor dynamic range file to write, as read by sampleINT8API"
+        << std::endl
+        << "  --method=entropy|percentile|max" << std::endl
+        << "                             How the ranges are computed from the histograms (default = entropy)"
+        << std::endl
+        << "  --percentile=<P>           Percentile of the absolute values used by --method=percentile"
+        << " (default = 99.99)" << std::endl
+        << "  --bins=<N>                 Number of histogram bins, a power of two of at least 128 (default = "
+        << samplesCommon::kHISTOGRAM_BINS << ")" << std::endl
+        << "  --threads=<N>              Number of worker threads (default = one per CPU)" << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, CalibOptions& options)
+{
+    Arguments args = argsToArgumentsMap(argc, argv);
+    bool help{false};
+    checkEraseOption(args, "--help", help);
+    checkEraseOption(args, "-h", help);
+    if (help)
+    {
+        return false;
+    }
+
+    try
+    {
+        checkEraseRepeatedOption(args, "--activations", options.activations);
+        checkEraseOption(args, "--list", options.listFile);
+        checkEraseRepeatedOption(args, "--loadHistograms", options.loadHistograms);
+        checkEraseOption(args, "--saveHistograms", options.saveHistograms);
+        checkEraseOption(args, "--output", options.output);
+        checkEraseOption(args, "--percentile", options.percentile);
+        checkEraseOption(args, "--bins", options.bins);
+        checkEraseOption(args, "--threads", options.threads);
+
+        std::string method;
+        if (checkEraseOption(args, "--method", method))
+        {
+            if (method == "entropy")
+            {
+                options.method = RangeMethod::kENTROPY;
+            }
+            else if (method == "percentile")
+            {
+                options.method = RangeMethod::kPERCENTILE;
+            }
+            else if (method == "max")
+            {
+                options.method = RangeMethod::kMAX;
+            }
+            else
+            {
+                throw std::invalid_argument("Invalid method " + method);
+            }
+        }
+        std::string shard;
+        if (checkEraseOption(args, "--shard", shard))
+        {
+            const std::vector<std::string> values{splitToStringVec(shard, '/')};
+            if (values.size() != 2)
+            {
+                throw std::invalid_argument("Invalid shard " + shard);
+            }
+            options.shard = stringToValue<int>(values[0]);
+            options.nbShards = stringToValue<int>(values[1]);
+            if (options.nbShards <= 0 || options.shard < 0 || options.shard >= options.nbShards)
+            {
+                throw std::invalid_argument("Invalid shard " + shard);
+            }
+        }
+        if (!samplesCommon::ActivationHistogram::isValidNbBins(options.bins))
+        {
+            throw std::invalid_argument("Invalid number of bins " + std::to_string(options.bins));
+        }
+        if (options.percentile <= 0.F || options.percentile > 100.F)
+        {
+            throw std::invalid_argument("Invalid percentile " + std::to_string(options.percentile));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << e.what() << std::endl;
+        return false;
+    }
+
+    if (!args.empty())
+    {
+        for (const auto& arg : args)
+        {
+            gLogError << "Unknown option: " << arg.first << " " << arg.second << std::endl;
+        }
+        return false;
+    }
+    if (options.activations.empty() && options.listFile.empty() && options.loadHistograms.empty())
+    {
+        gLogError << "One of --activations, --list or --loadHistograms is required" << std::endl;
+        return false;
+    }
+    if (options.output.empty() && options.saveHistograms.empty())
+    {
+        gLogError << "One of --output or --saveHistograms is required" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> readLines(const std::string& fileName)
+{
+    std::vector<std::string> lines;
+    std::ifstream file(fileName);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (!line.empty())
+        {
+            lines.emplace_back(line);
+        }
+    }
+    return lines;
+}
+
+//!
+//! \brief Values of one tensor in a mapped file
+//!
+struct ActivationFile
+{
+    std::string tensor;
+    std::string name;
+    samplesCommon::MappedFile file;
+    const uint8_t* data{nullptr};
+    size_t count{0};
+    bool isHalf{false};
+};
+
+//!
+//! \brief Locate the array of a .npy file, which must hold little endian float32 or float16 values.
+//!
+//! \details The order of the elements does not matter for a histogram, so the shape is only used to count them.
+//!
+bool parseNpy(ActivationFile& a, std::ostream& err)
+{
+    const uint8_t* data = a.file.data();
+    const size_t size = a.file.size();
+    if (size < 10 || data[6] < 1 || data[6] > 3)
+    {
+        err << a.name << " has an unsupported .npy version" << std::endl;
+        return false;
+    }
+    const size_t lengthSize = data[6] == 1 ? 2 : 4;
+    size_t headerLength{0};
+    for (size_t i = 0; i < lengthSize; ++i)
+    {
+        headerLength |= static_cast<size_t>(data[8 + i]) << (8 * i);
+    }
+    const size_t offset = 8 + lengthSize + headerLength;
+    if (offset > size)
+    {
+        err << a.name << " is truncated" << std::endl;
+        return false;
+    }
+    const std::string header(reinterpret_cast<const char*>(data) + 8 + lengthSize, headerLength);
+
+    const size_t descr = header.find("'descr'");
+    const size_t begin = header.find('\'', header.find(':', descr) + 1);
+    const std::string type = descr == std::string::npos || begin == std::string::npos
+        ? std::string()
+        : header.substr(begin + 1, header.find('\'', begin + 1) - begin - 1);
+    if (type != "<f4" && type != "<f2")
+    {
+        err << a.name << " holds " << type << " values, only <f4 and <f2 are supported" << std::endl;
+        return false;
+    }
+    a.isHalf = type == "<f2";
+
+    const size_t shape = header.find('(', header.find("'shape'"));
+    const size_t shapeEnd = header.find(')', shape);
+    if (header.find("'shape'") == std::string::npos || shape == std::string::npos || shapeEnd == std::string::npos)
+    {
+        err << a.name << " has no shape" << std::endl;
+        return false;
+    }
+    a.count = 1;
+    for (const auto& d : splitToStringVec(header.substr(shape + 1, shapeEnd - shape - 1), ','))
+    {
+        const size_t first = d.find_first_not_of(' ');
+        if (first == std::string::npos)
+        {
+            // After the comma of 1-D shapes
+            continue;
+        }
+        std::string digits = d.substr(first, d.find_last_not_of(' ') - first + 1);
+        if (digits.size() > 1 && digits.back() == 'L')
+        {
+            // Python 2 writes long integers with a suffix
+            digits.pop_back();
+        }
+        if (digits.empty() || digits.size() > 18 || digits.find_first_not_of("0123456789") != std::string::npos)
+        {
+            err << a.name << " has an invalid shape: (" << header.substr(shape + 1, shapeEnd - shape - 1) << ")"
+                << std::endl;
+            return false;
+        }
+        // Counts above the size of the file are truncated anyway, capping them keeps the product from overflowing
+        const uint64_t dim = std::stoull(digits);
+        a.count = dim && a.count > (size + 1) / dim ? size + 1 : a.count * dim;
+    }
+    if (a.count * (a.isHalf ? 2 : 4) > size - offset)
+    {
+        err << a.name << " is truncated" << std::endl;
+        return false;
+    }
+    a.data = data + offset;
+    return true;
+}
+
+bool openActivations(ActivationFile& a, const std::string& fileName, std::ostream& err)
+{
+    if (!a.file.open(fileName, samplesCommon::MappedFile::Advice::kSEQUENTIAL))
+    {
+        err << "Cannot read " << fileName << std::endl;
+        return false;
+    }
+    a.name = fileName;
+    if (a.file.size() >= 6 && !std::memcmp(a.file.data(), "\x93NUMPY", 6))
+    {
+        return parseNpy(a, err);
+    }
+    a.data = a.file.data();
+    a.count = a.file.size() / sizeof(float);
+    return true;
+}
+
+float getRange(const samplesCommon::ActivationHistogram& h, RangeMethod method, float percentile)
+{
+    switch (method)
+    {
+    case RangeMethod::kENTROPY: return h.getEntropyRange();
+    case RangeMethod::kPERCENTILE: return h.getPercentileRange(percentile);
+    case RangeMethod::kMAX: break;
+    }
+    return h.getMaxRange();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    CalibOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printHelp(std::cout);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> pairs = options.activations;
+    if (!options.listFile.empty())
+    {
+        const std::vector<std::string> lines = readLines(options.listFile);
+        if (lines.empty())
+        {
+            gLogError << "No activations listed in " << options.listFile << std::endl;
+            return EXIT_FAILURE;
+        }
+        pairs.insert(pairs.end(), lines.begin(), lines.end());
+    }
+
+    // A tensor usually has one file per batch, a shard takes the same slice of the files of every tensor.
+    std::map<std::string, std::vector<std::string>> tensorFiles;
+    for (const auto& pair : pairs)
+    {
+        const size_t colon = pair.rfind(':');
+        if (colon == std::string::npos || colon == 0)
+        {
+            gLogError << "Expected name:file, got " << pair << std::endl;
+            return EXIT_FAILURE;
+        }
+        tensorFiles[pair.substr(0, colon)].push_back(pair.substr(colon + 1));
+    }
+    std::vector<ActivationFile> files;
+    for (const auto& t : tensorFiles)
+    {
+        const auto slice = samplesCommon::getShardSlice(t.second.size(), options.shard, options.nbShards);
+        for (size_t f = slice.first; f < slice.second; ++f)
+        {
+            files.emplace_back();
+            files.back().tensor = t.first;
+            if (!openActivations(files.back(), t.second[f], gLogError))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    struct Chunk
+    {
+        size_t file;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<Chunk> chunks;
+    for (size_t f = 0; f < files.size(); ++f)
+    {
+        for (size_t begin = 0; begin < files[f].count; begin += kCHUNK_ELEMENTS)
+        {
+            chunks.push_back({f, begin, std::min(begin + kCHUNK_ELEMENTS, files[f].count)});
+        }
+    }
+
+    // Every worker fills its own histograms, which are merged at the end. Merging is exact, so the histograms do not
+    // depend on the number of threads, on how the chunks were split between them or on the shards.
+    std::map<std::string, samplesCommon::ActivationHistogram> histograms;
+    for (const auto& t : tensorFiles)
+    {
+        histograms.emplace(t.first, samplesCommon::ActivationHistogram(options.bins));
+    }
+    std::mutex mutex;
+    samplesCommon::parallelFor(0, static_cast<int64_t>(chunks.size()),
+        [&](int64_t first, int64_t last) {
+            std::map<std::string, samplesCommon::ActivationHistogram> local;
+            std::vector<float> floats;
+            for (int64_t c = first; c < last; ++c)
+            {
+                const ActivationFile& a = files[chunks[c].file];
+                const size_t count = chunks[c].end - chunks[c].begin;
+                const float* values = reinterpret_cast<const float*>(a.data) + chunks[c].begin;
+                if (a.isHalf)
+                {
+                    floats.resize(count);
+                    half_float::convert::toFloat(reinterpret_cast<const uint16_t*>(a.data) + chunks[c].begin,
+                        floats.data(), count, half_float::convert::Isa::kAUTO);
+                    values = floats.data();
+                }
+                auto h = local.find(a.tensor);
+                if (h == local.end())
+                {
+                    h = local.emplace(a.tensor, samplesCommon::ActivationHistogram(options.bins)).first;
+                }
+                h->second.add(values, count);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& h : local)
+            {
+                histograms.at(h.first).merge(h.second);
+            }
+        },
+        1, options.threads);
+
+    for (const auto& fileName : options.loadHistograms)
+    {
+        if (!samplesCommon::readHistograms(fileName, histograms, gLogError))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    if (!options.saveHistograms.empty())
+    {
+        if (!samplesCommon::writeHistograms(options.saveHistograms, histograms, gLogError))
+        {
+            return EXIT_FAILURE;
+        }
+        gLogInfo << "Wrote the histograms of " << histograms.size() << " tensors to " << options.saveHistograms
+                 << std::endl;
+    }
+    if (options.output.empty())
+    {
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<const std::pair<const std::string, samplesCommon::ActivationHistogram>*> tensors;
+    for (const auto& h : histograms)
+    {
+        tensors.push_back(&h);
+    }
+    std::vector<float> maxRanges(tensors.size());
+    std::vector<float> percentileRanges(tensors.size());
+    std::vector<float> entropyRanges(tensors.size());
+    samplesCommon::parallelFor(0, static_cast<int64_t>(tensors.size()),
+        [&](int64_t first, int64_t last) {
+            for (int64_t t = first; t < last; ++t)
+            {
+                const samplesCommon::ActivationHistogram& h = tensors[t]->second;
+                maxRanges[t] = getRange(h, RangeMethod::kMAX, options.percentile);
+                percentileRanges[t] = getRange(h, RangeMethod::kPERCENTILE, options.percentile);
+                entropyRanges[t] = getRange(h, RangeMethod::kENTROPY, options.percentile);
+            }
+        },
+        1, options.threads);
+
+    gLogInfo << std::left << std::setw(32) << "Tensor" << std::right << std::setw(14) << "Values" << std::setw(14)
+             << "Max" << std::setw(14) << "Percentile" << std::setw(14) << "Entropy" << std::endl;
+    samplesCommon::CalibrationTable table;
+    size_t nbRanges{0};
+    for (size_t t = 0; t < tensors.size(); ++t)
+    {
+        const std::string& name = tensors[t]->first;
+        const samplesCommon::ActivationHistogram& h = tensors[t]->second;
+        gLogInfo << std::left << std::setw(32) << name << std::right << std::setw(14) << h.getCount()
+                 << std::setw(14) << maxRanges[t] << std::setw(14) << percentileRanges[t] << std::setw(14)
+                 << entropyRanges[t] << std::endl;
+        if (h.getNbNonFinite())
+        {
+            gLogWarning << name << " has " << h.getNbNonFinite() << " non-finite values" << std::endl;
+        }
+        if (h.empty())
+        {
+            // A range of 0 would quantize the tensor to zeros, a missing one is reported by the consumers
+            gLogWarning << name << " has no finite values in any file or shard, its range is left out of "
+                        << options.output << std::endl;
+            continue;
+        }
+        ++nbRanges;
+        const float range = options.method == RangeMethod::kENTROPY
+            ? entropyRanges[t]
+            : options.method == RangeMethod::kPERCENTILE ? percentileRanges[t] : maxRanges[t];
+        table.setDynamicRange(name, range);
+    }
+
+    if (!table.writeDynamicRanges(options.output, gLogError))
+    {
+        return EXIT_FAILURE;
+    }
+    gLogInfo << "Wrote the ranges of " << nbRanges << " tensors to " << options.output << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -73,127 +73,297 @@
 #include "logger.h"
 #include "sampleOptions.h"
 #include "sampleEngines.h"
+#include "sampleInference.h"
+#include "sampleReporting.h"
 
 using namespace nvinfer1;
 using namespace sample;
 
-float percentile(float percentage, std::vector<float>& times)
+//!
+//! \brief Run inference as set by the options, feeding report and, if not null, exporter
+//!
+bool runInference(ICudaEngine& engine, const InferenceOptions& inference, IProfiler* profiler,
+    std::vector<std::unique_ptr<TrtStreamExecutor>>& executors, PerformanceReport& report, TraceExporter* exporter)
 {
-    int all = static_cast<int>(times.size());
-    int exclude = static_cast<int>((1 - percentage / 100) * all);
-    if (0 <= exclude && exclude <= all)
+    if (!setUpInference(engine, inference, profiler, executors, gLogError))
     {
-        std::sort(times.begin(), times.end());
-        return times[all == exclude ? 0 : all - 1 - exclude];
+        return false;
     }
-    return std::numeric_limits<float>::infinity();
+    std::vector<IStreamExecutor*> streams;
+    for (const auto& e : executors)
+    {
+        streams.push_back(e.get());
+    }
+
+    const InferenceSchedule schedule = InferenceSchedule::fromOptions(inference);
+    const auto onTrace = [&report, exporter](const InferenceTrace& trace) {
+        report.addTrace(trace);
+        if (exporter)
+        {
+            exporter->push(trace);
+        }
+    };
+    if (schedule.qps > 0)
+    {
+        OpenLoopStats load;
+        if (!runOpenLoopInference(streams, schedule, onTrace, load, gLogError))
+        {
+            return false;
+        }
+        report.setOpenLoop(schedule, load);
+        return true;
+    }
+    return runInference(streams, schedule, onTrace, gLogError);
 }
 
 bool doInference(ICudaEngine& engine, const InferenceOptions& inference, const ReportingOptions& reporting)
 {
-    IExecutionContext* context = engine.createExecutionContext();
-
     // Dump inferencing time per layer basis
     SimpleProfiler profiler("Layer time");
+
+    const int nbThreads = inference.qps > 0 || inference.threads ? inference.streams : 1;
+    gLogInfo << "Running " << inference.streams << " stream(s) on " << nbThreads << " thread(s)" << std::endl;
+    PerformanceReport report(inference.streams, inference.batch, reporting, gLogInfo);
+    TraceExporter exporter;
+    const bool exportTimes = !reporting.exportTimes.empty();
+    if (exportTimes && !exporter.open(reporting.exportTimes, gLogError))
+    {
+        return false;
+    }
+    std::vector<std::unique_ptr<TrtStreamExecutor>> executors;
+    const bool success = runInference(engine, inference, reporting.profile ? &profiler : nullptr, executors, report,
+        exportTimes ? &exporter : nullptr);
+    if (!exporter.close())
+    {
+        gLogError << "Failed to write times to " << reporting.exportTimes << std::endl;
+    }
+    if (!success)
+    {
+        return false;
+    }
+    report.print();
+
+    if (reporting.output)
+    {
+        samplesCommon::BufferManager& bufferManager = executors.front()->getBuffers();
+        bufferManager.copyOutputToHost();
+        int nbBindings = engine.getNbBindings();
+        for (int i = 0; i < nbBindings; i++)
+        {
+            if (!engine.bindingIsInput(i))
+            {
+                const char* tensorName = engine.getBindingName(i);
+                gLogInfo << "Dumping output tensor " << tensorName << ":" << std::endl;
+                bufferManager.dumpBuffer(gLogInfo, tensorName);
+            }
+        }
+    }
+
     if (reporting.profile)
     {
-        context->setProfiler(&profiler);
+        gLogInfo << profiler;
     }
 
+    return true;
+}
+
+//!
+//! \brief Performance of one batch size of a sweep
+//!
+struct SweepPoint
+{
+    int batch{0};
+    double throughput{0}; //!< Inferences per second
+    float mean{0};        //!< Latencies in ms
+    float median{0};
+    float p99{0};
+    float gpuP99{0};
+};
+
+//!
+//! \brief Largest batch size the engine runs, 0 if it cannot change
+//!
+int getMaxSweepBatch(const ICudaEngine& engine, const InferenceOptions& inference)
+{
+    if (inference.batch)
+    {
+        return engine.getMaxBatchSize();
+    }
+    int maxBatch{0};
     for (int b = 0; b < engine.getNbBindings(); ++b)
     {
-        if (!engine.bindingIsInput(b))
+        if (!engine.bindingIsInput(b) || engine.getBindingDimensions(b).d[0] != -1)
         {
             continue;
         }
-        auto dims = context->getBindingDimensions(b);
-        if (dims.d[0] == -1)
+        const int profileMax = engine.getProfileDimensions(b, 0, OptProfileSelector::kMAX).d[0];
+        maxBatch = maxBatch ? std::min(maxBatch, profileMax) : profileMax;
+    }
+    return maxBatch;
+}
+
+bool measureSweepPoint(ICudaEngine& engine, InferenceOptions inference, const ReportingOptions& reporting, int batch,
+    SweepPoint& point)
+{
+    if (inference.batch)
+    {
+        inference.batch = batch;
+    }
+    else
+    {
+        for (auto& shape : inference.shapes)
         {
-            auto shape = inference.shapes.find(engine.getBindingName(b));
-            if (shape == inference.shapes.end())
-            {
-                gLogError << "Missing dynamic batch size in inference" << std::endl;
-                return false;
-            }
-            dims.d[0] = shape->second.d[0];
-            context->setBindingDimensions(b, dims);
+            shape.second.d[0] = batch;
         }
     }
 
-    // Use an aliasing shared_ptr since we don't want engine to be deleted when bufferManager goes out of scope.
-    std::shared_ptr<ICudaEngine> emptyPtr{};
-    std::shared_ptr<ICudaEngine> aliasPtr(emptyPtr, &engine);
-    samplesCommon::BufferManager bufferManager(aliasPtr, inference.batch, inference.batch ? nullptr : context);
-    std::vector<void*> buffers = bufferManager.getDeviceBindings();
+    // The per-run output goes to the verbose log, the sweep prints its own summary
+    PerformanceReport report(inference.streams, batch, reporting, gLogVerbose);
+    std::vector<std::unique_ptr<TrtStreamExecutor>> executors;
+    if (!runInference(engine, inference, nullptr, executors, report, nullptr))
+    {
+        return false;
+    }
+    point.batch = batch;
+    point.throughput = report.getThroughput();
+    point.mean = report.getLatencies().getMean();
+    point.median = report.getLatencies().getPercentile(50);
+    point.p99 = report.getLatencies().getPercentile(99);
+    point.gpuP99 = report.getGpuTimes().getPercentile(99);
+    gLogInfo << "Batch " << batch << ": " << point.throughput << " inferences/s, " << point.throughput * batch
+             << " samples/s, latency mean " << point.mean << " ms, median " << point.median << " ms, p99 " << point.p99
+             << " ms (GPU p99 " << point.gpuP99 << " ms)" << std::endl;
+    return true;
+}
 
-    cudaStream_t stream;
-    CHECK(cudaStreamCreate(&stream));
-    cudaEvent_t start, end;
-    unsigned int cudaEventFlags = inference.spin ? cudaEventDefault : cudaEventBlockingSync;
-    CHECK(cudaEventCreateWithFlags(&start, cudaEventFlags));
-    CHECK(cudaEventCreateWithFlags(&end, cudaEventFlags));
+bool exportSweep(const std::string& fileName, const std::vector<SweepPoint>& points, float slo)
+{
+    std::ofstream file(fileName);
+    const std::string csv{".csv"};
+    const bool isCsv
+        = fileName.size() >= csv.size() && fileName.compare(fileName.size() - csv.size(), csv.size(), csv) == 0;
+    if (isCsv)
+    {
+        file << "batch,inferencesPerSecond,samplesPerSecond,meanMs,medianMs,p99Ms,gpuP99Ms"
+             << (slo > 0 ? ",meetsSlo" : "") << std::endl;
+    }
+    else
+    {
+        file << "[";
+    }
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const SweepPoint& p = points[i];
+        if (isCsv)
+        {
+            file << p.batch << "," << p.throughput << "," << p.throughput * p.batch << "," << p.mean << ","
+                 << p.median << "," << p.p99 << "," << p.gpuP99;
+            if (slo > 0)
+            {
+                file << "," << (p.p99 <= slo ? "true" : "false");
+            }
+            file << std::endl;
+        }
+        else
+        {
+            file << (i ? "," : "") << std::endl
+                 << "  { \"batch\" : " << p.batch << ", \"inferencesPerSecond\" : " << p.throughput
+                 << ", \"samplesPerSecond\" : " << p.throughput * p.batch << ", \"meanMs\" : " << p.mean
+                 << ", \"medianMs\" : " << p.median << ", \"p99Ms\" : " << p.p99 << ", \"gpuP99Ms\" : " << p.gpuP99
+                 << (slo > 0 ? std::string(", \"meetsSlo\" : ") + (p.p99 <= slo ? "true" : "false") : "") << " }";
+        }
+    }
+    if (!isCsv)
+    {
+        file << std::endl << "]" << std::endl;
+    }
+    return !file.fail();
+}
 
-    std::vector<float> times(reporting.avgs);
-    for (int j = 0; j < inference.iterations; j++)
+//!
+//! \brief Measure the batch sizes of inference.sweep on the same engine, or search the largest one meeting the p99
+//!        latency target inference.slo, assuming latency grows with the batch size
+//!
+bool doSweep(ICudaEngine& engine, const InferenceOptions& inference, const ReportingOptions& reporting)
+{
+    const int maxBatch = getMaxSweepBatch(engine, inference);
+    std::vector<int> batches;
+    for (int b : inference.sweep)
+    {
+        if (b <= maxBatch)
+        {
+            batches.push_back(b);
+        }
+        else
+        {
+            gLogWarning << "Skipping batch size " << b << ", larger than the engine maximum of " << maxBatch
+                        << std::endl;
+        }
+    }
+    if (batches.empty())
     {
-        float totalGpu{0};  // GPU timer
-        float totalHost{0}; // Host timer
+        gLogError << "No batch size of the sweep can run on this engine" << std::endl;
+        return false;
+    }
+    // Every point builds its own buffers, keep the pinned blocks cached from one point to the next
+    samplesCommon::ArenaUser<samplesCommon::PinnedHostMemory> pinnedArenaUser;
 
-        for (int i = 0; i < reporting.avgs; i++)
+    std::vector<SweepPoint> points;
+    if (inference.slo > 0)
+    {
+        int low{0};
+        int high{static_cast<int>(batches.size()) - 1};
+        int best{-1};
+        while (low <= high)
         {
-            auto tStart = std::chrono::high_resolution_clock::now();
-            cudaEventRecord(start, stream);
-            if (inference.batch)
+            const int mid = low + (high - low) / 2;
+            SweepPoint point;
+            if (!measureSweepPoint(engine, inference, reporting, batches[mid], point))
             {
-                context->enqueue(inference.batch, &buffers[0], stream, nullptr);
+                return false;
+            }
+            points.push_back(point);
+            if (point.p99 <= inference.slo)
+            {
+                best = mid;
+                low = mid + 1;
             }
             else
             {
-                context->enqueueV2(&buffers[0], stream, nullptr);
+                high = mid - 1;
             }
-            cudaEventRecord(end, stream);
-            cudaEventSynchronize(end);
-
-            auto tEnd = std::chrono::high_resolution_clock::now();
-            totalHost += std::chrono::duration<float, std::milli>(tEnd - tStart).count();
-            float ms;
-            cudaEventElapsedTime(&ms, start, end);
-            times[i] = ms;
-            totalGpu += ms;
         }
-
-        totalGpu /= reporting.avgs;
-        totalHost /= reporting.avgs;
-        gLogInfo << "Average over " << reporting.avgs << " runs is " << totalGpu << " ms (host walltime is "
-                 << totalHost << " ms, " << static_cast<int>(reporting.percentile) << "\% percentile time is "
-                 << percentile(reporting.percentile, times) << ")." << std::endl;
+        std::sort(points.begin(), points.end(),
+            [](const SweepPoint& a, const SweepPoint& b) { return a.batch < b.batch; });
+        if (best < 0)
+        {
+            gLogInfo << "No batch size meets the p99 target of " << inference.slo << " ms" << std::endl;
+        }
+        else
+        {
+            gLogInfo << "Largest batch size meeting the p99 target of " << inference.slo << " ms: " << batches[best]
+                     << std::endl;
+        }
     }
-
-    if (reporting.output)
+    else
     {
-        bufferManager.copyOutputToHost();
-        int nbBindings = engine.getNbBindings();
-        for (int i = 0; i < nbBindings; i++)
+        for (int b : batches)
         {
-            if (!engine.bindingIsInput(i))
+            SweepPoint point;
+            if (!measureSweepPoint(engine, inference, reporting, b, point))
             {
-                const char* tensorName = engine.getBindingName(i);
-                gLogInfo << "Dumping output tensor " << tensorName << ":" << std::endl;
-                bufferManager.dumpBuffer(gLogInfo, tensorName);
+                return false;
             }
+            points.push_back(point);
         }
     }
+    gLogVerbose << "Pinned host arena: " << samplesCommon::getPinnedArenaStats() << std::endl;
 
-    if (reporting.profile)
+    if (!reporting.exportSweep.empty() && !exportSweep(reporting.exportSweep, points, inference.slo))
     {
-        gLogInfo << profiler;
+        gLogError << "Failed to write the sweep to " << reporting.exportSweep << std::endl;
+        return false;
     }
-
-    cudaStreamDestroy(stream);
-    cudaEventDestroy(start);
-    cudaEventDestroy(end);
-    context->destroy();
-
     return true;
 }
 
@@ -233,7 +403,7 @@ int main(int argc, char** argv)
         {
             AllOptions::help(std::cout);
             std::cout << "Note: the following options are not fully supported in trtexec:"
-                         " dynamic shapes, multistream/threads, cuda graphs, json logs,"
+                         " dynamic shapes, cuda graphs, json logs,"
                          " and actual data IO" << std::endl;
             return gLogger.reportFail(sampleTest);
         }
@@ -247,7 +417,7 @@ int main(int argc, char** argv)
     {
         AllOptions::help(std::cout);
         std::cout << "Note: the following options are not fully supported in trtexec:"
-                     " dynamic shapes, multistream/threads, cuda graphs, json logs,"
+                     " dynamic shapes, cuda graphs, json logs,"
                      " and actual data IO" << std::endl;
         return gLogger.reportPass(sampleTest);
     }
@@ -296,7 +466,10 @@ int main(int argc, char** argv)
                         "or alternatively run with your own application" << std::endl;
             return gLogger.reportFail(sampleTest);
         }
-        if (!doInference(*engine, options.inference, options.reporting))
+        const bool success = options.inference.sweep.empty()
+            ? doInference(*engine, options.inference, options.reporting)
+            : doSweep(*engine, options.inference, options.reporting);
+        if (!success)
         {
             gLogError << "Inference failure" << std::endl;
             return gLogger.reportFail(sampleTest);
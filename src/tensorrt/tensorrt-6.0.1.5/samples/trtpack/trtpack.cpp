@@ -0,0 +1,344 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "logger.h"
+#include "packedDataset.h"
+#include "sampleOptions.h"
+
+using namespace sample;
+
+namespace
+{
+
+struct PackOptions
+{
+    std::string listFile;
+    std::vector<std::string> dataDirs;
+    std::string output;
+    std::string labelsFile;
+    samplesCommon::PackedDataType type{samplesCommon::PackedDataType::kFLOAT};
+    std::vector<float> mean{0.F, 0.F, 0.F};
+    float scale{1.F};
+    bool bgr{false};
+    int maxImages{0};
+};
+
+void printHelp(std::ostream& out)
+{
+    out << "Usage: trtpack --list=<file> --output=<file> [options]" << std::endl
+        << "  --list=<file>         File with one PPM image name per line" << std::endl
+        << "  --dir=<path>          Directory to search for the list, labels and images, can be repeated"
+        << std::endl
+        << "  --output=<file>       Packed dataset to write" << std::endl
+        << "  --type=fp32|uint8     Storage type of the samples (default = fp32)" << std::endl
+        << "  --mean=<r,g,b>        Per-channel mean subtracted from the pixels, in output channel order"
+        << " (default = 0,0,0)" << std::endl
+        << "  --scale=<f>           Factor applied after the mean is subtracted (default = 1)" << std::endl
+        << "  --bgr                 Store the channels in BGR order" << std::endl
+        << "  --labels=<file>       File with one label per line, in the order of the list" << std::endl
+        << "  --maxImages=<N>       Pack at most N images (default = all)" << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, PackOptions& options)
+{
+    Arguments args = argsToArgumentsMap(argc, argv);
+    bool help{false};
+    checkEraseOption(args, "--help", help);
+    checkEraseOption(args, "-h", help);
+    if (help)
+    {
+        return false;
+    }
+
+    try
+    {
+        checkEraseOption(args, "--list", options.listFile);
+        checkEraseRepeatedOption(args, "--dir", options.dataDirs);
+        checkEraseOption(args, "--output", options.output);
+        checkEraseOption(args, "--labels", options.labelsFile);
+        checkEraseOption(args, "--scale", options.scale);
+        checkEraseOption(args, "--bgr", options.bgr);
+        checkEraseOption(args, "--maxImages", options.maxImages);
+
+        std::string type;
+        if (checkEraseOption(args, "--type", type))
+        {
+            if (type == "uint8")
+            {
+                options.type = samplesCommon::PackedDataType::kUINT8;
+            }
+            else if (type != "fp32")
+            {
+                throw std::invalid_argument("Invalid type " + type);
+            }
+        }
+
+        std::string mean;
+        if (checkEraseOption(args, "--mean", mean))
+        {
+            std::vector<std::string> values{splitToStringVec(mean, ',')};
+            if (values.size() != 3)
+            {
+                throw std::invalid_argument("Invalid mean " + mean);
+            }
+            std::transform(values.begin(), values.end(), options.mean.begin(), stringToValue<float>);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << e.what() << std::endl;
+        return false;
+    }
+
+    if (!args.empty())
+    {
+        for (const auto& arg : args)
+        {
+            gLogError << "Unknown option: " << arg.first << " " << arg.second << std::endl;
+        }
+        return false;
+    }
+    if (options.listFile.empty() || options.output.empty())
+    {
+        gLogError << "Both --list and --output are required" << std::endl;
+        return false;
+    }
+    if (options.dataDirs.empty())
+    {
+        options.dataDirs.emplace_back("./");
+    }
+    return true;
+}
+
+std::vector<std::string> readLines(const std::string& fileName)
+{
+    std::vector<std::string> lines;
+    std::ifstream file(fileName);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (!line.empty())
+        {
+            lines.emplace_back(line);
+        }
+    }
+    return lines;
+}
+
+//!
+//! \brief Read one label per non-empty line, reporting the first line that is not a number.
+//!
+bool readLabels(const std::string& fileName, std::vector<float>& labels)
+{
+    std::ifstream file(fileName);
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber)
+    {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+        {
+            continue;
+        }
+        const char* begin = line.c_str() + first;
+        char* end{nullptr};
+        const float label = std::strtof(begin, &end);
+        if (end == begin || line.find_first_not_of(" \t\r", end - line.c_str()) != std::string::npos
+            || !std::isfinite(label))
+        {
+            gLogError << fileName << ":" << lineNumber << ": invalid label \"" << line << "\"" << std::endl;
+            return false;
+        }
+        labels.push_back(label);
+    }
+    return true;
+}
+
+//!
+//! \brief Read the header of a binary PPM image, leaving the stream at the first pixel.
+//!
+bool readPPMHeader(std::ifstream& file, int& w, int& h)
+{
+    std::string magic;
+    int max{0};
+    file >> magic >> w >> h >> max;
+    file.seekg(1, file.cur);
+    return file && magic == "P6" && w > 0 && h > 0 && max <= 255;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    PackOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printHelp(std::cout);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> images = readLines(locateFile(options.listFile, options.dataDirs));
+    if (options.maxImages > 0 && static_cast<int>(images.size()) > options.maxImages)
+    {
+        images.resize(options.maxImages);
+    }
+    if (images.empty())
+    {
+        gLogError << "No images listed in " << options.listFile << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> labels;
+    if (!options.labelsFile.empty())
+    {
+        if (!readLabels(locateFile(options.labelsFile, options.dataDirs), labels))
+        {
+            return EXIT_FAILURE;
+        }
+        if (labels.size() < images.size())
+        {
+            gLogError << options.labelsFile << " has " << labels.size() << " labels for " << images.size()
+                      << " images" << std::endl;
+            return EXIT_FAILURE;
+        }
+        labels.resize(images.size());
+    }
+
+    // All the samples must have the dimensions of the first image.
+    int w{0}, h{0};
+    {
+        std::ifstream file(locateFile(images[0], options.dataDirs), std::ios::binary);
+        if (!readPPMHeader(file, w, h))
+        {
+            gLogError << images[0] << " is not a binary PPM image" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    const int32_t dims[3]{3, h, w};
+    const int64_t channelSize = static_cast<int64_t>(h) * w;
+
+    // uint8 samples keep the raw pixels, the mean and scale move to the per-channel scale and bias of the file.
+    const bool isFloat = options.type == samplesCommon::PackedDataType::kFLOAT;
+    std::vector<float> scales(3, 1.F);
+    std::vector<float> biases(3, 0.F);
+    if (!isFloat)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            scales[c] = options.scale;
+            biases[c] = -options.scale * options.mean[c];
+        }
+    }
+
+    samplesCommon::PackedDatasetWriter writer;
+    if (!writer.open(options.output, options.type, dims, images.size(), scales, biases, labels))
+    {
+        gLogError << "Cannot write " << options.output << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint8_t> pixels(3 * channelSize);
+    std::vector<uint8_t> bytes(3 * channelSize);
+    std::vector<float> floats(3 * channelSize);
+    for (const auto& image : images)
+    {
+        std::ifstream file(locateFile(image, options.dataDirs), std::ios::binary);
+        int imageW{0}, imageH{0};
+        if (!readPPMHeader(file, imageW, imageH) || imageW != w || imageH != h
+            || !file.read(reinterpret_cast<char*>(pixels.data()), pixels.size()))
+        {
+            gLogError << image << " is not a " << w << "x" << h << " binary PPM image" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // HWC RGB to CHW, in BGR order if requested.
+        for (int c = 0; c < 3; ++c)
+        {
+            const int src = options.bgr ? 2 - c : c;
+            for (int64_t j = 0; j < channelSize; ++j)
+            {
+                const uint8_t p = pixels[j * 3 + src];
+                if (isFloat)
+                {
+                    floats[c * channelSize + j] = options.scale * (p - options.mean[c]);
+                }
+                else
+                {
+                    bytes[c * channelSize + j] = p;
+                }
+            }
+        }
+        if (!writer.addSample(isFloat ? static_cast<const void*>(floats.data()) : bytes.data()))
+        {
+            gLogError << "Cannot write " << options.output << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!writer.close())
+    {
+        gLogError << "Cannot write " << options.output << std::endl;
+        return EXIT_FAILURE;
+    }
+    gLogInfo << "Packed " << images.size() << " images of " << dims[0] << "x" << dims[1] << "x" << dims[2]
+             << " into " << options.output << std::endl;
+    return EXIT_SUCCESS;
+}
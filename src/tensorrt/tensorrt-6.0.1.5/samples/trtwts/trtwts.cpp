@@ -0,0 +1,156 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <iostream>
+#include <string>
+
+#include "logger.h"
+#include "sampleOptions.h"
+#include "weightFile.h"
+
+using namespace sample;
+
+namespace
+{
+
+struct ConvertOptions
+{
+    std::string input;
+    std::string output;
+    bool verbose{false};
+};
+
+void printHelp(std::ostream& out)
+{
+    out << "Usage: trtwts --input=<file> --output=<file> [--verbose]" << std::endl
+        << "  --input=<file>    Weight file written by dumpTFWts.py (.wts or .wts2) or a weight container" << std::endl
+        << "  --output=<file>   Weight container to write, can be the input file" << std::endl
+        << "  --verbose         Print the name, type and shape of every blob" << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, ConvertOptions& options)
+{
+    Arguments args = argsToArgumentsMap(argc, argv);
+    bool help{false};
+    checkEraseOption(args, "--help", help);
+    checkEraseOption(args, "-h", help);
+    if (help)
+    {
+        return false;
+    }
+
+    try
+    {
+        checkEraseOption(args, "--input", options.input);
+        checkEraseOption(args, "--output", options.output);
+        checkEraseOption(args, "--verbose", options.verbose);
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << e.what() << std::endl;
+        return false;
+    }
+
+    if (!args.empty())
+    {
+        for (const auto& arg : args)
+        {
+            gLogError << "Unknown option: " << arg.first << " " << arg.second << std::endl;
+        }
+        return false;
+    }
+    if (options.input.empty() || options.output.empty())
+    {
+        gLogError << "Both --input and --output are required" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ConvertOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printHelp(std::cout);
+        return EXIT_FAILURE;
+    }
+
+    samplesCommon::WeightFile input;
+    std::string err;
+    if (!input.open(options.input, err))
+    {
+        gLogError << err << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    samplesCommon::WeightFileWriter writer;
+    int64_t bytes{0};
+    for (const auto& b : input.getBlobs())
+    {
+        const nvinfer1::Weights& w = b.second.weights;
+        if (options.verbose)
+        {
+            gLogInfo << b.first << " " << static_cast<int>(w.type) << " " << b.second.shape << std::endl;
+        }
+        writer.add(b.first, w, b.second.shape);
+        bytes += w.count * samplesCommon::getWeightTypeSize(w.type);
+    }
+
+    if (!writer.write(options.output, err))
+    {
+        gLogError << err << std::endl;
+        return EXIT_FAILURE;
+    }
+    gLogInfo << "Wrote " << input.getBlobs().size() << " blobs, " << bytes << " bytes of weights, to " << options.output
+             << std::endl;
+    return EXIT_SUCCESS;
+}
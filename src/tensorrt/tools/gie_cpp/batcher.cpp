@@ -0,0 +1,112 @@
+#include "batcher.hpp"
+#include <algorithm>
+#include <cstring>
+
+DynamicBatcher::DynamicBatcher(IBatchExecutor *executor, int maxBatch, std::chrono::microseconds maxDelay, int nbWorkers)
+	: m_executor(executor)
+	, m_maxBatch(maxBatch)
+	, m_maxDelay(maxDelay)
+	, m_inputVolume(executor->inputVolume())
+	, m_outputVolume(executor->outputVolume())
+	, m_stop(false)
+{
+	if (m_maxBatch <= 0 || m_maxBatch > m_executor->maxBatchSize())
+		m_maxBatch = m_executor->maxBatchSize();
+	m_maxBatch = std::max(m_maxBatch, 1);
+	m_stats.batches = 0;
+	m_stats.frames = 0;
+
+	for (int i = 0; i < std::max(nbWorkers, 1); i++)
+		m_workers.emplace_back(&DynamicBatcher::worker, this);
+}
+
+DynamicBatcher::~DynamicBatcher()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_cv.notify_all();
+	for (auto &t : m_workers)
+		t.join();
+}
+
+std::future<bool> DynamicBatcher::submit(const float *input, float *output)
+{
+	Request r;
+	r.input = input;
+	r.output = output;
+	r.arrival = std::chrono::steady_clock::now();
+	std::future<bool> result = r.done.get_future();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_stop) {
+		lock.unlock();
+		r.done.set_value(false);
+		return result;
+	}
+	m_queue.push_back(std::move(r));
+	lock.unlock();
+	/* every worker may be waiting either for work or for its batch to fill */
+	m_cv.notify_all();
+	return result;
+}
+
+BatcherStats DynamicBatcher::getStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+/* Blocks until a batch is due; returns false once stopped and drained */
+bool DynamicBatcher::nextBatch(std::vector<Request>& batch)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;) {
+		m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+		if (m_queue.empty())
+			return false;
+
+		/* On stop, flush whatever is queued without waiting for the deadline */
+		while (!m_stop && !m_queue.empty() && (int)m_queue.size() < m_maxBatch) {
+			/* another worker may have taken the front while we waited, so the deadline is that of the current front */
+			const auto deadline = m_queue.front().arrival + m_maxDelay;
+			if (std::chrono::steady_clock::now() >= deadline)
+				break;
+			m_cv.wait_until(lock, deadline);
+		}
+		if (m_queue.empty())
+			continue;
+
+		const size_t n = std::min(m_queue.size(), (size_t)m_maxBatch);
+		for (size_t i = 0; i < n; i++) {
+			batch.push_back(std::move(m_queue.front()));
+			m_queue.pop_front();
+		}
+		m_stats.batches++;
+		m_stats.frames += n;
+		return true;
+	}
+}
+
+void DynamicBatcher::worker()
+{
+	std::vector<float> input(m_maxBatch * m_inputVolume);
+	std::vector<float> output(m_maxBatch * m_outputVolume);
+	std::vector<Request> batch;
+	batch.reserve(m_maxBatch);
+
+	while (nextBatch(batch)) {
+		const int n = (int)batch.size();
+		for (int i = 0; i < n; i++)
+			memcpy(&input[i * m_inputVolume], batch[i].input, m_inputVolume * sizeof(float));
+
+		const bool ok = m_executor->inferBatch(input.data(), output.data(), n);
+		for (int i = 0; i < n; i++) {
+			if (ok)
+				memcpy(batch[i].output, &output[i * m_outputVolume], m_outputVolume * sizeof(float));
+			batch[i].done.set_value(ok);
+		}
+		batch.clear();
+	}
+}
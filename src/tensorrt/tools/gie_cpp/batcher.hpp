@@ -0,0 +1,88 @@
+#ifndef __BATCHER_HPP__
+#define __BATCHER_HPP__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Anything that can run a batch of frames packed back to back in host memory.
+ * GieModel implements it on top of the engine; tests can implement it on the CPU.
+ */
+class IBatchExecutor
+{
+public:
+	virtual ~IBatchExecutor() {}
+
+	virtual int maxBatchSize() const = 0;
+	virtual size_t inputVolume() const = 0;	/* floats per input frame */
+	virtual size_t outputVolume() const = 0;	/* floats per output frame */
+
+	/* input holds batchSize * inputVolume() floats, output receives batchSize * outputVolume() */
+	virtual bool inferBatch(const float *input, float *output, int batchSize) = 0;
+};
+
+struct BatcherStats
+{
+	size_t batches;
+	size_t frames;
+};
+
+/*
+ * Coalesces frames submitted from several threads into batched inferences.
+ * A batch is dispatched as soon as maxBatch frames are queued, or when the oldest
+ * queued frame has waited maxDelay, whichever comes first. Each worker thread runs
+ * one batch at a time, so the executor must tolerate nbWorkers concurrent calls.
+ */
+class DynamicBatcher
+{
+public:
+	/* maxBatch <= 0 uses the executor's max batch size */
+	DynamicBatcher(IBatchExecutor *executor, int maxBatch, std::chrono::microseconds maxDelay, int nbWorkers = 1);
+
+	/* Finishes every queued frame before returning */
+	~DynamicBatcher();
+
+	DynamicBatcher(const DynamicBatcher&) = delete;
+	DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+
+	/*
+	 * Queues one frame. input must stay valid and output must stay writable until the
+	 * future is ready; the future yields false if the batch failed or the batcher stopped.
+	 */
+	std::future<bool> submit(const float *input, float *output);
+
+	BatcherStats getStats();
+
+private:
+	struct Request
+	{
+		const float *input;
+		float *output;
+		std::chrono::steady_clock::time_point arrival;
+		std::promise<bool> done;
+	};
+
+	void worker();
+	bool nextBatch(std::vector<Request>& batch);
+
+	IBatchExecutor *m_executor;
+	int m_maxBatch;
+	std::chrono::microseconds m_maxDelay;
+	size_t m_inputVolume;
+	size_t m_outputVolume;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::deque<Request> m_queue;
+	bool m_stop;
+	BatcherStats m_stats;
+	std::vector<std::thread> m_workers;
+};
+
+#endif // __BATCHER_HPP__
@@ -1,6 +1,8 @@
 #include "common.h"
 //#include "LocalPrint.hpp"
 #include "gie.hpp"
+// From samples/common of the TensorRT release, which must be on the include path
+#include "mappedFile.h"
 //#include <Checks.hpp>
 //# define CHECK (X)
 //using namespace cv;
@@ -19,26 +21,71 @@ char slot_model_path[] = "./model/gie/slot_model.engine";
 // char slot_model_path[] = "./model/apa/gie/slot_classifier_tf.engine";
 
 
+// Longest a submitted frame waits for others to join its batch
+#define GIE_BATCH_MAX_DELAY_US 1000
+// Execution contexts per model, i.e. inferences that can be in flight at once
+#define GIE_NB_SLOTS 2
+
 GieModel *pModel;
 GieModel *slot_pModel;
+DynamicBatcher *pBatcher;
+DynamicBatcher *slot_pBatcher;
+
+static DynamicBatcher* createBatcher(GieModel *model)
+{
+    if (!model->isLoaded())
+        return nullptr;
+    return new DynamicBatcher(model, model->para.batchSize, std::chrono::microseconds(GIE_BATCH_MAX_DELAY_US),
+        model->getNbSlots());
+}
+
+#ifdef GPU
+// Runs one frame on a pooled slot. The result stays valid until the calling thread's next call.
+static float* inferFrame(GieModel *model, const float* hostInput)
+{
+    static thread_local std::vector<float> hostOutput;
+    hostOutput.resize(model->outputVolume());
+    if (!model->inferBatch(hostInput, hostOutput.data(), 1))
+        return nullptr;
+    return hostOutput.data();
+}
+#endif
+
+static void* submitFrame(DynamicBatcher *batcher, const float* hostInput, float* hostOutput)
+{
+    if (!batcher) {
+        std::cerr << "Gie Model not load!" << std::endl;
+        return nullptr;
+    }
+    return new std::future<bool>(batcher->submit(hostInput, hostOutput));
+}
+
 extern "C" void apaCaffeInit(){
     struct ModelPara model_parameter;
     model_parameter.engineNr = "./model/apa/gie/ps_parking3.engine";
     printf("init gie engine:%s;\n", model_parameter.engineNr);
-    pModel = new GieModel(&model_parameter);
+    pModel = new GieModel(&model_parameter, GIE_NB_SLOTS);
+    pBatcher = createBatcher(pModel);
 }
 
 extern "C" void apaCaffeDeinit(void)
 {
+    delete pBatcher;
+    pBatcher = nullptr;
     delete pModel;
 }
 
 extern "C" float* ps_parking_infer(float* hostInput){
 #ifdef GPU
-    cudaMemcpy(pModel->m_deviceInputData, hostInput, 48 * 192 * sizeof(float), cudaMemcpyHostToDevice);
-#endif
+    return inferFrame(pModel, hostInput);
+#else
     pModel->inferSingleFrame();
     return pModel->m_hostOutputData[0];
+#endif
+}
+
+extern "C" void* ps_parking_submit(const float* hostInput, float* hostOutput){
+    return submitFrame(pBatcher, hostInput, hostOutput);
 }
 
 // >>>>>>> Slot TensorFlow Engine >>>>>>>
@@ -46,27 +93,48 @@ extern "C" void slotTfInit(){
     struct ModelPara model_parameter;
     model_parameter.engineNr = slot_model_path;
     printf("Slot Classifier init gie engine: %s;\n", model_parameter.engineNr);
-    slot_pModel = new GieModel(&model_parameter);
+    slot_pModel = new GieModel(&model_parameter, GIE_NB_SLOTS);
+    slot_pBatcher = createBatcher(slot_pModel);
 }
 
 extern "C" void slotTfDelete(void)
 {
+    delete slot_pBatcher;
+    slot_pBatcher = nullptr;
     delete slot_pModel;
 }
 
 extern "C" float* slotTfInfer(float* hostInput){
 #ifdef GPU
-    cudaMemcpy(slot_pModel->m_deviceInputData, hostInput, SLOT_TF_IN_C * SLOT_TF_IN_W * SLOT_TF_IN_H * sizeof(float), cudaMemcpyHostToDevice);
-#endif
+    return inferFrame(slot_pModel, hostInput);
+#else
     slot_pModel->inferSingleFrame();
     return slot_pModel->m_hostOutputData[0];
+#endif
+}
+
+extern "C" void* slotTfSubmit(const float* hostInput, float* hostOutput){
+    return submitFrame(slot_pBatcher, hostInput, hostOutput);
 }
 // <<<<<<< Slot TensorFlow Engine <<<<<<<
 
+extern "C" int gieWait(void* ticket)
+{
+    if (!ticket)
+        return -1;
+    std::future<bool> *result = static_cast<std::future<bool>*>(ticket);
+    const bool ok = result->get();
+    delete result;
+    return ok ? 0 : -1;
+}
+
 
-GieModel::GieModel(struct ModelPara *p)
+GieModel::GieModel(struct ModelPara *p, int nbSlots)
 {
 	m_success = false;
+	m_nbSlots = 0;
+	m_freeHead = 0;
+	m_slotWaiters = 0;
 	if (!p) {
 		std::cerr << "GieModel must have input to initialize;" << std::endl;
 		return;
@@ -107,6 +175,11 @@ GieModel::GieModel(struct ModelPara *p)
 
 	CHECK(cudaStreamCreate(&stream));
 
+	if (!createSlots(nbSlots)) {
+		std::cerr << "inference slot creation fail" << std::endl;
+		return;
+	}
+
 	m_success = true;
 	//UserPrintInfo("creat GieModel success\n");
 
@@ -117,6 +190,8 @@ GieModel::GieModel(struct ModelPara *p)
 
 GieModel::~GieModel(void)
 {
+	destroySlots();
+
 	if (m_hostOutputData[0])
 		free(m_hostOutputData[0]);
 
@@ -147,6 +222,126 @@ bool GieModel::inferSingleFrame(void)
 	return true;
 }
 
+bool GieModel::inferBatch(const float *hostInput, float *hostOutput, int batchSize)
+{
+	if (false == isLoaded()) {
+		std::cerr << "Gie Model not load!" << std::endl;
+		return false;
+	}
+	if (batchSize <= 0 || batchSize > para.batchSize) {
+		std::cerr << "batch size " << batchSize << " out of range [1, " << para.batchSize << "]" << std::endl;
+		return false;
+	}
+
+	InferSlot *slot = acquireSlot();
+	const size_t inputBytes = batchSize * inputVolume() * sizeof(float);
+	const size_t outputBytes = batchSize * outputVolume() * sizeof(float);
+
+	// only the frames present are copied and enqueued, not the whole build-time batch
+	CHECK(cudaMemcpyAsync(slot->buffers[para.inputIndex], hostInput, inputBytes, cudaMemcpyHostToDevice, slot->stream));
+	bool ok = slot->context->enqueue(batchSize, slot->buffers, slot->stream, nullptr);
+	if (ok)
+		CHECK(cudaMemcpyAsync(slot->hostOutput, slot->buffers[para.outputIndex], outputBytes, cudaMemcpyDeviceToHost, slot->stream));
+	CHECK(cudaStreamSynchronize(slot->stream));
+	if (ok)
+		memcpy(hostOutput, slot->hostOutput, outputBytes);
+
+	releaseSlot(slot);
+	return ok;
+}
+
+bool GieModel::createSlots(int nbSlots)
+{
+	m_nbSlots = nbSlots < 1 ? 1 : nbSlots;
+	m_slots.reset(new InferSlot[m_nbSlots]);
+	for (int i = 0; i < m_nbSlots; i++) {
+		InferSlot &slot = m_slots[i];
+		slot.context = nullptr;
+		slot.buffers[0] = slot.buffers[1] = nullptr;
+		slot.hostOutput = nullptr;
+		slot.stream = nullptr;
+	}
+
+	for (int i = 0; i < m_nbSlots; i++) {
+		InferSlot &slot = m_slots[i];
+		slot.context = engine->createExecutionContext();
+		if (!slot.context)
+			return false;
+		CHECK(cudaMalloc(&slot.buffers[para.inputIndex], (size_t)m_networkInputSize));
+		CHECK(cudaMalloc(&slot.buffers[para.outputIndex], (size_t)m_networkOutputSize[0]));
+		CHECK(cudaMallocHost((void**)&slot.hostOutput, (size_t)m_networkOutputSize[0]));
+		CHECK(cudaStreamCreate(&slot.stream));
+		// chain every slot into the free-list
+		slot.next = (i + 1 < m_nbSlots) ? (uint32_t)(i + 2) : 0;
+	}
+	m_freeHead = 1;
+	return true;
+}
+
+void GieModel::destroySlots()
+{
+	for (int i = 0; i < m_nbSlots; i++) {
+		InferSlot &slot = m_slots[i];
+		if (slot.stream)
+			cudaStreamDestroy(slot.stream);
+		if (slot.hostOutput)
+			cudaFreeHost(slot.hostOutput);
+		if (slot.buffers[0])
+			cudaFree(slot.buffers[0]);
+		if (slot.buffers[1])
+			cudaFree(slot.buffers[1]);
+		if (slot.context)
+			slot.context->destroy();
+	}
+	m_slots.reset();
+	m_nbSlots = 0;
+	m_freeHead = 0;
+}
+
+InferSlot* GieModel::tryAcquireSlot()
+{
+	uint64_t head = m_freeHead.load();
+	while ((uint32_t)head != 0) {
+		InferSlot *slot = &m_slots[(uint32_t)head - 1];
+		// the tag changes on every successful pop/push, so a stale next fails the exchange
+		const uint64_t newHead = ((head >> 32) + 1) << 32 | slot->next.load(std::memory_order_relaxed);
+		if (m_freeHead.compare_exchange_weak(head, newHead))
+			return slot;
+	}
+	return nullptr;
+}
+
+InferSlot* GieModel::acquireSlot()
+{
+	InferSlot *slot = tryAcquireSlot();
+	if (slot)
+		return slot;
+
+	// every slot is in flight: sleep until releaseSlot hands one back
+	std::unique_lock<std::mutex> lock(m_slotMutex);
+	m_slotWaiters++;
+	m_slotFreed.wait(lock, [this, &slot] { return (slot = tryAcquireSlot()) != nullptr; });
+	m_slotWaiters--;
+	return slot;
+}
+
+void GieModel::releaseSlot(InferSlot *slot)
+{
+	const uint32_t index = (uint32_t)(slot - m_slots.get()) + 1;
+	uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+	do {
+		slot->next.store((uint32_t)head, std::memory_order_relaxed);
+	} while (!m_freeHead.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | index,
+		std::memory_order_seq_cst, std::memory_order_relaxed));
+
+	// A waiter registers before its last look at the free-list, and both sides are sequentially
+	// consistent, so either it sees this slot or we see it waiting
+	if (m_slotWaiters.load() > 0) {
+		std::lock_guard<std::mutex> lock(m_slotMutex);
+		m_slotFreed.notify_one();
+	}
+}
+
 void GieModel::printEngineInfo()
 {
 	const char *dataTypeStr[] =
@@ -211,21 +406,18 @@ ICudaEngine* GieModel::createEngine(std::string engineFile)
 {
 	ICudaEngine *engine;
 	if (!engineFile.empty()) {// GIE engine exist?
-		char *gieModelStream{ nullptr };
-		size_t size{ 0 };
-		std::ifstream file(engineFile.c_str(), std::ios::binary);
-		if (file.good()) { /* get engine file */
-			file.seekg(0, file.end);
-			size = file.tellg(); /* get file size first */
-			file.seekg(0, file.beg);
-			gieModelStream = new char[size];
-			assert(gieModelStream);
- 			file.read(gieModelStream, size); /* read Model file into buffer */
- 			file.close();
- 		}
+		auto start = std::chrono::high_resolution_clock::now();
+		// deserialize from the mapped plan instead of a heap copy, the pages are released with the mapping
+		samplesCommon::MappedFile plan;
+		if (!plan.open(engineFile, samplesCommon::MappedFile::Advice::kSEQUENTIAL) || plan.size() == 0) {
+			std::cerr << "Unable to map engine file " << engineFile << std::endl;
+			return nullptr;
+		}
 		IRuntime* infer = createInferRuntime(gLogger);
-		engine = infer->deserializeCudaEngine(gieModelStream, size, nullptr); //
-		if (gieModelStream) delete[] gieModelStream;
+		engine = infer->deserializeCudaEngine(plan.data(), plan.size(), nullptr);
+		auto end = std::chrono::high_resolution_clock::now();
+		printf("engine %s: %zu MB deserialized in %.1f ms;\n", engineFile.c_str(), plan.size() >> 20,
+			std::chrono::duration<double, std::milli>(end - start).count());
 		return engine;
 	}
 	else {
@@ -9,11 +9,16 @@
 #include <cudnn.h>
 #include <cublas_v2.h>
 #include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <cstdint>
 #include <cstring>
 #include "NvCaffeParser.h"
 #include "NvInferPlugin.h"
 #include "NvInfer.h"
 #include "ModelPara.hpp"
+#include "batcher.hpp"
 //#include <dw/dnn/DNN.h>
 
 using namespace nvinfer1;
@@ -22,11 +27,22 @@ using namespace plugin;
 
 #define OUTPUT_DIM 1
 
-class GieModel
+/* One independent in-flight inference: everything a thread needs to run the engine alone */
+struct InferSlot
+{
+	IExecutionContext *context;
+	cudaStream_t stream;
+	void *buffers[2];
+	float *hostOutput;	/* pinned, one full batch of output */
+	std::atomic<uint32_t> next;	/* free-list link, index + 1 or 0 */
+};
+
+class GieModel : public IBatchExecutor
 {
 public:
 
-    GieModel(struct ModelPara*);
+    /* nbSlots contexts are created for acquireSlot(), on top of the one used by inferSingleFrame */
+    GieModel(struct ModelPara*, int nbSlots = 1);
 
     ~GieModel() ;
 
@@ -38,8 +54,18 @@ public:
     void reset();
     //bool inferSingleFrame(const dwImageCUDA *const frame, bool doClustering);
 	bool inferSingleFrame(void);
+	/* Runs batchSize frames from pageable host memory on a borrowed slot; thread-safe */
+	bool inferBatch(const float *hostInput, float *hostOutput, int batchSize) override;
+	int maxBatchSize() const override { return para.batchSize; }
+	size_t inputVolume() const override { return (size_t)para.inC * para.inH * para.inW; }
+	size_t outputVolume() const override { return (size_t)para.outC * para.outH * para.outW; }
 	ICudaEngine* createEngine(std::string engineFile);
 
+	/* Lock-free borrow/return of a pool slot; acquireSlot sleeps until one is free */
+	InferSlot* acquireSlot();
+	void releaseSlot(InferSlot *slot);
+	int getNbSlots() const { return m_nbSlots; }
+
 	float *m_hostOutputData[OUTPUT_DIM];
 	float *m_deviceInputData;
 	struct ModelPara para;
@@ -59,6 +85,16 @@ private:
 	IExecutionContext *context;
 	void *buffers[2];
 	cudaStream_t stream;
+
+	int m_nbSlots;
+	std::unique_ptr<InferSlot[]> m_slots;
+	std::atomic<uint64_t> m_freeHead;	/* (ABA tag << 32) | (slot index + 1) */
+	std::mutex m_slotMutex;	/* only taken when the free-list is empty */
+	std::condition_variable m_slotFreed;
+	std::atomic<int> m_slotWaiters;
+	InferSlot* tryAcquireSlot();
+	bool createSlots(int nbSlots);
+	void destroySlots();
 	//dwDataConditionerParams *pDataCondiPara;
 	//dwDataConditionerHandle_t m_dataConditionerHandle;
 	void printEngineInfo();
@@ -66,4 +102,14 @@ private:
 	int initDataCondi(void);
 };
 
+/*
+ * Asynchronous entry points. Concurrent submissions are coalesced into one batched
+ * enqueue of up to the engine's max batch size, waiting at most GIE_BATCH_MAX_DELAY_US
+ * for a batch to fill. hostInput and hostOutput must stay valid until gieWait returns.
+ */
+extern "C" void* ps_parking_submit(const float* hostInput, float* hostOutput);
+extern "C" void* slotTfSubmit(const float* hostInput, float* hostOutput);
+/* Blocks until the submitted frame is done and releases the ticket; returns 0 on success */
+extern "C" int gieWait(void* ticket);
+
 #endif // __GIE_HPP__
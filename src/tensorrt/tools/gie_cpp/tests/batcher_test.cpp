@@ -0,0 +1,197 @@
+#include "../batcher.hpp"
+#include <cstdio>
+#include <vector>
+
+#define CHECK_TRUE(X) do { \
+	if (!(X)) { \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #X); \
+		return false; \
+	} \
+} while (0)
+
+typedef std::chrono::steady_clock Clock;
+
+/* Sums the two floats of each frame, and records the size of every batch */
+class StubExecutor : public IBatchExecutor
+{
+public:
+	StubExecutor(int maxBatch, bool fail = false) : m_maxBatch(maxBatch), m_fail(fail) {}
+
+	int maxBatchSize() const { return m_maxBatch; }
+	size_t inputVolume() const { return 2; }
+	size_t outputVolume() const { return 1; }
+
+	bool inferBatch(const float *input, float *output, int batchSize)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_batches.push_back(batchSize);
+		}
+		for (int i = 0; i < batchSize; i++)
+			output[i] = input[2 * i] + input[2 * i + 1];
+		return !m_fail;
+	}
+
+	std::vector<int> batches()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_batches;
+	}
+
+private:
+	int m_maxBatch;
+	bool m_fail;
+	std::mutex m_mutex;
+	std::vector<int> m_batches;
+};
+
+struct Frame
+{
+	float input[2];
+	float output;
+	std::future<bool> done;
+};
+
+static void submit(DynamicBatcher& batcher, Frame& frame, float value)
+{
+	frame.input[0] = value;
+	frame.input[1] = 1.f;
+	frame.output = -1.f;
+	frame.done = batcher.submit(frame.input, &frame.output);
+}
+
+static bool ready(Frame& frame, std::chrono::milliseconds timeout)
+{
+	return frame.done.wait_for(timeout) == std::future_status::ready;
+}
+
+static double msSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* Frames that do not fill a batch wait for the deadline of the oldest, then run together */
+static bool testCoalescing()
+{
+	StubExecutor executor(8);
+	DynamicBatcher batcher(&executor, 8, std::chrono::milliseconds(100));
+	Frame frames[3];
+	const auto start = Clock::now();
+	for (int i = 0; i < 3; i++)
+		submit(batcher, frames[i], (float)i);
+
+	CHECK_TRUE(!ready(frames[0], std::chrono::milliseconds(50)));
+	for (int i = 0; i < 3; i++) {
+		CHECK_TRUE(ready(frames[i], std::chrono::milliseconds(1000)));
+		CHECK_TRUE(frames[i].done.get());
+		CHECK_TRUE(frames[i].output == i + 1.f);
+	}
+	CHECK_TRUE(msSince(start) >= 100.);
+	CHECK_TRUE(executor.batches() == std::vector<int>({3}));
+	return true;
+}
+
+/* A full batch does not wait for the deadline */
+static bool testFullBatch()
+{
+	StubExecutor executor(4);
+	DynamicBatcher batcher(&executor, 4, std::chrono::seconds(10));
+	Frame frames[4];
+	for (int i = 0; i < 4; i++)
+		submit(batcher, frames[i], (float)i);
+
+	for (int i = 0; i < 4; i++) {
+		CHECK_TRUE(ready(frames[i], std::chrono::milliseconds(1000)));
+		CHECK_TRUE(frames[i].done.get());
+		CHECK_TRUE(frames[i].output == i + 1.f);
+	}
+	CHECK_TRUE(executor.batches() == std::vector<int>({4}));
+	BatcherStats stats = batcher.getStats();
+	CHECK_TRUE(stats.batches == 1 && stats.frames == 4);
+	return true;
+}
+
+/* A failed batch fails the future of every frame in it, and leaves the outputs alone */
+static bool testFailure()
+{
+	StubExecutor executor(3, true);
+	DynamicBatcher batcher(&executor, 3, std::chrono::seconds(10));
+	Frame frames[3];
+	for (int i = 0; i < 3; i++)
+		submit(batcher, frames[i], (float)i);
+
+	for (int i = 0; i < 3; i++) {
+		CHECK_TRUE(ready(frames[i], std::chrono::milliseconds(1000)));
+		CHECK_TRUE(!frames[i].done.get());
+		CHECK_TRUE(frames[i].output == -1.f);
+	}
+	return true;
+}
+
+/* The destructor runs the queued frames at once rather than at their deadline */
+static bool testDrain()
+{
+	StubExecutor executor(8);
+	Frame frames[3];
+	const auto start = Clock::now();
+	{
+		DynamicBatcher batcher(&executor, 8, std::chrono::seconds(10), 2);
+		for (int i = 0; i < 3; i++)
+			submit(batcher, frames[i], (float)i);
+	}
+	CHECK_TRUE(msSince(start) < 1000.);
+	for (int i = 0; i < 3; i++) {
+		CHECK_TRUE(ready(frames[i], std::chrono::milliseconds(0)));
+		CHECK_TRUE(frames[i].done.get());
+		CHECK_TRUE(frames[i].output == i + 1.f);
+	}
+	return true;
+}
+
+/*
+ * With several workers, a worker still waiting when another takes the front of the queue
+ * must wait for the deadline of the new front, not the one it started waiting for.
+ */
+static bool testDeadlineOfNewFront()
+{
+	StubExecutor executor(2);
+	DynamicBatcher batcher(&executor, 2, std::chrono::milliseconds(200), 2);
+	Frame frames[4];
+	const auto start = Clock::now();
+	submit(batcher, frames[0], 0.f);
+	std::this_thread::sleep_until(start + std::chrono::milliseconds(100));
+	/* frames 0 and 1 fill a batch, frame 2 is due at 300 ms */
+	submit(batcher, frames[1], 1.f);
+	submit(batcher, frames[2], 2.f);
+	std::this_thread::sleep_until(start + std::chrono::milliseconds(250));
+	/* past the deadline of frame 0, so frame 2 must still be queued to join frame 3 */
+	submit(batcher, frames[3], 3.f);
+
+	for (int i = 0; i < 4; i++) {
+		CHECK_TRUE(ready(frames[i], std::chrono::milliseconds(1000)));
+		CHECK_TRUE(frames[i].done.get());
+	}
+	CHECK_TRUE(executor.batches() == std::vector<int>({2, 2}));
+	return true;
+}
+
+int main()
+{
+	struct {
+		const char *name;
+		bool (*run)();
+	} tests[] = {
+		{"coalescing", testCoalescing},
+		{"full batch", testFullBatch},
+		{"failure", testFailure},
+		{"drain", testDrain},
+		{"deadline of new front", testDeadlineOfNewFront},
+	};
+	int failed = 0;
+	for (auto &test : tests) {
+		const bool ok = test.run();
+		printf("%s %s\n", ok ? "PASSED" : "FAILED", test.name);
+		failed += ok ? 0 : 1;
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+#include "mappedFile.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+#define CHECK_TRUE(X) do { \
+	if (!(X)) { \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #X); \
+		return false; \
+	} \
+} while (0)
+
+using samplesCommon::MappedFile;
+
+/* Creates a file with these contents in TMPDIR or /tmp, removed on destruction */
+class TempFile
+{
+public:
+	explicit TempFile(const std::string &contents)
+	{
+		const char *tmp = getenv("TMPDIR");
+		m_name = std::string(tmp && *tmp ? tmp : "/tmp") + "/mapped_file_test.XXXXXX";
+		const int fd = mkstemp(&m_name[0]);
+		m_ok = fd >= 0 && write(fd, contents.data(), contents.size()) == (ssize_t)contents.size();
+		if (fd >= 0)
+			close(fd);
+	}
+	~TempFile() { remove(m_name.c_str()); }
+
+	bool ok() const { return m_ok; }
+	const std::string &name() const { return m_name; }
+
+private:
+	std::string m_name;
+	bool m_ok;
+};
+
+/* msync fails with ENOMEM on a range that is no longer mapped */
+static bool isUnmapped(const void *addr, size_t size)
+{
+	return msync(const_cast<void *>(addr), size, MS_ASYNC) != 0 && errno == ENOMEM;
+}
+
+static std::string contentsOf(const MappedFile &file)
+{
+	return std::string(reinterpret_cast<const char *>(file.data()), file.size());
+}
+
+static bool testMap()
+{
+	std::string contents(3 * 4096 + 5, '\0');
+	for (size_t i = 0; i < contents.size(); i++)
+		contents[i] = (char)(i * 7);
+	TempFile temp(contents);
+	CHECK_TRUE(temp.ok());
+
+	MappedFile file;
+	CHECK_TRUE(file.open(temp.name(), MappedFile::Advice::kSEQUENTIAL));
+	CHECK_TRUE(file.isMapped());
+	CHECK_TRUE(file.size() == contents.size());
+	CHECK_TRUE(contentsOf(file) == contents);
+	CHECK_TRUE(!isUnmapped(file.data(), file.size()));
+
+	MappedFile constructed(temp.name());
+	CHECK_TRUE(constructed.isMapped() && contentsOf(constructed) == contents);
+	return true;
+}
+
+static bool testAdvice()
+{
+	const std::string contents(2 * 4096, 'a');
+	TempFile temp(contents);
+	CHECK_TRUE(temp.ok());
+
+	for (auto advice : {MappedFile::Advice::kNORMAL, MappedFile::Advice::kSEQUENTIAL, MappedFile::Advice::kRANDOM,
+			MappedFile::Advice::kWILLNEED}) {
+		MappedFile file(temp.name(), advice);
+		CHECK_TRUE(file.isMapped());
+		CHECK_TRUE(contentsOf(file) == contents);
+		/* changing the advice of a live mapping keeps its contents */
+		file.advise(MappedFile::Advice::kRANDOM);
+		file.advise(advice);
+		CHECK_TRUE(contentsOf(file) == contents);
+	}
+	/* advising an empty view does nothing */
+	MappedFile empty;
+	empty.advise(MappedFile::Advice::kWILLNEED);
+	CHECK_TRUE(empty.data() == nullptr && empty.size() == 0);
+	return true;
+}
+
+static bool testEmptyFile()
+{
+	TempFile temp("");
+	CHECK_TRUE(temp.ok());
+
+	/* mmap rejects empty ranges, an empty file is a valid empty view */
+	MappedFile file;
+	CHECK_TRUE(file.open(temp.name()));
+	CHECK_TRUE(!file.isMapped());
+	CHECK_TRUE(file.data() == nullptr && file.size() == 0);
+	return true;
+}
+
+static bool testMissingFile()
+{
+	std::string name;
+	{
+		TempFile temp("x");
+		CHECK_TRUE(temp.ok());
+		name = temp.name();
+	}
+	MappedFile file;
+	CHECK_TRUE(!file.open(name));
+	CHECK_TRUE(!file.isMapped());
+	CHECK_TRUE(file.data() == nullptr && file.size() == 0);
+
+	/* a failed open also releases the previous mapping */
+	TempFile temp("contents");
+	CHECK_TRUE(temp.ok());
+	CHECK_TRUE(file.open(temp.name()));
+	const void *addr = file.data();
+	CHECK_TRUE(!file.open(name));
+	CHECK_TRUE(file.data() == nullptr && isUnmapped(addr, 1));
+	return true;
+}
+
+static bool testUnmap()
+{
+	TempFile first("first");
+	TempFile second("second");
+	CHECK_TRUE(first.ok() && second.ok());
+
+	MappedFile file(first.name());
+	const void *addr = file.data();
+	file.close();
+	CHECK_TRUE(file.data() == nullptr && file.size() == 0 && !file.isMapped());
+	CHECK_TRUE(isUnmapped(addr, 1));
+	file.close();
+
+	/* opening another file replaces the mapping */
+	CHECK_TRUE(file.open(first.name()));
+	addr = file.data();
+	CHECK_TRUE(file.open(second.name()));
+	CHECK_TRUE(contentsOf(file) == "second");
+	CHECK_TRUE(addr == file.data() || isUnmapped(addr, 1));
+
+	/* moves transfer the mapping, which is released once, by its last owner */
+	addr = file.data();
+	{
+		MappedFile moved(std::move(file));
+		CHECK_TRUE(file.data() == nullptr && !file.isMapped());
+		CHECK_TRUE(moved.data() == addr && contentsOf(moved) == "second");
+		MappedFile assigned;
+		assigned = std::move(moved);
+		CHECK_TRUE(moved.data() == nullptr && assigned.data() == addr);
+		CHECK_TRUE(!isUnmapped(addr, 1));
+	}
+	CHECK_TRUE(isUnmapped(addr, 1));
+	return true;
+}
+
+int main()
+{
+	struct {
+		const char *name;
+		bool (*run)();
+	} tests[] = {
+		{"map", testMap},
+		{"advice", testAdvice},
+		{"empty file", testEmptyFile},
+		{"missing file", testMissingFile},
+		{"unmap", testUnmap},
+	};
+	int failed = 0;
+	for (auto &test : tests) {
+		const bool ok = test.run();
+		printf("%s %s\n", ok ? "PASSED" : "FAILED", test.name);
+		failed += ok ? 0 : 1;
+	}
+	return failed ? 1 : 0;
+}
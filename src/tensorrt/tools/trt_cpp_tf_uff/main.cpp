@@ -23,6 +23,7 @@
 using namespace nvuffparser;
 using namespace nvinfer1;
 #include "common.h"
+#include "imagePreprocess.h"
 
 static Logger gLogger;
 
@@ -257,6 +258,11 @@ void execute(ICudaEngine& engine)
 	char strLine[MAX_LINE];
 	int numberRun =0;
     int iCorrectNum = 0;
+	// Reused by every image, (x - 128) / 128
+	std::vector<float> hostInput;
+	samplesCommon::ImagePreprocessParams preprocessParams;
+	preprocessParams.scale.fill(1.0 / 128.0);
+	preprocessParams.bias.fill(-1.0);
 	while(!feof(fpOpen))
 	{
 		fgets(strLine, MAX_LINE, fpOpen);
@@ -272,8 +278,7 @@ void execute(ICudaEngine& engine)
 		cvResize(cvtimg, in_img, CV_INTER_LINEAR);
 
 
-		int _size = in_img->width * in_img->height * in_img->nChannels * sizeof(float);
-		float* hostInput = (float*)malloc(_size);
+		hostInput.resize(in_img->width * in_img->height * in_img->nChannels);
 		float tfOutput[5];
 
         
@@ -282,17 +287,10 @@ void execute(ICudaEngine& engine)
         // <<<<<<<< OpenCV 3
 
         // >>>>>>>>  OpenCV 2
-		int count=0;
         unsigned char *data = (unsigned char *)in_img->imageData;
 		// scale pixel and change HWC->CHW
-		for(int c = 0; c < in_img->nChannels; c++){
-			for(int j = 0; j < in_img->height; j++){
-				for(int i = 0; i < in_img->width; i++){
-                    // RGBRGBRGB -> RRRGGGBBB
-					hostInput[count++] = (1.0 * data[j * (in_img->widthStep) + i * (in_img->nChannels) + c] - 128.0)/128.0;
-				}
-			}
-		}
+		// RGBRGBRGB -> RRRGGGBBB
+		samplesCommon::preprocessHWC(data, in_img->height, in_img->width, in_img->widthStep, hostInput.data(), preprocessParams);
 
 
         // // DEBUG
@@ -319,7 +317,7 @@ void execute(ICudaEngine& engine)
         // <<<<<<<< OpenCV 2
 
 
-		buffers[bindingIdxInput] = createMnistCudaBuffer(bufferSizesInput.first, bufferSizesInput.second, hostInput);
+		buffers[bindingIdxInput] = createMnistCudaBuffer(bufferSizesInput.first, bufferSizesInput.second, hostInput.data());
 
         auto t_start = std::chrono::high_resolution_clock::now();
         context->execute(batchSize, &buffers[0]);
@@ -351,7 +349,6 @@ void execute(ICudaEngine& engine)
             iCorrectNum++;
         }
 
-		free(hostInput);
         cvReleaseImage(&cvtimg);
 		cvReleaseImage(&testImg);
 		cvReleaseImage(&in_img);